@@ -0,0 +1,283 @@
+/*****************************************************************************
+ * end-to-end time of optimize_DFT_w and scan_DFT_w run against mock "g16". *
+ *****************************************************************************/
+
+/*
+    Run from the top directory after "make bench", which builds the tools and the mock "g16" in the
+    bench directory. Every case runs in "bench_dft_w.tmp" with a copy of "template.gjf". The mock
+    records when each job starts and stops, so the time during which no job was running, the
+    orchestration overhead, is told apart from the time of the jobs themselves.
+*/
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <time.h>
+# ifdef _WIN32
+# include <direct.h>
+# else
+# include <unistd.h>
+# include <sys/stat.h>
+# endif
+
+# define Close_file(flp) fclose(flp); flp = NULL
+
+# ifdef _WIN32
+# define EXE_SUFFIX ".exe"
+# define DIR_SEP "\\"
+# define NULL_DEVICE "NUL"
+# define chdir _chdir
+# define rmdir _rmdir
+# else
+# define EXE_SUFFIX ".x"
+# define DIR_SEP "/"
+# define NULL_DEVICE "/dev/null"
+# endif
+
+# define WORK_DIR "bench_dft_w.tmp"
+# define RECORD_NAME "mock_g16.record"
+# define MAX_JOB 4096u
+
+/* the jobs of a run, from the record of the mock */
+typedef struct
+{
+    unsigned int num_job;
+    unsigned int num_w; /* different IOp values */
+    double job_time; /* sum of the time of all the jobs */
+    double busy_time; /* during which at least one job was running */
+} Run_record;
+
+/* one run of optimize_DFT_w or scan_DFT_w */
+typedef struct
+{
+    char const *name;
+    char const *exe; /* relative to the top directory, without suffix */
+    char const *args;
+} Bench_case;
+
+static Bench_case const bench_cases[] = {
+    {"optimize, one job at a time", "optimize_DFT_w", ""},
+    {"optimize --concurrent", "optimize_DFT_w", "--concurrent"},
+    {"optimize --concurrent --read-guess", "optimize_DFT_w", "--concurrent --read-guess"},
+    {"optimize --concurrent --speculate 2", "optimize_DFT_w", "--concurrent --speculate 2"},
+    {"optimize --concurrent --supervise", "optimize_DFT_w", "--concurrent --supervise"},
+    {"optimize --concurrent --coarse 4", "optimize_DFT_w", "--concurrent --coarse 4"},
+    {"optimize --surrogate", "optimize_DFT_w", "--surrogate"},
+    {"optimize --signed-J", "optimize_DFT_w", "--signed-J"},
+    {"optimize --link1", "optimize_DFT_w", "--link1"},
+    {"optimize --speculate 2 --link1", "optimize_DFT_w", "--speculate 2 --link1"},
+    {"optimize --low-conver 4", "optimize_DFT_w", "--low-conver 4"},
+    {"optimize --objective IP", "optimize_DFT_w", "--objective IP"},
+    {"scan --jobs 1", "scanDFTw" DIR_SEP "scan_DFT_w", "--low 0.1 --high 0.3 --stepsize 0.02 --jobs 1"},
+    {"scan --jobs 3", "scanDFTw" DIR_SEP "scan_DFT_w", "--low 0.1 --high 0.3 --stepsize 0.02 --jobs 3"},
+    {"scan --jobs 6", "scanDFTw" DIR_SEP "scan_DFT_w", "--low 0.1 --high 0.3 --stepsize 0.02 --jobs 6"},
+    {"scan --jobs 12", "scanDFTw" DIR_SEP "scan_DFT_w", "--low 0.1 --high 0.3 --stepsize 0.02 --jobs 12"},
+    {"scan --jobs 1 --link1", "scanDFTw" DIR_SEP "scan_DFT_w", "--low 0.1 --high 0.3 --stepsize 0.02 --jobs 1 --link1"},
+    {"scan --jobs 3 --link1", "scanDFTw" DIR_SEP "scan_DFT_w", "--low 0.1 --high 0.3 --stepsize 0.02 --jobs 3 --link1"}
+};
+
+static double Get_time_s()
+{
+    # ifdef TIME_UTC
+    struct timespec now;
+
+    /* the same clock as the mock, which runs in other processes */
+    timespec_get(& now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1E-9;
+    # else
+    return (double)time(NULL);
+    # endif
+}
+
+static int Set_env(char const *name, char const *value)
+{
+    # ifdef _WIN32
+    return _putenv_s(name, value);
+    # else
+    return setenv(name, value, 1);
+    # endif
+}
+
+static int Copy_file(char const *src_name, char const *dst_name)
+{
+    FILE *src_ifl = NULL, *dst_ofl = NULL;
+    char buf[BUFSIZ] = "";
+    size_t num_read = 0u;
+
+    src_ifl = fopen(src_name, "rb");
+    if (! src_ifl)
+        return 1;
+    dst_ofl = fopen(dst_name, "wb");
+    if (! dst_ofl)
+    {
+        Close_file(src_ifl);
+        return 1;
+    }
+    while ((num_read = fread(buf, 1u, BUFSIZ, src_ifl)))
+        fwrite(buf, 1u, num_read, dst_ofl);
+    Close_file(src_ifl);
+    Close_file(dst_ofl);
+
+    return 0;
+}
+
+static int Compare_doubles(void const *x1, void const *x2)
+{
+    double const *d1 = (double const *)x1, *d2 = (double const *)x2;
+
+    return (* d1 > * d2) - (* d1 < * d2);
+}
+
+static int Compare_uints(void const *x1, void const *x2)
+{
+    unsigned int const *u1 = (unsigned int const *)x1, *u2 = (unsigned int const *)x2;
+
+    return (* u1 > * u2) - (* u1 < * u2);
+}
+
+/* read what the mock recorded, intervals are merged after sorting by start time */
+static int Read_record(char const *record_name, Run_record *record)
+{
+    FILE *record_ifl = NULL;
+    static double intervals[MAX_JOB][2];
+    static unsigned int iops[MAX_JOB];
+    char out_name[BUFSIZ + 1] = "";
+    unsigned int ijob = 0u;
+    double busy_start = 0.0, busy_stop = 0.0;
+
+    memset(record, 0, sizeof(Run_record));
+    record_ifl = fopen(record_name, "rt");
+    if (! record_ifl)
+        return 0;
+    while (record->num_job < MAX_JOB && fscanf(record_ifl, "%s %u %lg %lg", out_name, & iops[record->num_job], \
+        & intervals[record->num_job][0], & intervals[record->num_job][1]) == 4)
+        ++ record->num_job;
+    Close_file(record_ifl);
+    if (! record->num_job)
+        return 0;
+
+    qsort(intervals, record->num_job, sizeof(intervals[0]), Compare_doubles);
+    busy_start = intervals[0][0];
+    busy_stop = intervals[0][1];
+    for (ijob = 0u; ijob < record->num_job; ++ ijob)
+    {
+        record->job_time += intervals[ijob][1] - intervals[ijob][0];
+        if (intervals[ijob][0] > busy_stop)
+        {
+            record->busy_time += busy_stop - busy_start;
+            busy_start = intervals[ijob][0];
+        }
+        if (intervals[ijob][1] > busy_stop)
+            busy_stop = intervals[ijob][1];
+    }
+    record->busy_time += busy_stop - busy_start;
+
+    qsort(iops, record->num_job, sizeof(unsigned int), Compare_uints);
+    for (ijob = 0u; ijob < record->num_job; ++ ijob)
+    {
+        if (! ijob || iops[ijob] != iops[ijob - 1u])
+            ++ record->num_w;
+    }
+
+    return 0;
+}
+
+int main(int argc, char const *argv[])
+{
+    unsigned int const num_case = sizeof(bench_cases) / sizeof(Bench_case);
+    unsigned int icase = 0u;
+    char top_dir[BUFSIZ + 1] = "";
+    char path[2 * BUFSIZ + 2] = "";
+    char command[4 * BUFSIZ + 4] = "";
+    char const *latency_str = "0.2";
+    char const *startup_str = "0.05";
+    double latency = 0.0, startup = 0.0, time_start = 0.0, wall_time = 0.0, wall_time_scan_1 = 0.0;
+    Run_record record;
+    int exit_status = 0, num_failed = 0;
+
+    if (argc > 3 || (argc >= 2 && sscanf(argv[1], "%lg", & latency) != 1) || \
+        (argc == 3 && sscanf(argv[2], "%lg", & startup) != 1))
+    {
+        fprintf(stderr, "Usage: %s [LATENCY_S [STARTUP_S]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc >= 2)
+        latency_str = argv[1];
+    if (argc == 3)
+        startup_str = argv[2];
+    sscanf(latency_str, "%lg", & latency);
+    sscanf(startup_str, "%lg", & startup);
+
+    /* the tools find the mock through GAUSS_EXEDIR, and it tells us about every job */
+    # ifdef _WIN32
+    if (! _getcwd(top_dir, BUFSIZ))
+    # else
+    if (! getcwd(top_dir, BUFSIZ))
+    # endif
+    {
+        fprintf(stderr, "Error! Cannot get the current directory.\n");
+        return EXIT_FAILURE;
+    }
+    sprintf(path, "%s%sbench", top_dir, DIR_SEP);
+    Set_env("GAUSS_EXEDIR", path);
+    Set_env("MOCK_G16_LATENCY", latency_str);
+    Set_env("MOCK_G16_STARTUP", startup_str);
+    sprintf(path, "%s%s%s%s%s", top_dir, DIR_SEP, WORK_DIR, DIR_SEP, RECORD_NAME);
+    Set_env("MOCK_G16_RECORD", path);
+
+    # ifdef _WIN32
+    _mkdir(WORK_DIR);
+    # else
+    mkdir(WORK_DIR, 0755);
+    # endif
+    sprintf(path, "%s%s%s%stemplate.gjf", top_dir, DIR_SEP, WORK_DIR, DIR_SEP);
+    if (Copy_file("template.gjf", path) || chdir(WORK_DIR))
+    {
+        fprintf(stderr, "Error! Cannot prepare \"%s\", run this from the top directory.\n", WORK_DIR);
+        return EXIT_FAILURE;
+    }
+
+    printf("Each SCF from scratch of the mock takes %.3lf s, and each job %.3lf s more to start.\n", latency, startup);
+    printf("\"idle\" is the time during which no Gaussian job was running, \"running\" the mean number of jobs running, \n");
+    printf("and the scans are followed by their speedup over one job at a time.\n");
+    printf("\n");
+    printf("%-38s %6s %4s %9s %9s %9s %6s %7s\n", "Case", "w run", "jobs", "wall (s)", "jobs (s)", "idle (s)", \
+        "idle%", "running");
+    for (icase = 0u; icase < num_case; ++ icase)
+    {
+        remove(RECORD_NAME);
+        remove("optimize_DFT_w.journal");
+        remove("scan_DFT_w.journal");
+        sprintf(command, "%s%s%s%s %s < %s > run.log 2>&1", top_dir, DIR_SEP, bench_cases[icase].exe, EXE_SUFFIX, \
+            bench_cases[icase].args, NULL_DEVICE);
+        time_start = Get_time_s();
+        exit_status = system(command);
+        wall_time = Get_time_s() - time_start;
+        Read_record(RECORD_NAME, & record);
+        if (! strcmp(bench_cases[icase].name, "scan --jobs 1"))
+            wall_time_scan_1 = wall_time;
+        printf("%-38s %6u %4u %9.3lf %9.3lf %9.3lf %6.1lf %7.2lf", bench_cases[icase].name, record.num_w, \
+            record.num_job, wall_time, record.job_time, wall_time - record.busy_time, \
+            (wall_time - record.busy_time) / wall_time * 1E2, record.job_time / wall_time);
+        if (wall_time_scan_1 > 0.0 && strstr(bench_cases[icase].name, "scan"))
+            printf("  x%.2lf", wall_time_scan_1 / wall_time);
+        printf("%s\n", exit_status ? "  FAILED, see " WORK_DIR DIR_SEP "run.log" : "");
+        if (exit_status)
+        {
+            ++ num_failed;
+            break;
+        }
+    }
+    remove(RECORD_NAME);
+    remove("optimize_DFT_w.journal");
+    remove("scan_DFT_w.journal");
+    if (! num_failed)
+    {
+        remove("run.log");
+        remove("template.gjf");
+        if (! chdir(".."))
+            rmdir(WORK_DIR);
+    }
+
+    return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
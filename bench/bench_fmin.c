@@ -0,0 +1,366 @@
+/*************************************************************************
+ * evaluations and rounds of waiting of the 1-d optimizers on functions *
+ * like J^2, with and without evaluating several points at the same time, *
+ * and the steps of each kind Brent's method takes on unimodal functions, *
+ * also when their minimum is out of the interval given.                  *
+ *************************************************************************/
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <math.h>
+
+# include "brent_fmin.h"
+# include "gp_fmin.h"
+
+/* J^2 = J_N^2 + J_N+1^2, each J nearly linear in w and crossing zero at its own w */
+typedef struct
+{
+    double slopes[2], zeros[2], curvatures[2];
+    unsigned int num_eval;
+    /* evaluations started but not waited for, in the order started */
+    double pendings[16];
+    unsigned int num_pending;
+} Bench_func;
+
+static double Calc_J(Bench_func const *func, unsigned int i, double w)
+{
+    return func->slopes[i] * (w - func->zeros[i]) + func->curvatures[i] * (w - func->zeros[i]) * (w - func->zeros[i]);
+}
+
+static double Calc_J_squared(Bench_func const *func, double w)
+{
+    double J = 0.0, J_squared = 0.0;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < 2u; ++ i)
+    {
+        J = Calc_J(func, i, w);
+        J_squared += J * J;
+    }
+
+    return J_squared;
+}
+
+static double F(double w, void *args)
+{
+    Bench_func *func = (Bench_func *)args;
+
+    ++ func->num_eval;
+
+    return Calc_J_squared(func, w);
+}
+
+static int R(double w, double *Js, void *args)
+{
+    Bench_func *func = (Bench_func *)args;
+
+    ++ func->num_eval;
+    Js[0] = Calc_J(func, 0u, w);
+    Js[1] = Calc_J(func, 1u, w);
+
+    return 0;
+}
+
+/* every evaluation takes the same time, so the one started first ends first */
+
+static int Start(double w, void *args)
+{
+    Bench_func *func = (Bench_func *)args;
+
+    if (func->num_pending >= sizeof(func->pendings) / sizeof(double))
+        return 1;
+    func->pendings[func->num_pending ++] = w;
+
+    return 0;
+}
+
+static int Wait_any(double *w_ptr, double *f_ptr, void *args)
+{
+    Bench_func *func = (Bench_func *)args;
+
+    if (! func->num_pending)
+        return 1;
+    * w_ptr = func->pendings[0];
+    -- func->num_pending;
+    memmove(func->pendings, func->pendings + 1, func->num_pending * sizeof(double));
+    * f_ptr = F(* w_ptr, args);
+
+    return 0;
+}
+
+static void Cancel(double w, void *args)
+{
+    Bench_func *func = (Bench_func *)args;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < func->num_pending; ++ i)
+    {
+        if (func->pendings[i] == w)
+        {
+            -- func->num_pending;
+            memmove(func->pendings + i, func->pendings + i + 1, (func->num_pending - i) * sizeof(double));
+            return;
+        }
+    }
+
+    return;
+}
+
+static double Random_uniform(double low, double high)
+{
+    return low + (high - low) * rand() / RAND_MAX;
+}
+
+/* unimodal functions of x - x_min of several shapes, on which Brent's method takes different steps */
+enum {SHAPE_QUADRATIC, SHAPE_QUARTIC, SHAPE_ABSOLUTE, SHAPE_SKEWED, NUM_SHAPE};
+
+typedef struct
+{
+    int shape;
+    double x_min, scale;
+    unsigned int num_eval;
+} Unimodal_func;
+
+static double Calc_unimodal(double x, void *args)
+{
+    Unimodal_func *func = (Unimodal_func *)args;
+    double t = func->scale * (x - func->x_min);
+
+    ++ func->num_eval;
+    switch (func->shape)
+    {
+    case SHAPE_QUADRATIC:
+        return t * t;
+    case SHAPE_QUARTIC:
+        return t * t * t * t;
+    case SHAPE_ABSOLUTE:
+        return fabs(t);
+    default:
+        return exp(t) - t;
+    }
+}
+
+/* the steps of each kind summed over the runs of Brent's method */
+typedef struct
+{
+    unsigned long num_parabolic, num_golden;
+    unsigned long nums_reject[BRENT_NUM_REJECT];
+    unsigned long num_expand;
+} Step_counts;
+
+/* a Brent_observer end adding up the steps of a run into the Step_counts args */
+static void Count_steps(Brent_state const *s, int status, void *args)
+{
+    Step_counts *counts = (Step_counts *)args;
+    unsigned int ireject = 0u;
+
+    (void)status;
+    counts->num_parabolic += s->num_parabolic;
+    counts->num_golden += s->num_golden;
+    for (ireject = 0u; ireject < BRENT_NUM_REJECT; ++ ireject)
+        counts->nums_reject[ireject] += s->nums_reject[ireject];
+    counts->num_expand += s->num_expand;
+
+    return;
+}
+
+/* Brent_fmin on num_func functions of every shape, print the steps of each kind taken on average */
+static void Bench_steps(unsigned int num_func, double x_low, double x_high, double x_guess, double tol, \
+    unsigned int max_eval)
+{
+    char const *const shape_names[NUM_SHAPE] = {"(x - m)^2", "(x - m)^4", "|x - m|", "exp(x - m) - (x - m)"};
+    Unimodal_func func;
+    Step_counts counts;
+    Brent_observer observer;
+    unsigned long num_eval = 0u;
+    unsigned int num_miss = 0u, ifunc = 0u;
+    double x_found = 0.0;
+    int ishape = 0, info = 0;
+
+    observer.step = NULL;
+    observer.end = Count_steps;
+    observer.args = & counts;
+    printf("Steps of Brent_fmin on %u unimodal functions of each shape, minimum m in [%.2lf, %.2lf]\n", num_func, \
+        x_low + 0.05, x_high - 0.05);
+    printf("%-24s %12s %10s %10s %10s %10s %10s %10s %8s\n", "shape", "evaluations", "parabolic", "golden", \
+        "too small", "no parabola", "too far", "outside", "misses");
+    for (ishape = 0; ishape < NUM_SHAPE; ++ ishape)
+    {
+        memset(& counts, 0, sizeof(Step_counts));
+        num_eval = 0u;
+        num_miss = 0u;
+        srand(1u);
+        for (ifunc = 0u; ifunc < num_func; ++ ifunc)
+        {
+            func.shape = ishape;
+            func.x_min = Random_uniform(x_low + 0.05, x_high - 0.05);
+            func.scale = Random_uniform(1.0, 10.0);
+            func.num_eval = 0u;
+            x_found = Brent_fmin(x_low, x_high, x_low, x_high, x_guess, Calc_unimodal, & func, tol, max_eval, \
+                & observer, & info);
+            num_eval += func.num_eval;
+            if (info || fabs(x_found - func.x_min) > 3.0 * tol)
+                ++ num_miss;
+        }
+        printf("%-24s %12.2lf %10.2lf %10.2lf %10.2lf %10.2lf %10.2lf %10.2lf %8u\n", shape_names[ishape], \
+            (double)num_eval / num_func, (double)counts.num_parabolic / num_func, \
+            (double)counts.num_golden / num_func, (double)counts.nums_reject[BRENT_REJECT_SMALL] / num_func, \
+            (double)counts.nums_reject[BRENT_REJECT_FLAT] / num_func, \
+            (double)counts.nums_reject[BRENT_REJECT_LARGE] / num_func, \
+            (double)counts.nums_reject[BRENT_REJECT_OUTSIDE] / num_func, num_miss);
+    }
+
+    return;
+}
+
+/*
+    Brent_fmin on num_func functions of every shape with the minimum out of [x_low, x_high], half of them below
+    down to min_x and half above up to max_x, with [x_low, x_high] kept, and expanded up to [min_x, max_x].
+*/
+static void Bench_expand(unsigned int num_func, double x_low, double x_high, double min_x, double max_x, \
+    double x_guess, double tol, unsigned int max_eval)
+{
+    Unimodal_func func;
+    Step_counts counts;
+    Brent_observer observer;
+    unsigned long num_eval = 0u;
+    unsigned int num_miss = 0u, ifunc = 0u;
+    double x_found = 0.0;
+    int is_expand = 0, info = 0;
+
+    observer.step = NULL;
+    observer.end = Count_steps;
+    observer.args = & counts;
+    printf("Brent_fmin on %u unimodal functions of each shape, minimum out of [%.2lf, %.2lf], up to [%.4lf, %.4lf]\n", \
+        num_func, x_low, x_high, min_x, max_x);
+    printf("%-24s %12s %10s %8s\n", "interval", "evaluations", "expansions", "misses");
+    for (is_expand = 0; is_expand < 2; ++ is_expand)
+    {
+        memset(& counts, 0, sizeof(Step_counts));
+        num_eval = 0u;
+        num_miss = 0u;
+        srand(1u);
+        for (ifunc = 0u; ifunc < num_func * NUM_SHAPE; ++ ifunc)
+        {
+            func.shape = (int)(ifunc % NUM_SHAPE);
+            func.x_min = ifunc % 2u ? Random_uniform(x_high + tol, max_x) : Random_uniform(min_x, x_low - tol);
+            func.scale = Random_uniform(1.0, 10.0);
+            func.num_eval = 0u;
+            x_found = Brent_fmin(x_low, x_high, is_expand ? min_x : x_low, is_expand ? max_x : x_high, x_guess, \
+                Calc_unimodal, & func, tol, max_eval, & observer, & info);
+            num_eval += func.num_eval;
+            if (info || fabs(x_found - func.x_min) > 3.0 * tol)
+                ++ num_miss;
+        }
+        printf("%-24s %12.2lf %10.2lf %8u\n", is_expand ? "expanded" : "kept", \
+            (double)num_eval / (num_func * NUM_SHAPE), (double)counts.num_expand / (num_func * NUM_SHAPE), num_miss);
+    }
+
+    return;
+}
+
+int main(int argc, char const *argv[])
+{
+    enum {BRENT, BRENT_SPECULATIVE, GP, GP_BATCH, RESIDUALS, NUM_METHOD};
+    char const *const names[NUM_METHOD] = {"Brent_fmin", "Brent_fmin_speculative", "Gp_fmin", "Gp_fmin_batch", \
+        "Brent_fmin_residuals"};
+    double const w_low = 0.05, w_high = 0.6, w_guess = 0.325, tol = 1E-4;
+    unsigned int const max_eval = 100u;
+    unsigned int num_func = 200u, num_parallel = 3u, ifunc = 0u, imethod = 0u;
+    unsigned long num_evals[NUM_METHOD], num_rounds[NUM_METHOD];
+    unsigned int num_misses[NUM_METHOD];
+    Bench_func func;
+    Brent_evaluator evaluator;
+    double w_min = 0.0, w = 0.0, w_found = 0.0;
+    unsigned int num_eval = 0u, num_round = 0u;
+    int info = 0;
+
+    if (argc > 1 && sscanf(argv[1], "%u", & num_func) != 1)
+    {
+        fprintf(stderr, "Usage: %s [NUM_FUNCTION [NUM_PARALLEL]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc > 2)
+        sscanf(argv[2], "%u", & num_parallel);
+    if (! num_func || ! num_parallel || num_parallel > 16u)
+    {
+        fprintf(stderr, "Error! NUM_FUNCTION must be positive, and NUM_PARALLEL from 1 to 16.\n");
+        return EXIT_FAILURE;
+    }
+
+    memset(num_evals, 0, sizeof(num_evals));
+    memset(num_rounds, 0, sizeof(num_rounds));
+    memset(num_misses, 0, sizeof(num_misses));
+    evaluator.max_running = num_parallel;
+    evaluator.start = Start;
+    evaluator.wait_any = Wait_any;
+    evaluator.cancel = Cancel;
+    evaluator.is_same = NULL;
+    srand(1u);
+    for (ifunc = 0u; ifunc < num_func; ++ ifunc)
+    {
+        memset(& func, 0, sizeof(Bench_func));
+        func.zeros[0] = Random_uniform(0.1, 0.55);
+        func.zeros[1] = func.zeros[0] + Random_uniform(-0.05, 0.05);
+        func.slopes[0] = Random_uniform(0.2, 1.2);
+        func.slopes[1] = Random_uniform(0.2, 1.2);
+        func.curvatures[0] = Random_uniform(-1.0, 1.0);
+        func.curvatures[1] = Random_uniform(-1.0, 1.0);
+        /* the true minimum on a grid finer than tol */
+        w_min = w_low;
+        for (w = w_low; w <= w_high; w += tol * 0.1)
+        {
+            if (Calc_J_squared(& func, w) < Calc_J_squared(& func, w_min))
+                w_min = w;
+        }
+
+        for (imethod = 0u; imethod < NUM_METHOD; ++ imethod)
+        {
+            func.num_eval = 0u;
+            func.num_pending = 0u;
+            num_round = 0u;
+            switch (imethod)
+            {
+            case BRENT:
+                w_found = Brent_fmin(w_low, w_high, w_low, w_high, w_guess, F, & func, tol, max_eval, NULL, & info);
+                num_round = func.num_eval;
+                break;
+            case BRENT_SPECULATIVE:
+                w_found = Brent_fmin_speculative(w_low, w_high, w_low, w_high, w_guess, & evaluator, & func, tol, \
+                    max_eval, NULL, & num_round, & info);
+                break;
+            case GP:
+                w_found = Gp_fmin(w_low, w_high, w_guess, F, & func, tol, max_eval, & num_eval, & info);
+                num_round = func.num_eval;
+                break;
+            case GP_BATCH:
+                w_found = Gp_fmin_batch(w_low, w_high, w_guess, & evaluator, & func, tol, max_eval, & num_eval, \
+                    & num_round, & info);
+                break;
+            default:
+                w_found = Brent_fmin_residuals(w_low, w_high, w_guess, R, 2u, & func, tol, max_eval, & num_eval, \
+                    & info);
+                num_round = func.num_eval;
+                break;
+            }
+            num_evals[imethod] += func.num_eval;
+            num_rounds[imethod] += num_round;
+            if (info || fabs(w_found - w_min) > 3.0 * tol)
+                ++ num_misses[imethod];
+        }
+    }
+
+    printf("%u functions like J^2 on [%.2lf, %.2lf], tolerance %.0e, up to %u evaluations at the same time\n", \
+        num_func, w_low, w_high, tol, num_parallel);
+    printf("%-24s %12s %12s %8s\n", "method", "evaluations", "rounds", "misses");
+    for (imethod = 0u; imethod < NUM_METHOD; ++ imethod)
+        printf("%-24s %12.2lf %12.2lf %8u\n", names[imethod], (double)num_evals[imethod] / num_func, \
+            (double)num_rounds[imethod] / num_func, num_misses[imethod]);
+    printf("\n");
+    Bench_steps(num_func, w_low, w_high, w_guess, tol, max_eval);
+    printf("\n");
+    Bench_expand(num_func, w_low, w_high, 1E-4, 9.9999, w_guess, tol, max_eval);
+
+    return EXIT_SUCCESS;
+}
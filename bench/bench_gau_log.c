@@ -0,0 +1,169 @@
+/*************************************************************************
+ * throughput of parsing large Gaussian outputs, compared with fgets(). *
+ *************************************************************************/
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <time.h>
+
+# include "gau_log.h"
+
+# define Close_file(flp) fclose(flp); flp = NULL
+
+static double Get_time_s()
+{
+    # ifdef CLOCK_MONOTONIC
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, & now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1E-9;
+    # else
+    return (double)clock() / CLOCKS_PER_SEC;
+    # endif
+}
+
+/* one SCF with its orbital energies, the values depend on iscf so that every block is different */
+static void Write_scf_block(FILE *log_ofl, unsigned int iscf)
+{
+    unsigned int iline = 0u;
+
+    fprintf(log_ofl, " SCF Done:  E(RwPBE) =  %.9lf     A.U. after   %2u cycles\n", -100.0 - iscf * 1E-3, 10u + iscf % 10u);
+    fprintf(log_ofl, " **********************************************************************\n");
+    fprintf(log_ofl, "\n            Population analysis using the SCF Density.\n\n");
+    for (iline = 0u; iline < 20u; ++ iline)
+        fprintf(log_ofl, " Alpha  occ. eigenvalues --  -19.20000 -10.30000  -1.10000  -0.70000  -0.60000\n");
+    fprintf(log_ofl, " Alpha  occ. eigenvalues --   -0.50000  -0.45000  %8.5lf\n", -0.3 - iscf * 1E-4);
+    for (iline = 0u; iline < 40u; ++ iline)
+        fprintf(log_ofl, " Alpha virt. eigenvalues --    0.05000   0.10000   0.20000   0.30000   0.40000\n");
+    fprintf(log_ofl, "          Condensed to atoms (all electrons):\n");
+
+    return;
+}
+
+/* a log of about size_mb MB, mostly "pop=full"-like matrices, with num_scf SCF blocks spread in it */
+static int Write_synthetic_log(char const *log_name, unsigned int size_mb, unsigned int num_scf)
+{
+    FILE *log_ofl = NULL;
+    unsigned long long num_byte = (unsigned long long)size_mb * 1024ull * 1024ull;
+    unsigned long long per_scf = num_byte / num_scf;
+    unsigned int iscf = 0u;
+    unsigned int irow = 0u;
+    long written = 0l;
+
+    log_ofl = fopen(log_name, "wt");
+    if (! log_ofl)
+        return 1;
+    fprintf(log_ofl, " Entering Gaussian System, Link 0=g16\n");
+    for (iscf = 0u; iscf < num_scf; ++ iscf)
+    {
+        while ((unsigned long long)(written = ftell(log_ofl)) < per_scf * iscf + per_scf)
+        {
+            for (irow = 0u; irow < 1000u; ++ irow)
+                fprintf(log_ofl, " %4u  %-2s %2s  %10.5lf %10.5lf %10.5lf %10.5lf %10.5lf\n", irow % 9999u + 1u, "C", \
+                    "1S", 0.1 * irow, -0.2, 0.3, -0.4, 0.5);
+        }
+        Write_scf_block(log_ofl, iscf);
+    }
+    fprintf(log_ofl, " Normal termination of Gaussian 16 at Fri Oct 16 20:00:00 2026.\n");
+    Close_file(log_ofl);
+
+    return 0;
+}
+
+/* what the tools did before gau_log: first "SCF Done", then ftell() on every line up to "Alpha virt." */
+static int Parse_legacy(char const *log_name, double *E_ptr, double *e_HOMO_ptr)
+{
+    FILE *ofl = NULL;
+    long last_line_pos = 0l, this_line_pos = 0l;
+    char last_value_str[BUFSIZ + 1] = "";
+    char buf[BUFSIZ + 1] = "";
+    char *tok = NULL;
+
+    ofl = fopen(log_name, "rt");
+    if (! ofl)
+        return 1;
+    while (fgets(buf, BUFSIZ, ofl))
+    {
+        if (strstr(buf, "SCF Done"))
+            break;
+    }
+    if (sscanf(strchr(buf, '=') + 1, "%lg", E_ptr) != 1)
+    {
+        Close_file(ofl);
+        return 1;
+    }
+    for (;;)
+    {
+        this_line_pos = ftell(ofl);
+        if (! fgets(buf, BUFSIZ, ofl) || strstr(buf, "Alpha virt."))
+            break;
+        last_line_pos = this_line_pos;
+    }
+    fseek(ofl, last_line_pos, SEEK_SET);
+    fgets(buf, BUFSIZ, ofl);
+    tok = strtok(buf, " \n");
+    while ((tok = strtok(NULL, " \n")))
+        strcpy(last_value_str, tok);
+    Close_file(ofl);
+
+    return sscanf(last_value_str, "%lg", e_HOMO_ptr) != 1;
+}
+
+int main(int argc, char const *argv[])
+{
+    unsigned int size_mb = 256u, num_scf = 8u, num_repeat = 5u, irepeat = 0u;
+    char const log_name[] = "bench_gau_log.tmp";
+    Gau_log_info info;
+    double E_legacy = 0.0, e_HOMO_legacy = 0.0;
+    double time_start = 0.0, time_new = 0.0, time_legacy = 0.0;
+    int error = 0;
+
+    if (argc > 1 && sscanf(argv[1], "%u", & size_mb) != 1)
+    {
+        fprintf(stderr, "Usage: %s [SIZE_MB [NUM_SCF [NUM_REPEAT]]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc > 2)
+        sscanf(argv[2], "%u", & num_scf);
+    if (argc > 3)
+        sscanf(argv[3], "%u", & num_repeat);
+    if (! size_mb || ! num_scf || ! num_repeat)
+    {
+        fprintf(stderr, "Error! All arguments must be positive.\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("Writing a synthetic log of %u MB with %u SCF blocks ...\n", size_mb, num_scf);
+    if (Write_synthetic_log(log_name, size_mb, num_scf))
+    {
+        fprintf(stderr, "Error! Cannot write \"%s\".\n", log_name);
+        return EXIT_FAILURE;
+    }
+
+    /* warm up the page cache, so both read from memory */
+    Parse_legacy(log_name, & E_legacy, & e_HOMO_legacy);
+
+    time_start = Get_time_s();
+    for (irepeat = 0u; irepeat < num_repeat; ++ irepeat)
+        error = Parse_gau_log(log_name, & info);
+    time_new = (Get_time_s() - time_start) / num_repeat;
+    time_start = Get_time_s();
+    for (irepeat = 0u; irepeat < num_repeat; ++ irepeat)
+        Parse_legacy(log_name, & E_legacy, & e_HOMO_legacy);
+    time_legacy = (Get_time_s() - time_start) / num_repeat;
+    remove(log_name);
+
+    if (error)
+    {
+        fprintf(stderr, "Error! Parse_gau_log failed: %s.\n", Gau_log_error_string(error));
+        return EXIT_FAILURE;
+    }
+    printf("gau_log: %10.3lf ms, %12.1lf MB/s, E = %.9lf, e_HOMO = %.5lf, %u cycles\n", time_new * 1E3, \
+        size_mb / time_new, info.E_scf, info.e_HOMO_alpha, info.num_scf_cycle);
+    printf("fgets:   %10.3lf ms, %12.1lf MB/s, E = %.9lf, e_HOMO = %.5lf (first SCF block)\n", time_legacy * 1E3, \
+        size_mb / time_legacy, E_legacy, e_HOMO_legacy);
+    printf("Speedup: %.1lf\n", time_legacy / time_new);
+
+    return EXIT_SUCCESS;
+}
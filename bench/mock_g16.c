@@ -0,0 +1,291 @@
+/****************************************************************************
+ * a stand-in for "g16" writing outputs from an analytic J(w), for benches. *
+ ****************************************************************************/
+
+/*
+    Usage: g16 INPUT_FILE OUTPUT_FILE, the way optimize_DFT_w and scan_DFT_w run Gaussian.
+    Put the directory of it in GAUSS_EXEDIR. Environment variables:
+        MOCK_G16_LATENCY  seconds taken by an SCF from scratch, 0.1 by default. An SCF reading its guess
+                          from an existing "%OldChk" (or "%Chk" without "%OldChk") takes less than half of it.
+        MOCK_G16_STARTUP  seconds taken by starting Gaussian, once for every job, 0 by default.
+        MOCK_G16_W_OPT    w at which J of the neutral molecule vanishes, 0.2 by default.
+        MOCK_G16_RECORD   a file to which every job appends "OUTPUT_FILE IOP START STOP" (seconds since epoch),
+                          with IOP of its first step.
+    The steps of an input chained by "--Link1--" run one after another in the same job.
+    "SCF=Conver=N" (3 <= N < 8) in the route section takes N + 6 cycles from scratch and N - 2 from a guess,
+    instead of as many as for N = 8.
+*/
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <math.h>
+# include <time.h>
+# ifdef _WIN32
+# include <windows.h>
+# else
+# include <unistd.h>
+# endif
+
+# define Close_file(flp) fclose(flp); flp = NULL
+
+/* SCF cycles from scratch and from a guess read */
+# define NUM_CYCLE_SCRATCH 14u
+# define NUM_CYCLE_GUESS 6u
+
+/* the model: E(q, w) = E_0 + (IP_0 + dIP_dw * w) * q + U * q * (q - 1) / 2 for charge q */
+# define MODEL_E_0 -114.50000
+# define MODEL_IP_0 0.40000
+# define MODEL_DIP_DW 0.10000
+# define MODEL_U 0.35000
+/* J of charge q is SLOPE * (w - (w_opt - W_SHIFT * q)), so J_N and J_N+1 vanish at different w */
+# define MODEL_SLOPE 0.50000
+# define MODEL_W_SHIFT 0.05000
+
+/* what a step of the input asks for */
+typedef struct
+{
+    char chk_name[BUFSIZ + 1], old_chk_name[BUFSIZ + 1];
+    unsigned int iop, multi;
+    unsigned int scf_conver; /* 0 for as by default */
+    int charge;
+    int is_guess_read;
+} Mock_step;
+
+static double Get_wall_time_s()
+{
+    # ifdef TIME_UTC
+    struct timespec now;
+
+    timespec_get(& now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1E-9;
+    # else
+    return (double)time(NULL);
+    # endif
+}
+
+static void Sleep_s(double seconds)
+{
+    if (seconds <= 0.0)
+        return;
+    # ifdef _WIN32
+    Sleep((DWORD)(seconds * 1E3));
+    # else
+    usleep((useconds_t)(seconds * 1E6));
+    # endif
+
+    return;
+}
+
+static double Get_env_double(char const *name, double default_value)
+{
+    char const *value_str = getenv(name);
+    double value = default_value;
+
+    if (! value_str || sscanf(value_str, "%lg", & value) != 1)
+        return default_value;
+
+    return value;
+}
+
+static double Model_E(int charge, double w)
+{
+    return MODEL_E_0 + (MODEL_IP_0 + MODEL_DIP_DW * w) * charge + MODEL_U * charge * (charge - 1) / 2.0;
+}
+
+/* so that e_HOMO + E(q + 1) - E(q) is J of charge q */
+static double Model_e_HOMO(int charge, double w, double w_opt)
+{
+    return - (Model_E(charge + 1, w) - Model_E(charge, w)) + MODEL_SLOPE * (w - (w_opt - MODEL_W_SHIFT * charge));
+}
+
+/* eigenvalues of a spin like Gaussian does, five on each line, the last occupied one is e_HOMO */
+static void Write_eigen_block(FILE *out_ofl, char const *spin, double e_HOMO, double gap)
+{
+    double const core_eigens[] = {-19.25000, -10.31000, -1.12000, -0.68000, -0.55000, -0.52000, -0.45000};
+    unsigned int const num_core = sizeof(core_eigens) / sizeof(double);
+    unsigned int ieigen = 0u, num_virt = 12u;
+
+    fprintf(out_ofl, " %s  occ. eigenvalues -- ", spin);
+    for (ieigen = 0u; ieigen < num_core; ++ ieigen)
+    {
+        if (ieigen && ! (ieigen % 5u))
+            fprintf(out_ofl, "\n %s  occ. eigenvalues -- ", spin);
+        fprintf(out_ofl, "%10.5lf", core_eigens[ieigen]);
+    }
+    if (! (num_core % 5u))
+        fprintf(out_ofl, "\n %s  occ. eigenvalues -- ", spin);
+    fprintf(out_ofl, "%10.5lf\n", e_HOMO);
+    for (ieigen = 0u; ieigen < num_virt; ++ ieigen)
+    {
+        if (! (ieigen % 5u))
+            fprintf(out_ofl, "%s %s virt. eigenvalues -- ", ieigen ? "\n" : "", spin);
+        fprintf(out_ofl, "%10.5lf", e_HOMO + gap + 0.15 * ieigen);
+    }
+    fprintf(out_ofl, "\n");
+
+    return;
+}
+
+static int Is_file(char const *file_name)
+{
+    FILE *ifl = fopen(file_name, "rb");
+
+    if (! ifl)
+        return 0;
+    Close_file(ifl);
+
+    return 1;
+}
+
+/*
+    Read the next step of the input up to "--Link1--": Link 0, route, title, then charge and multiplicity.
+    Returns 1 if it is read, 0 if the input ends before it, and -1 if it is incomplete.
+*/
+static int Read_step(FILE *gjf_ifl, char const *gjf_name, Mock_step *step)
+{
+    char line[BUFSIZ + 1] = "";
+    char *pos = NULL;
+    unsigned int num_blank = 0u;
+    int has_line = 0, has_iop = 0, has_charge = 0;
+
+    memset(step, 0, sizeof(Mock_step));
+    step->multi = 1u;
+    while (fgets(line, BUFSIZ + 1, gjf_ifl))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (! strcmp(line, "--Link1--"))
+            break;
+        has_line = 1;
+        if (! num_blank && ! strncmp(line, "%Chk=", 5u))
+            strncpy(step->chk_name, line + 5, BUFSIZ);
+        else if (! num_blank && ! strncmp(line, "%OldChk=", 8u))
+            strncpy(step->old_chk_name, line + 8, BUFSIZ);
+        else if (! num_blank)
+        {
+            if ((pos = strstr(line, "IOp(3/107=")) && sscanf(pos + 10, "%5u", & step->iop) == 1)
+                has_iop = 1;
+            if (strstr(line, "Guess=Read"))
+                step->is_guess_read = 1;
+            if ((pos = strstr(line, "SCF=Conver=")))
+                sscanf(pos + 11, "%u", & step->scf_conver);
+        }
+        if (! * line)
+            ++ num_blank;
+        else if (num_blank == 2u && ! has_charge && sscanf(line, "%d %u", & step->charge, & step->multi) == 2)
+            has_charge = 1;
+    }
+    if (! has_line)
+        return 0;
+    if (! has_iop || ! has_charge)
+    {
+        fprintf(stderr, "Error! Cannot find %s in \"%s\".\n", has_iop ? "charge and multiplicity" : "IOp(3/107)", \
+            gjf_name);
+        return -1;
+    }
+
+    return 1;
+}
+
+/* write the output of step as the SCF goes, for those following it, and its checkpoint file at the end */
+static void Run_step(FILE *out_ofl, Mock_step const *step, double latency, double w_opt)
+{
+    FILE *chk_ofl = NULL;
+    unsigned int num_cycle = NUM_CYCLE_SCRATCH, icycle = 0u;
+    double w = step->iop * 1E-4;
+    double E = Model_E(step->charge, w), e_HOMO = Model_e_HOMO(step->charge, w, w_opt);
+
+    if (step->is_guess_read && (* step->old_chk_name ? Is_file(step->old_chk_name) : \
+        * step->chk_name && Is_file(step->chk_name)))
+        num_cycle = NUM_CYCLE_GUESS;
+    if (step->scf_conver && step->scf_conver < 8u)
+        num_cycle -= 8u - (step->scf_conver > 3u ? step->scf_conver : 3u);
+    fprintf(out_ofl, " Charge = %2d Multiplicity = %u\n", step->charge, step->multi);
+    fflush(out_ofl);
+    for (icycle = 1u; icycle <= num_cycle; ++ icycle)
+    {
+        Sleep_s(latency / NUM_CYCLE_SCRATCH);
+        fprintf(out_ofl, " Cycle %3u  Pass 1  IDiag  1:\n", icycle);
+        fprintf(out_ofl, " E= %.12lf     Delta-E= %19.12lf Rises=F Damp=F\n", \
+            E + pow(10.0, - (double)icycle), - 9.0 * pow(10.0, - (double)icycle));
+        fflush(out_ofl);
+    }
+    fprintf(out_ofl, " SCF Done:  E(RwPBE) =  %.9lf     A.U. after %3u cycles\n", E, num_cycle);
+    fprintf(out_ofl, " **********************************************************************\n");
+    fprintf(out_ofl, "\n            Population analysis using the SCF Density.\n\n");
+    fprintf(out_ofl, " Orbital symmetries:\n");
+    Write_eigen_block(out_ofl, "Alpha", e_HOMO, 0.30);
+    if (step->multi > 1u)
+        Write_eigen_block(out_ofl, "Beta", e_HOMO - 0.05, 0.25);
+    fprintf(out_ofl, "          Condensed to atoms (all electrons):\n");
+    fprintf(out_ofl, " Normal termination of Gaussian 16 (mock).\n");
+    fflush(out_ofl);
+
+    if (* step->chk_name && (chk_ofl = fopen(step->chk_name, "wb")))
+    {
+        fprintf(chk_ofl, "mock checkpoint, w = %6.4lf\n", w);
+        Close_file(chk_ofl);
+    }
+
+    return;
+}
+
+int main(int argc, char const *argv[])
+{
+    FILE *gjf_ifl = NULL, *out_ofl = NULL, *record_ofl = NULL;
+    char const *record_name = getenv("MOCK_G16_RECORD");
+    Mock_step step;
+    unsigned int first_iop = 0u, num_step = 0u;
+    int is_read = 0;
+    double latency = Get_env_double("MOCK_G16_LATENCY", 0.1);
+    double startup = Get_env_double("MOCK_G16_STARTUP", 0.0);
+    double w_opt = Get_env_double("MOCK_G16_W_OPT", 0.2);
+    double time_start = Get_wall_time_s();
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s INPUT_FILE OUTPUT_FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    gjf_ifl = fopen(argv[1], "rt");
+    if (! gjf_ifl)
+    {
+        fprintf(stderr, "Error! Cannot open \"%s\".\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    out_ofl = fopen(argv[2], "wt");
+    if (! out_ofl)
+    {
+        fprintf(stderr, "Error! Cannot open \"%s\" for writing.\n", argv[2]);
+        Close_file(gjf_ifl);
+        return EXIT_FAILURE;
+    }
+    Sleep_s(startup);
+    fprintf(out_ofl, " Entering Gaussian System, Link 0=g16 (mock)\n");
+    fprintf(out_ofl, " Input=%s\n Output=%s\n", argv[1], argv[2]);
+    while ((is_read = Read_step(gjf_ifl, argv[1], & step)) > 0)
+    {
+        if (! num_step ++)
+            first_iop = step.iop;
+        Run_step(out_ofl, & step, latency, w_opt);
+    }
+    Close_file(gjf_ifl);
+    if (is_read < 0 || ! num_step)
+    {
+        if (! num_step)
+            fprintf(stderr, "Error! Cannot find IOp(3/107) in \"%s\".\n", argv[1]);
+        fprintf(out_ofl, " Error termination of Gaussian 16 (mock).\n");
+        Close_file(out_ofl);
+        return EXIT_FAILURE;
+    }
+    Close_file(out_ofl);
+
+    if (record_name && * record_name && (record_ofl = fopen(record_name, "at")))
+    {
+        fprintf(record_ofl, "%s %05u %.6lf %.6lf\n", argv[2], first_iop, time_start, Get_wall_time_s());
+        Close_file(record_ofl);
+    }
+
+    return EXIT_SUCCESS;
+}
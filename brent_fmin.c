@@ -4,6 +4,8 @@
 # include "brent_fmin.h"
 # include <math.h>
 # include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
 
 /***********************************************************************
  * Taken from R ver 3.2.2
@@ -32,6 +34,496 @@
  */
 
 
+static void Reset_state(Brent_state *s, double ax, double bx, double guessx, double tol)
+{
+    /*  eps is approximately the square root of the relative machine precision. */
+    s->eps = sqrt(__DBL_EPSILON__);
+    s->a = ax;
+    s->b = bx;
+    s->ax = s->min_x = ax;
+    s->bx = s->max_x = bx;
+    s->num_expand = 0u;
+    s->is_expanded = 0;
+    /* v = a + c * (b - a); */
+    s->v = guessx;
+    s->w = s->v;
+    s->x = s->v;
+    s->d = 0.; /* -Wall */
+    s->e = 0.;
+    s->fx = 0.;
+    s->fv = 0.;
+    s->fw = 0.;
+    s->tol3 = tol / 3.;
+    s->u = guessx;
+    s->step = BRENT_STEP_GUESS;
+    s->reject = BRENT_REJECT_NONE;
+    s->tol1 = 0.;
+    s->num_iter = 0u;
+    s->max_iter = 0u;
+    s->is_started = 0;
+    s->num_golden = 0u;
+    s->num_parabolic = 0u;
+    memset(s->nums_reject, 0, sizeof(s->nums_reject));
+    s->observer = NULL;
+
+    return;
+}
+
+/*
+    The next point to evaluate f at, returns 1 if x has converged and there is none.
+    With is_golden, a golden-section step is taken even if the parabola could be used.
+    The kind of the step and why it is not parabolic are kept in s, and counted.
+*/
+static int Next_step(Brent_state *s, double *u_ptr, int is_golden)
+{
+    /*  c is the squared inverse of the golden ratio */
+    const double c = (3. - sqrt(5.)) * .5; /* 1 - 0.618... */
+
+    double p, q, r, u, xm, tol1, t2;
+    int reject = BRENT_REJECT_SMALL;
+
+    xm = (s->a + s->b) * .5;
+    tol1 = s->eps * fabs(s->x) + s->tol3;
+    t2 = tol1 * 2.;
+    s->tol1 = tol1;
+
+    /* check stopping criterion */
+
+    if (fabs(s->x - xm) <= t2 - (s->b - s->a) * .5)
+        return 1;
+    p = 0.;
+    q = 0.;
+    r = 0.;
+    if (fabs(s->e) > tol1)
+    {
+        /* fit parabola */
+        r = (s->x - s->w) * (s->fx - s->fv);
+        q = (s->x - s->v) * (s->fx - s->fw);
+        p = (s->x - s->v) * q - (s->x - s->w) * r;
+        q = (q - r) * 2.;
+        if (q > 0.)
+            p = -p;
+        else
+            q = -q;
+        r = s->e;
+        s->e = s->d;
+        reject = BRENT_REJECT_NONE;
+    }
+    if (is_golden)
+        reject = BRENT_REJECT_FORCED;
+    else if (reject == BRENT_REJECT_NONE && q == 0.)
+        reject = BRENT_REJECT_FLAT;
+    else if (reject == BRENT_REJECT_NONE && fabs(p) >= fabs(q * .5 * r))
+        reject = BRENT_REJECT_LARGE;
+    else if (reject == BRENT_REJECT_NONE && (p <= q * (s->a - s->x) || p >= q * (s->b - s->x)))
+        reject = BRENT_REJECT_OUTSIDE;
+    s->reject = reject;
+
+    if (reject != BRENT_REJECT_NONE)
+    {
+        /* a golden-section step */
+        if (s->x < xm)
+            s->e = s->b - s->x;
+        else
+            s->e = s->a - s->x;
+        s->d = c * s->e;
+        s->step = BRENT_STEP_GOLDEN;
+        ++ s->num_golden;
+        ++ s->nums_reject[reject];
+    }
+    else
+    {
+        /* a parabolic-interpolation step */
+        s->d = p / q;
+        s->step = BRENT_STEP_PARABOLIC;
+        ++ s->num_parabolic;
+        u = s->x + s->d;
+        /* f must not be evaluated too close to ax or bx */
+        if (u - s->a < t2 || s->b - u < t2)
+        {
+            s->d = tol1;
+            if (s->x >= xm)
+                s->d = -s->d;
+        }
+    }
+
+    /* f must not be evaluated too close to x */
+
+    if (fabs(s->d) >= tol1)
+        * u_ptr = s->x + s->d;
+    else if (s->d > 0.)
+        * u_ptr = s->x + tol1;
+    else
+        * u_ptr = s->x - tol1;
+
+    return 0;
+}
+
+/*  update  a, b, v, w, and x with fu = f(u) */
+static void Update_state(Brent_state *s, double u, double fu)
+{
+    if (fu <= s->fx)
+    {
+        if (u < s->x)
+            s->b = s->x;
+        else
+            s->a = s->x;
+        s->v = s->w;
+        s->w = s->x;
+        s->x = u;
+        s->fv = s->fw;
+        s->fw = s->fx;
+        s->fx = fu;
+    }
+    else
+    {
+        if (u < s->x)
+            s->a = u;
+        else
+            s->b = u;
+        if (fu <= s->fw || s->w == s->x)
+        {
+            s->v = s->w;
+            s->fv = s->fw;
+            s->w = u;
+            s->fw = fu;
+        }
+        else if (fu <= s->fv || s->v == s->x || s->v == s->w)
+        {
+            s->v = u;
+            s->fv = fu;
+        }
+    }
+
+    return;
+}
+
+/*
+    Whether the minimum seems to lie beyond the end of [ax, bx] given by edge, -1 for ax and 1 for bx:
+    x is within 4 * tol1 of it and better than some other point, or the parabola through x, w and v,
+    all on the other side of x, has no minimum or has it beyond the end, i.e. f keeps falling toward the end.
+    A guess at the end alone tells nothing about where f falls.
+*/
+static int Is_beyond_end(Brent_state const *s, int edge, double tol1)
+{
+    double end = edge < 0 ? s->ax : s->bx;
+    double slope = 0., curvature = 0.;
+
+    if (s->w != s->x && fabs(s->x - end) <= 4. * tol1)
+        return 1;
+    if (s->x == s->w || s->x == s->v || s->w == s->v || (s->w - s->x) * edge > 0. || (s->v - s->x) * edge > 0.)
+        return 0;
+    /* f(t) = fx + slope * (t - x) + curvature * (t - x) * (t - w) */
+    slope = (s->fw - s->fx) / (s->w - s->x);
+    curvature = ((s->fv - s->fx) / (s->v - s->x) - slope) / (s->v - s->w);
+    if (curvature <= 0.)
+        return 1;
+
+    return ((s->x + s->w) * .5 - slope / (curvature * 2.) - end) * edge >= 0.;
+}
+
+/*
+    The end of [ax, bx] beyond which the minimum seems to lie (see Is_beyond_end), -1 for ax, 1 for bx,
+    and 0 for neither. Only an end where no point is known to be worse than x yet, and where [ax, bx]
+    can still be expanded, is taken. Both ends are looked at every step.
+*/
+static int Find_edge(Brent_state const *s)
+{
+    double tol1 = s->eps * fabs(s->x) + s->tol3;
+    int is_beyond_a = 0, is_beyond_b = 0;
+
+    if (! s->is_started)
+        return 0;
+    is_beyond_a = s->a == s->ax && s->ax > s->min_x && Is_beyond_end(s, -1, tol1);
+    is_beyond_b = s->b == s->bx && s->bx < s->max_x && Is_beyond_end(s, 1, tol1);
+    if (is_beyond_a && is_beyond_b)
+    {
+        /* only when [ax, bx] is within 8 * tol1, then toward where f falls from x to w, or the nearer end */
+        if (s->w == s->x || s->fw == s->fx)
+            return s->x - s->ax < s->bx - s->x ? -1 : 1;
+        return (s->fw - s->fx) * (s->w - s->x) > 0. ? -1 : 1;
+    }
+
+    return is_beyond_a ? -1 : (is_beyond_b ? 1 : 0);
+}
+
+/*
+    Move the end of [ax, bx] given by Find_edge twice as far as [ax, bx] is wide, at most to min_x or max_x.
+    The other end of the interval of uncertainty is kept, and x, w and v are reused, as in Brent_init_known.
+*/
+static void Expand_interval(Brent_state *s, int edge)
+{
+    double width = s->bx - s->ax;
+
+    /* the minimum is known to be before the other end, so it is never expanded again */
+    if (edge < 0)
+    {
+        s->ax = s->a = s->ax - width * 2. > s->min_x ? s->ax - width * 2. : s->min_x;
+        s->bx = s->max_x = s->b;
+    }
+    else
+    {
+        s->bx = s->b = s->bx + width * 2. < s->max_x ? s->bx + width * 2. : s->max_x;
+        s->ax = s->min_x = s->a;
+    }
+    /* a parabola is tried at once, as in Brent_init_known */
+    s->e = s->d = s->b - s->a;
+    ++ s->num_expand;
+
+    return;
+}
+
+/* choose the next point s->u, after expanding [ax, bx] if the minimum seems beyond an end, returns 1 if converged */
+static int Take_step(Brent_state *s)
+{
+    int edge = Find_edge(s);
+
+    s->is_expanded = edge != 0;
+    if (edge)
+        Expand_interval(s, edge);
+
+    return Next_step(s, & s->u, 0);
+}
+
+/* tell the observer of s about the step just taken */
+static void Observe_step(Brent_state const *s)
+{
+    if (s->observer && s->observer->step)
+        (* s->observer->step)(s, s->observer->args);
+
+    return;
+}
+
+/* tell the observer of s that it stops with status, and return status */
+static int Observe_end(Brent_state const *s, int status)
+{
+    if (s->observer && s->observer->end)
+        (* s->observer->end)(s, status, s->observer->args);
+
+    return status;
+}
+
+/*
+    Start minimizing f on [ax, bx] from guessx, f is to be evaluated at * x_ptr first.
+    observer is told about every step after it, NULL for none.
+    Returns 0 on success, and 1 for illegal arguments.
+*/
+int Brent_init(Brent_state *s, double ax, double bx, double guessx, double tol, unsigned int max_iter, \
+    Brent_observer const *observer, double *x_ptr)
+{
+    if (bx <= ax || guessx < ax || guessx > bx)
+    {
+        fprintf(stderr, "Error! There must be ax <= guessx <= bx (cannot be equal together).\n");
+        return 1;
+    }
+    Reset_state(s, ax, bx, guessx, tol);
+    s->max_iter = max_iter;
+    s->observer = observer;
+    * x_ptr = s->u;
+
+    return 0;
+}
+
+/*
+    Start minimizing f on [ax, bx] from the values fxs already known at the num_known points xs, e.g. from a scan,
+    those out of [ax, bx] are ignored, and the ends are used as well. The best one becomes x, the next two w and v,
+    so that the first step can already be parabolic. observer is told about every step, NULL for none.
+    Returns BRENT_CONTINUE if f is to be evaluated at * x_ptr, BRENT_CONVERGED if [ax, bx] is narrow enough and
+    * x_ptr is the best point, or BRENT_ILLEGAL for illegal arguments.
+*/
+int Brent_init_known(Brent_state *s, double ax, double bx, double const *xs, double const *fxs, \
+    unsigned int num_known, double tol, unsigned int max_iter, Brent_observer const *observer, double *x_ptr)
+{
+    unsigned int iknown = 0u;
+    unsigned int num_inside = 0u;
+
+    if (bx <= ax)
+    {
+        fprintf(stderr, "Error! There must be ax < bx.\n");
+        return BRENT_ILLEGAL;
+    }
+    Reset_state(s, ax, bx, ax, tol);
+    s->max_iter = max_iter;
+    s->observer = observer;
+    for (iknown = 0u; iknown < num_known; ++ iknown)
+    {
+        if (xs[iknown] < ax || xs[iknown] > bx)
+            continue;
+        if (! num_inside)
+        {
+            s->x = s->w = s->v = xs[iknown];
+            s->fx = s->fw = s->fv = fxs[iknown];
+        }
+        else if (fxs[iknown] < s->fx)
+        {
+            s->v = s->w;
+            s->fv = s->fw;
+            s->w = s->x;
+            s->fw = s->fx;
+            s->x = xs[iknown];
+            s->fx = fxs[iknown];
+        }
+        else if (fxs[iknown] < s->fw || s->w == s->x)
+        {
+            s->v = s->w;
+            s->fv = s->fw;
+            s->w = xs[iknown];
+            s->fw = fxs[iknown];
+        }
+        else if (fxs[iknown] < s->fv || s->v == s->w)
+        {
+            s->v = xs[iknown];
+            s->fv = fxs[iknown];
+        }
+        ++ num_inside;
+    }
+    if (! num_inside)
+    {
+        fprintf(stderr, "Error! No point known in [ax, bx].\n");
+        return BRENT_ILLEGAL;
+    }
+    s->is_started = 1;
+    /* as if the steps before were as large as the whole interval, so a parabola is tried at once */
+    s->e = s->d = bx - ax;
+    * x_ptr = s->x;
+    ++ s->num_iter;
+    if (Next_step(s, & s->u, 0))
+        return Observe_end(s, BRENT_CONVERGED);
+    * x_ptr = s->u;
+    Observe_step(s);
+
+    return BRENT_CONTINUE;
+}
+
+/*
+    Let [ax, bx] given to Brent_init or Brent_init_known grow up to [min_x, max_x], when the minimum seems to lie
+    beyond ax or bx: x converges within 4 * tol1 of it, or the parabola through the best three points has no minimum,
+    or has it beyond it. That end is moved twice as far as the interval is wide each time, and the points known are
+    reused. To be called right after Brent_init or Brent_init_known, returns 0 on success, 1 for illegal arguments.
+*/
+int Brent_set_limits(Brent_state *s, double min_x, double max_x)
+{
+    if (min_x > s->ax || max_x < s->bx)
+    {
+        fprintf(stderr, "Error! There must be min_x <= ax < bx <= max_x.\n");
+        return 1;
+    }
+    s->min_x = min_x;
+    s->max_x = max_x;
+
+    return 0;
+}
+
+/*
+    Give f at the abscissa asked for last time, and get the next one in * x_ptr.
+    Returns BRENT_CONTINUE if f is to be evaluated at * x_ptr, otherwise BRENT_CONVERGED or
+    BRENT_NOT_CONVERGED, and * x_ptr is the best abscissa found then.
+*/
+int Brent_tell(Brent_state *s, double fu, double *x_ptr)
+{
+    if (! s->is_started)
+    {
+        s->fx = fu;
+        s->fv = fu;
+        s->fw = fu;
+        s->is_started = 1;
+    }
+    else
+        Update_state(s, s->u, fu);
+    * x_ptr = s->x;
+    if (s->num_iter > s->max_iter)
+        return Observe_end(s, BRENT_NOT_CONVERGED);
+    ++ s->num_iter;
+    /* as Brent_fmin always did, converging only at the check after the last step does not count */
+    if (Take_step(s))
+        return Observe_end(s, s->num_iter > s->max_iter ? BRENT_NOT_CONVERGED : BRENT_CONVERGED);
+    * x_ptr = s->u;
+    Observe_step(s);
+
+    return BRENT_CONTINUE;
+}
+
+/*
+    Write the state into buf of size bytes as a single line of text, the doubles are written with
+    17 significant digits so that they are read back exactly. Returns 0 on success.
+*/
+int Brent_serialize(Brent_state const *s, char *buf, size_t size)
+{
+    int len = snprintf(buf, size, "brent %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g " \
+        "%.17g %d %u %u %d %.17g %.17g %.17g %.17g %u %d", s->a, s->b, s->d, s->e, s->v, s->w, s->x, s->fv, s->fw, \
+        s->fx, s->eps, s->tol3, s->u, s->step, s->num_iter, s->max_iter, s->is_started, s->ax, s->bx, s->min_x, \
+        s->max_x, s->num_expand, s->is_expanded);
+
+    return len < 0 || (size_t)len >= size;
+}
+
+/* read back what Brent_serialize wrote, returns 0 on success. The counts of steps start again, with no observer. */
+int Brent_deserialize(Brent_state *s, char const *buf)
+{
+    Brent_state read;
+
+    memset(& read, 0, sizeof(Brent_state));
+    if (sscanf(buf, "brent %lg %lg %lg %lg %lg %lg %lg %lg %lg %lg %lg %lg %lg %d %u %u %d %lg %lg %lg %lg %u %d", \
+        & read.a, & read.b, & read.d, & read.e, & read.v, & read.w, & read.x, & read.fv, & read.fw, & read.fx, \
+        & read.eps, & read.tol3, & read.u, & read.step, & read.num_iter, & read.max_iter, & read.is_started, \
+        & read.ax, & read.bx, & read.min_x, & read.max_x, & read.num_expand, & read.is_expanded) != 23)
+        return 1;
+    * s = read;
+
+    return 0;
+}
+
+/* for printing the reasons of golden-section steps, by BRENT_REJECT_* */
+static char const *const reject_reasons[BRENT_NUM_REJECT] = {"", "the steps before were too small for a parabola", \
+    "no parabola went through the points", "the parabola stepped too far", "the parabola stepped out of the interval", \
+    "asked for"};
+
+/* a Brent_observer step printing one line about every step into the FILE * args */
+void Brent_print_step(Brent_state const *s, void *args)
+{
+    FILE *ofl = (FILE *)args;
+
+    fprintf(ofl, "Brent's step %u: ", s->num_iter);
+    if (s->is_expanded)
+        fprintf(ofl, "after expanding the interval to [%.6lg, %.6lg], ", s->ax, s->bx);
+    if (s->step == BRENT_STEP_PARABOLIC)
+        fprintf(ofl, "parabolic");
+    else
+        fprintf(ofl, "golden-section (%s)", reject_reasons[s->reject]);
+    fprintf(ofl, " to %.6lg, best %.6lg with f = %.6lg, interval [%.6lg, %.6lg] of width %.3lg, tol1 = %.3lg\n", \
+        s->u, s->x, s->fx, s->a, s->b, s->b - s->a, s->tol1);
+
+    return;
+}
+
+/* a Brent_observer end printing how many steps of each kind were taken, and why, into the FILE * args */
+void Brent_print_summary(Brent_state const *s, int status, void *args)
+{
+    FILE *ofl = (FILE *)args;
+    unsigned int ireject = 0u;
+    char const *separator = " (";
+
+    fprintf(ofl, "Brent's method %s after %u steps, %u parabolic and %u golden-section", \
+        status == BRENT_CONVERGED ? "converged" : "did not converge", s->num_parabolic + s->num_golden, \
+        s->num_parabolic, s->num_golden);
+    for (ireject = BRENT_REJECT_NONE + 1; ireject < BRENT_NUM_REJECT; ++ ireject)
+    {
+        if (! s->nums_reject[ireject])
+            continue;
+        fprintf(ofl, "%s%u as %s", separator, s->nums_reject[ireject], reject_reasons[ireject]);
+        separator = ", ";
+    }
+    fprintf(ofl, "%s", s->num_golden ? ")" : "");
+    if (s->num_expand)
+        fprintf(ofl, ", expanding the interval %u time%s to [%.6lg, %.6lg]", s->num_expand, \
+            s->num_expand > 1u ? "s" : "", s->ax, s->bx);
+    fprintf(ofl, ".\n");
+    fprintf(ofl, "The best is %.6lg with f = %.6lg, in the interval [%.6lg, %.6lg] of width %.3lg, tol1 = %.3lg.\n", \
+        s->x, s->fx, s->a, s->b, s->b - s->a, s->tol1);
+
+    return;
+}
+
 /* fmin.f -- translated by f2c (version 19990503).
 */
 
@@ -49,6 +541,9 @@
           in the interval  (ax,bx)
     tol   desired length of the interval of uncertainty of the final
           result ( >= 0.)
+    min_x, max_x  how far [ax, bx] may grow if the minimum seems beyond an end (see Brent_set_limits),
+          ax and bx for never
+    observer  told about every step and the end, NULL for none
 
     OUTPUT..
 
@@ -73,131 +568,522 @@
     Algol  60 procedure  localmin  given in Richard Brent, Algorithms for
     Minimization without Derivatives, Prentice-Hall, Inc. (1973).
 */
-double Brent_fmin(double ax, double bx, double guessx, double (*f)(double, void *), \
-    void *fargs, double tol, unsigned int max_iter, int *info_ptr)
+double Brent_fmin(double ax, double bx, double min_x, double max_x, double guessx, double (*f)(double, void *), \
+    void *fargs, double tol, unsigned int max_iter, Brent_observer const *observer, int *info_ptr)
 {
-    if (bx <= ax || guessx < ax || guessx > bx)
+    /* * info_ptr will be 0 for converged, -1 for not converged, 1 for illegal argument. */
+    Brent_state s;
+    double x = guessx;
+    int status = BRENT_CONTINUE;
+
+    if (Brent_init(& s, ax, bx, guessx, tol, max_iter, observer, & x) || Brent_set_limits(& s, min_x, max_x))
     {
-        fprintf(stderr, "Error! There must be ax <= guessx <= bx (cannot be equal together).\n");
         * info_ptr = 1;
         return guessx;
     }
+    while ((status = Brent_tell(& s, (* f)(x, fargs), & x)) == BRENT_CONTINUE)
+        ;
+    * info_ptr = status == BRENT_NOT_CONVERGED ? -1 : 0;
 
-    unsigned int num_iter = 0u;
-    /* * info_ptr will be 0 for converged, -1 for not converged, 1 for illegal argument. */
+    return x;
+}
 
-    /*  c is the squared inverse of the golden ratio */
-    const double c = (3. - sqrt(5.)) * .5; /* 1 - 0.618... */
+/*
+    The points at which f has been or is being evaluated by Brent_fmin_speculative.
+    Values are kept even if they were not asked for yet, since a later step may land on them.
+*/
+typedef struct
+{
+    Brent_evaluator const *evaluator;
+    void *fargs;
+    double *xs, *fxs;
+    int *statuses; /* SPEC_* */
+    unsigned int *start_rounds; /* the number of rounds finished when each evaluation started */
+    unsigned int num_round; /* rounds of waiting for f */
+    unsigned int num_x, max_x;
+    unsigned int num_running;
+} Brent_spec_points;
 
-    /* Local variables */
-    double a, b, d, e, p, q, r, u, v, w, x;
-    double t2, fu, fv, fw, fx, xm, eps, tol1, tol3;
+# define SPEC_RUNNING 0
+# define SPEC_DONE 1
+# define SPEC_FAILED 2
+# define SPEC_CANCELLED 3
 
-    /*  eps is approximately the square root of the relative machine precision. */
-    eps = __DBL_EPSILON__;
-    tol1 = eps + 1.; /* the smallest 1.000... > 1 */
-    eps = sqrt(eps);
+static int Same_point(Brent_spec_points const *points, double x1, double x2)
+{
+    if (x1 == x2)
+        return 1;
+    if (! points->evaluator->is_same)
+        return 0;
 
-    a = ax;
-    b = bx;
-    /* v = a + c * (b - a); */
-    v = guessx;
-    w = v;
-    x = v;
+    return (* points->evaluator->is_same)(x1, x2, points->fargs);
+}
 
-    d = 0.; /* -Wall */
-    e = 0.;
-    fx = (* f)(x, fargs);
-    fv = fx;
-    fw = fx;
-    tol3 = tol / 3.;
+/* the index of the point where f(x) is (being) evaluated, or -1 */
+static int Find_spec_point(Brent_spec_points const *points, double x)
+{
+    unsigned int ix = 0u;
 
-    /*  main loop starts here */
-    while (num_iter <= max_iter)
+    for (ix = 0u; ix < points->num_x; ++ ix)
     {
-        ++ num_iter;
-        xm = (a + b) * .5;
-        tol1 = eps * fabs(x) + tol3;
-        t2 = tol1 * 2.;
+        if ((points->statuses[ix] == SPEC_RUNNING || points->statuses[ix] == SPEC_DONE) && \
+            Same_point(points, points->xs[ix], x))
+            return (int)ix;
+    }
 
-        /* check stopping criterion */
+    return -1;
+}
 
-        if (fabs(x - xm) <= t2 - (b - a) * .5)
-            break;
-        p = 0.;
-        q = 0.;
-        r = 0.;
-        if (fabs(e) > tol1)
-        {
-            /* fit parabola */
-            r = (x - w) * (fx - fv);
-            q = (x - v) * (fx - fw);
-            p = (x - v) * q - (x - w) * r;
-            q = (q - r) * 2.;
-            if (q > 0.)
-                p = -p;
-            else
-                q = -q;
-            r = e;
-            e = d;
+/* start evaluating f(x) unless it is known or running, returns 0 on success. */
+static int Start_spec_point(Brent_spec_points *points, double x)
+{
+    if (Find_spec_point(points, x) >= 0)
+        return 0;
+    if (points->num_x == points->max_x || (* points->evaluator->start)(x, points->fargs))
+        return 1;
+    points->xs[points->num_x] = x;
+    points->statuses[points->num_x] = SPEC_RUNNING;
+    points->start_rounds[points->num_x] = points->num_round;
+    ++ points->num_x;
+    ++ points->num_running;
+
+    return 0;
+}
+
+/*
+    Wait until f(x) is known, returns 0 on success, and 1 if the evaluation at x itself fails.
+    It takes a new round, unless f(x) has been started before the last round, and so ends about with it.
+*/
+static int Wait_spec_point(Brent_spec_points *points, double x, double *fx_ptr)
+{
+    int ix = -1;
+    unsigned int iended = 0u;
+    double x_ended = 0., fx_ended = 0.;
+    int error = 0;
+
+    for (;;)
+    {
+        ix = Find_spec_point(points, x);
+        if (ix < 0)
+            return 1;
+        if (points->statuses[ix] == SPEC_DONE)
+        {
+            * fx_ptr = points->fxs[ix];
+            return 0;
+        }
+        if (points->start_rounds[ix] == points->num_round)
+            ++ points->num_round;
+        error = (* points->evaluator->wait_any)(& x_ended, & fx_ended, points->fargs);
+        for (iended = 0u; iended < points->num_x; ++ iended)
+        {
+            if (points->statuses[iended] == SPEC_RUNNING && points->xs[iended] == x_ended)
+                break;
+        }
+        if (iended == points->num_x)
+            return 1;
+        -- points->num_running;
+        points->statuses[iended] = error ? SPEC_FAILED : SPEC_DONE;
+        points->fxs[iended] = fx_ended;
+        /* a speculative point failing does not matter, unless it is needed */
+    }
+}
+
+/* cancel the running evaluations except those at the wanted points. */
+static void Cancel_spec_points(Brent_spec_points *points, double const *wanted_xs, unsigned int num_wanted)
+{
+    unsigned int ix = 0u, iwanted = 0u;
+
+    for (ix = 0u; ix < points->num_x; ++ ix)
+    {
+        if (points->statuses[ix] != SPEC_RUNNING)
+            continue;
+        for (iwanted = 0u; iwanted < num_wanted; ++ iwanted)
+        {
+            if (Same_point(points, points->xs[ix], wanted_xs[iwanted]))
+                break;
         }
+        if (iwanted < num_wanted)
+            continue;
+        (* points->evaluator->cancel)(points->xs[ix], points->fargs);
+        points->statuses[ix] = SPEC_CANCELLED;
+        -- points->num_running;
+    }
+
+    return;
+}
+
+/*
+    The likely points of the step after the one at u: the golden-section point if f(u) <= f(x),
+    the golden-section point if f(u) > f(x), and the full step with f(u) predicted by the parabola
+    through v, w and x. Returns the number of candidates.
+*/
+static unsigned int Guess_next_points(Brent_state const *s, double u, double *candidates)
+{
+    Brent_state next;
+    unsigned int num_candidate = 0u;
+    double fu_predicted = 0.;
+
+    /* the parabola first, it is the most likely one near the minimum */
+    if (s->v != s->w && s->w != s->x && s->v != s->x)
+    {
+        fu_predicted = s->fv * (u - s->w) * (u - s->x) / ((s->v - s->w) * (s->v - s->x)) + \
+            s->fw * (u - s->v) * (u - s->x) / ((s->w - s->v) * (s->w - s->x)) + \
+            s->fx * (u - s->v) * (u - s->w) / ((s->x - s->v) * (s->x - s->w));
+        next = * s;
+        Update_state(& next, u, fu_predicted);
+        if (! Take_step(& next))
+            candidates[num_candidate ++] = next.u;
+    }
+    next = * s;
+    Update_state(& next, u, s->fx);
+    if (! Next_step(& next, & candidates[num_candidate], 1))
+        ++ num_candidate;
+    next = * s;
+    Update_state(& next, u, HUGE_VAL);
+    if (! Next_step(& next, & candidates[num_candidate], 1))
+        ++ num_candidate;
 
-        if (fabs(p) >= fabs(q * .5 * r) || \
-            p <= q * (a - x) || p >= q * (b - x))
+    return num_candidate;
+}
+
+/*
+    Brent_fmin, but while f(u) is being evaluated, f is also evaluated at the likely points of the
+    next step, as far as evaluator->max_running allows. When the next step is known, the evaluation at it
+    is kept (or already done) and the others are cancelled.
+    The points visited are exactly those of Brent_fmin, so is the result and its convergence guarantee;
+    what is saved is the number of rounds waiting for f, stored in * num_round_ptr,
+    while the number of evaluations only grows.
+    * info_ptr will be 0 for converged, -1 for not converged, 1 for illegal argument, and 2 if f fails.
+*/
+double Brent_fmin_speculative(double ax, double bx, double min_x, double max_x, double guessx, \
+    Brent_evaluator const *evaluator, void *fargs, double tol, unsigned int max_iter, Brent_observer const *observer, \
+    unsigned int *num_round_ptr, int *info_ptr)
+{
+    Brent_spec_points points;
+    Brent_state s;
+    unsigned int num_candidate = 0u, icandidate = 0u;
+    double wanted_xs[4];
+    double u = 0., fu = 0.;
+    int iu = -1;
+    int status = BRENT_CONTINUE;
+    int is_failed = 0;
+
+    * num_round_ptr = 0u;
+    if (Brent_init(& s, ax, bx, guessx, tol, max_iter, observer, & u) || Brent_set_limits(& s, min_x, max_x))
+    {
+        * info_ptr = 1;
+        return guessx;
+    }
+
+    /* every step starts at most the point itself and 3 candidates */
+    points.evaluator = evaluator;
+    points.fargs = fargs;
+    points.num_x = 0u;
+    points.max_x = 4u * (max_iter + 2u);
+    points.num_running = 0u;
+    points.num_round = 0u;
+    points.start_rounds = (unsigned int *)malloc(points.max_x * sizeof(unsigned int));
+    points.xs = (double *)malloc(points.max_x * sizeof(double));
+    points.fxs = (double *)malloc(points.max_x * sizeof(double));
+    points.statuses = (int *)malloc(points.max_x * sizeof(int));
+    if (! points.xs || ! points.fxs || ! points.statuses || ! points.start_rounds)
+    {
+        fprintf(stderr, "Error! Cannot allocate memory for Brent's method.\n");
+        free(points.start_rounds);
+        free(points.xs);
+        free(points.fxs);
+        free(points.statuses);
+        * info_ptr = 1;
+        return guessx;
+    }
+
+    status = BRENT_CONTINUE;
+    while (status == BRENT_CONTINUE)
+    {
+        wanted_xs[0] = u;
+        num_candidate = s.is_started ? Guess_next_points(& s, u, wanted_xs + 1) : 0u;
+        Cancel_spec_points(& points, wanted_xs, num_candidate + 1u);
+        iu = Find_spec_point(& points, u);
+        if (iu < 0 && points.num_running >= evaluator->max_running)
+            Cancel_spec_points(& points, wanted_xs, 1u);
+        if (Start_spec_point(& points, u))
         {
-            /* a golden-section step */
-            if (x < xm)
-                e = b - x;
-            else
-                e = a - x;
-            d = c * e;
+            is_failed = 1;
+            break;
         }
+        for (icandidate = 1u; icandidate <= num_candidate && points.num_running < evaluator->max_running; ++ icandidate)
+            Start_spec_point(& points, wanted_xs[icandidate]);
+        if (Wait_spec_point(& points, u, & fu))
+        {
+            is_failed = 1;
+            break;
+        }
+        status = Brent_tell(& s, fu, & u);
+    }
+
+    if (is_failed)
+        * info_ptr = 2;
+    else
+        * info_ptr = status == BRENT_NOT_CONVERGED ? -1 : 0;
+    Cancel_spec_points(& points, NULL, 0u);
+    * num_round_ptr = points.num_round;
+    free(points.start_rounds);
+    free(points.xs);
+    free(points.fxs);
+    free(points.statuses);
+
+    return s.x;
+}
+
+/* Brent_fmin started from the values already known at some points, see Brent_init_known. */
+double Brent_fmin_known(double ax, double bx, double min_x, double max_x, double const *xs, double const *fxs, \
+    unsigned int num_known, double (*f)(double, void *), void *fargs, double tol, unsigned int max_iter, \
+    Brent_observer const *observer, int *info_ptr)
+{
+    /* * info_ptr will be 0 for converged, -1 for not converged, 1 for illegal argument. */
+    Brent_state s;
+    double x = ax;
+    int status = Brent_init_known(& s, ax, bx, xs, fxs, num_known, tol, max_iter, observer, & x);
+
+    if (status == BRENT_ILLEGAL || Brent_set_limits(& s, min_x, max_x))
+    {
+        * info_ptr = 1;
+        return x;
+    }
+    while (status == BRENT_CONTINUE)
+        status = Brent_tell(& s, (* f)(x, fargs), & x);
+    * info_ptr = status == BRENT_NOT_CONVERGED ? -1 : 0;
+
+    return x;
+}
+
+/* the residuals at x, w and v of s are those at whichever of old_x, old_w, old_v and u they are now */
+static void Update_residuals(Brent_state const *s, double old_x, double old_w, double u, \
+    double rs[3][BRENT_MAX_RESIDUAL], double const *ru, unsigned int num_r)
+{
+    double const xs[3] = {s->x, s->w, s->v};
+    double olds[3][BRENT_MAX_RESIDUAL];
+    unsigned int i = 0u;
+
+    memcpy(olds, rs, sizeof(olds));
+    for (i = 0u; i < 3u; ++ i)
+    {
+        if (xs[i] == u)
+            memcpy(rs[i], ru, num_r * sizeof(double));
+        else if (xs[i] == old_x)
+            memcpy(rs[i], olds[0], num_r * sizeof(double));
+        else if (xs[i] == old_w)
+            memcpy(rs[i], olds[1], num_r * sizeof(double));
         else
+            memcpy(rs[i], olds[2], num_r * sizeof(double));
+    }
+
+    return;
+}
+
+/*
+    Minimize f = the sum of squares of num_r residuals on [ax, bx], where r(x, rs, rargs) gives the residuals
+    at x in rs and returns 0 on success. When the residuals are nearly linear in x, as J_N and J_N+1 are
+    near the best w, the step of Gauss-Newton with the slopes of the residuals between x and w (the secant)
+    lands next to the minimum at once. Such a step is taken if it stays in the interval of uncertainty and
+    is less than half the step before the last one, otherwise the step of Brent's method is taken.
+    It has converged when the interval is as narrow as in Brent_fmin, or when the Gauss-Newton step from x
+    is within tol / 2 and x and w are close enough (20 * tol) for the secant slopes to be trusted.
+    * info_ptr will be 0 for converged, -1 for not converged, 1 for illegal argument, 2 if r fails.
+*/
+double Brent_fmin_residuals(double ax, double bx, double guessx, int (*r)(double, double *, void *), \
+    unsigned int num_r, void *rargs, double tol, unsigned int max_iter, unsigned int *num_eval_ptr, int *info_ptr)
+{
+    Brent_state s;
+    double rs[3][BRENT_MAX_RESIDUAL]; /* residuals at x, w and v */
+    double ru[BRENT_MAX_RESIDUAL];
+    double u = guessx, fu = 0.0, d = 0.0, slope = 0.0, numerator = 0.0, denominator = 0.0, old_x = 0.0, old_w = 0.0;
+    double tol1 = 0.0;
+    unsigned int ir = 0u;
+    int is_model = 0;
+
+    * num_eval_ptr = 0u;
+    if (bx <= ax || guessx < ax || guessx > bx || ! num_r || num_r > BRENT_MAX_RESIDUAL)
+    {
+        fprintf(stderr, "Error! There must be ax <= guessx <= bx (cannot be equal together), " \
+            "and 1 to %u residuals.\n", BRENT_MAX_RESIDUAL);
+        * info_ptr = 1;
+        return guessx;
+    }
+    Reset_state(& s, ax, bx, guessx, tol);
+    s.max_iter = max_iter;
+    /* as if the steps before were as large as the whole interval, so the model can be used at once */
+    s.e = s.d = bx - ax;
+    if ((* r)(u, ru, rargs))
+    {
+        * info_ptr = 2;
+        return guessx;
+    }
+    ++ * num_eval_ptr;
+    for (ir = 0u; ir < num_r; ++ ir)
+        fu += ru[ir] * ru[ir];
+    s.fx = s.fw = s.fv = fu;
+    for (ir = 0u; ir < 3u; ++ ir)
+        memcpy(rs[ir], ru, num_r * sizeof(double));
+    s.is_started = 1;
+
+    for (;;)
+    {
+        if (s.num_iter > s.max_iter)
         {
-            /* a parabolic-interpolation step */
-            d = p / q;
-            u = x + d;
-            /* f must not be evaluated too close to ax or bx */
-            if (u - a < t2 || b - u < t2)
+            * info_ptr = -1;
+            return s.x;
+        }
+        ++ s.num_iter;
+
+        /* the Gauss-Newton step with the secant slopes between x and w */
+        is_model = 0;
+        if (s.w != s.x)
+        {
+            numerator = denominator = 0.0;
+            for (ir = 0u; ir < num_r; ++ ir)
+            {
+                slope = (rs[0][ir] - rs[1][ir]) / (s.x - s.w);
+                numerator += rs[0][ir] * slope;
+                denominator += slope * slope;
+            }
+            if (denominator > 0.0)
             {
-                d = tol1;
-                if (x >= xm)
-                    d = -d;
+                d = - numerator / denominator;
+                tol1 = s.eps * fabs(s.x) + s.tol3;
+                if (fabs(s.x - s.w) <= 20.0 * tol && fabs(d) <= .5 * tol)
+                    break;
+                if (s.x + d > s.a + tol1 && s.x + d < s.b - tol1 && fabs(d) < .5 * fabs(s.e) && fabs(d) >= tol1)
+                {
+                    is_model = 1;
+                    s.e = s.d;
+                    s.d = d;
+                    u = s.x + d;
+                }
             }
         }
+        if (! is_model && Next_step(& s, & u, 0))
+            break;
 
-        /* f must not be evaluated too close to x */
+        if ((* r)(u, ru, rargs))
+        {
+            * info_ptr = 2;
+            return s.x;
+        }
+        ++ * num_eval_ptr;
+        fu = 0.0;
+        for (ir = 0u; ir < num_r; ++ ir)
+            fu += ru[ir] * ru[ir];
+        old_x = s.x;
+        old_w = s.w;
+        Update_state(& s, u, fu);
+        Update_residuals(& s, old_x, old_w, u, rs, ru, num_r);
+    }
+    * info_ptr = 0;
 
-        if (fabs(d) >= tol1)
-            u = x + d;
-        else if (d > 0.)
-            u = x + tol1;
+    return s.x;
+}
+
+/*
+    Brent's method on the integers in [ia, ib], for an f which is only defined on a lattice.
+    Parabolic steps are rounded to the nearest integer, and golden section steps are at least 1,
+    [a, b] only holds the integers not yet known to be worse than x, so no integer is evaluated twice,
+    and it stops exactly when a == b == x, i.e. both neighbours of x are known to be worse (or out of range).
+    At most ib - ia + 1 evaluations are done.
+*/
+long Lattice_fmin(long ia, long ib, long iguess, double (*f)(long, void *), void *fargs, \
+    unsigned int max_eval, unsigned int *num_eval_ptr, int *info_ptr)
+{
+    /* * info_ptr will be 0 for converged, -1 for more than max_eval evaluations, 1 for illegal argument. */
+    /*  c is the squared inverse of the golden ratio */
+    const double c = (3. - sqrt(5.)) * .5;
+    long a = ia, b = ib;
+    long v = iguess, w = iguess, x = iguess, u = iguess;
+    long d = 0l, e = 0l, r_e = 0l;
+    double fv = 0., fw = 0., fx = 0., fu = 0.;
+    double p = 0., q = 0., r = 0.;
+    unsigned int num_eval = 0u;
+    int is_parabolic = 0;
+
+    * num_eval_ptr = 0u;
+    if (ia > ib || iguess < ia || iguess > ib || ! max_eval)
+    {
+        * info_ptr = 1;
+        return iguess;
+    }
+    fx = (* f)(x, fargs);
+    fv = fw = fx;
+    num_eval = 1u;
+    * info_ptr = 0;
+
+    while (a < b)
+    {
+        if (num_eval >= max_eval)
+        {
+            * info_ptr = -1;
+            break;
+        }
+
+        /* fit a parabola through x, w and v, if they are different and the step before the last one is large */
+        is_parabolic = 0;
+        r_e = e;
+        if (labs(r_e) > 1l && x != w && x != v && w != v)
+        {
+            r = (double)(x - w) * (fx - fv);
+            q = (double)(x - v) * (fx - fw);
+            p = (double)(x - v) * q - (double)(x - w) * r;
+            q = (q - r) * 2.;
+            if (q > 0.)
+                p = - p;
+            else
+                q = - q;
+            if (fabs(p) < fabs(.5 * q * (double)r_e))
+            {
+                /* f must not be evaluated at x again, so at least one step away from it */
+                d = lround(p / q);
+                if (! d)
+                    d = p >= 0. ? 1l : -1l;
+                if (x + d < a || x + d > b)
+                    d = - d;
+                u = x + d;
+                is_parabolic = u >= a && u <= b;
+            }
+        }
+        if (is_parabolic)
+            e = d;
         else
-            u = x - tol1;
+        {
+            /* a golden-section step into the larger part */
+            e = b - x >= x - a ? b - x : a - x;
+            d = lround(c * (double)e);
+            if (! d)
+                d = e > 0l ? 1l : -1l;
+            u = x + d;
+        }
 
-        fu = (*f)(u, fargs);
+        fu = (* f)(u, fargs);
+        ++ num_eval;
 
         /*  update  a, b, v, w, and x */
-
         if (fu <= fx)
         {
             if (u < x)
-                b = x;
+                b = x - 1l;
             else
-                a = x;
+                a = x + 1l;
             v = w;
-            w = x;
-            x = u;
             fv = fw;
+            w = x;
             fw = fx;
+            x = u;
             fx = fu;
         }
         else
         {
             if (u < x)
-                a = u;
+                a = u + 1l;
             else
-                b = u;
+                b = u - 1l;
             if (fu <= fw || w == x)
             {
                 v = w;
@@ -212,9 +1098,7 @@ double Brent_fmin(double ax, double bx, double guessx, double (*f)(double, void
             }
         }
     }
-    /* end of main loop */
-
-    * info_ptr = num_iter > max_iter ? -1 : 0;
+    * num_eval_ptr = num_eval;
 
     return x;
 }
@@ -3,14 +3,129 @@
 # ifndef BRENT_FMIN_H
 # define BRENT_FMIN_H
 
+# include <stdio.h>
+# include <stddef.h>
+
 /***********************************************************************
  * Taken from R ver 3.2.2
  * R-3.2.2/src/library/stats/src/optimize.c
  ***********************************************************************/
 
+/* what Brent_tell returns */
+# define BRENT_CONTINUE 0 /* evaluate f at the abscissa given */
+# define BRENT_CONVERGED 1
+# define BRENT_NOT_CONVERGED -1 /* more than max_iter steps */
+# define BRENT_ILLEGAL 2 /* illegal arguments of Brent_init_known */
+
+/* how the abscissa being evaluated was chosen, see Brent_state */
+# define BRENT_STEP_GUESS 0 /* the initial guess */
+# define BRENT_STEP_GOLDEN 1
+# define BRENT_STEP_PARABOLIC 2
+
+/* why a golden-section step was taken instead of a parabolic one, see Brent_state */
+# define BRENT_REJECT_NONE 0 /* the step was parabolic, or it is the initial guess */
+# define BRENT_REJECT_SMALL 1 /* the step before the last one was within tol1, no parabola was fitted */
+# define BRENT_REJECT_FLAT 2 /* no parabola through x, w and v, when two of them are the same or f is flat there */
+# define BRENT_REJECT_LARGE 3 /* the parabola stepped at least half the step before the last one */
+# define BRENT_REJECT_OUTSIDE 4 /* the parabola stepped out of the interval of uncertainty */
+# define BRENT_REJECT_FORCED 5 /* a golden-section step was asked for */
+# define BRENT_NUM_REJECT 6
+
+/* at most this many residuals for Brent_fmin_residuals */
+# define BRENT_MAX_RESIDUAL 4u
+
+typedef struct Brent_observer Brent_observer;
+
+/*
+    Everything Brent's method keeps between two evaluations of f, so that the loop can be driven
+    from outside (see Brent_init and Brent_tell), and saved and restored at any evaluation.
+*/
+typedef struct
+{
+    double a, b; /* the interval of uncertainty */
+    double ax, bx; /* the interval searched, which grows toward [min_x, max_x] if the minimum seems beyond an end */
+    double min_x, max_x; /* see Brent_set_limits */
+    unsigned int num_expand; /* times [ax, bx] has been expanded */
+    int is_expanded; /* whether it was expanded just before the last step */
+    double d, e; /* the last step, and the one before it */
+    double v, w, x; /* x is the best point so far, w the second best, and v the previous value of w */
+    double fv, fw, fx;
+    double eps, tol3;
+    double u; /* where f is being evaluated */
+    int step; /* BRENT_STEP_* by which u was chosen */
+    int reject; /* BRENT_REJECT_* why that step was not parabolic */
+    double tol1; /* how close to x f may be evaluated at that step, and half the width [a, b] converges to */
+    unsigned int num_iter, max_iter;
+    int is_started; /* whether f of the initial guess is known */
+    /* steps of each kind taken so far, and the golden-section ones by BRENT_REJECT_*, not serialized */
+    unsigned int num_golden, num_parabolic;
+    unsigned int nums_reject[BRENT_NUM_REJECT];
+    Brent_observer const *observer; /* told about every step, NULL for none, not serialized */
+} Brent_state;
+
+/*
+    Told about the internals of Brent's method, e.g. why it took so many evaluations.
+    step is called once per iteration, when the next point s->u is chosen, and end when it stops
+    with BRENT_CONVERGED or BRENT_NOT_CONVERGED, either can be NULL.
+    Brent_print_step and Brent_print_summary print them into the FILE * args.
+*/
+struct Brent_observer
+{
+    void (*step)(Brent_state const *s, void *args);
+    void (*end)(Brent_state const *s, int status, void *args);
+    void *args;
+};
+
+/*
+    Evaluates f at several points at the same time, for Brent_fmin_speculative.
+    start and wait_any return 0 on success, wait_any gives back the point of the evaluation which ended,
+    even if it failed.
+*/
+typedef struct
+{
+    unsigned int max_running; /* evaluations which can run at the same time */
+    int (*start)(double x, void *args);
+    int (*wait_any)(double *x_ptr, double *fx_ptr, void *args);
+    void (*cancel)(double x, void *args); /* the value at x is not needed any more */
+    int (*is_same)(double x1, double x2, void *args); /* f(x1) is f(x2) for sure, NULL for only if x1 == x2 */
+} Brent_evaluator;
+
 /* see brent_fmin.c */
 
-double Brent_fmin(double ax, double bx, double guessx, double (*f)(double, void *), \
-    void *fargs, double tol, unsigned int max_iter, int *info_ptr);
+int Brent_init(Brent_state *s, double ax, double bx, double guessx, double tol, unsigned int max_iter, \
+    Brent_observer const *observer, double *x_ptr);
+
+int Brent_init_known(Brent_state *s, double ax, double bx, double const *xs, double const *fxs, \
+    unsigned int num_known, double tol, unsigned int max_iter, Brent_observer const *observer, double *x_ptr);
+
+int Brent_set_limits(Brent_state *s, double min_x, double max_x);
+
+int Brent_tell(Brent_state *s, double fu, double *x_ptr);
+
+int Brent_serialize(Brent_state const *s, char *buf, size_t size);
+
+int Brent_deserialize(Brent_state *s, char const *buf);
+
+void Brent_print_step(Brent_state const *s, void *args);
+
+void Brent_print_summary(Brent_state const *s, int status, void *args);
+
+double Brent_fmin(double ax, double bx, double min_x, double max_x, double guessx, double (*f)(double, void *), \
+    void *fargs, double tol, unsigned int max_iter, Brent_observer const *observer, int *info_ptr);
+
+double Brent_fmin_known(double ax, double bx, double min_x, double max_x, double const *xs, double const *fxs, \
+    unsigned int num_known, double (*f)(double, void *), void *fargs, double tol, unsigned int max_iter, \
+    Brent_observer const *observer, int *info_ptr);
+
+double Brent_fmin_speculative(double ax, double bx, double min_x, double max_x, double guessx, \
+    Brent_evaluator const *evaluator, \
+    void *fargs, double tol, unsigned int max_iter, Brent_observer const *observer, unsigned int *num_round_ptr, \
+    int *info_ptr);
+
+double Brent_fmin_residuals(double ax, double bx, double guessx, int (*r)(double, double *, void *), \
+    unsigned int num_r, void *rargs, double tol, unsigned int max_iter, unsigned int *num_eval_ptr, int *info_ptr);
+
+long Lattice_fmin(long ia, long ib, long iguess, double (*f)(long, void *), void *fargs, \
+    unsigned int max_eval, unsigned int *num_eval_ptr, int *info_ptr);
 
 # endif /* BRENT_FMIN_H */
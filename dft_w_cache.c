@@ -0,0 +1,162 @@
+/* cache of the energies of each state at each w, shared by all runs which use the same cache file */
+
+# include "dft_w_cache.h"
+# include <stdio.h>
+# include <string.h>
+# ifndef _WIN32
+# include <errno.h>
+# include <fcntl.h>
+# include <unistd.h>
+# else
+# include <io.h>
+# include <windows.h>
+# endif
+
+# define Close_file(flp) fclose(flp); flp = NULL
+
+/*
+    The cache file is plain text, one line for each state at each IOp value:
+        <hash of the input except IOp and Link 0> <IOp value> <state> <electron energy> <HOMO energy>
+    Lines are only appended, under an exclusive lock, so several processes can share a cache file,
+    and if a key appears more than once the last line wins.
+*/
+
+# define CACHE_HEADER "# hash iop state E e_HOMO\n"
+
+/* FNV-1a, start with hash = 0 */
+unsigned long long Hash_string(unsigned long long hash, char const *str)
+{
+    if (! hash)
+        hash = 14695981039346656037ull;
+    for (; * str; ++ str)
+    {
+        hash ^= (unsigned char)* str;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+/* wait for a shared (reading) or an exclusive (writing) lock of the whole file, released by Unlock_file. */
+static int Lock_file(FILE *fl, int is_exclusive)
+{
+    # ifndef _WIN32
+    struct flock lock;
+
+    memset(& lock, 0, sizeof(struct flock));
+    lock.l_type = is_exclusive ? F_WRLCK : F_RDLCK;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = 0;
+    lock.l_len = 0;
+    while (fcntl(fileno(fl), F_SETLKW, & lock) < 0)
+    {
+        if (errno != EINTR)
+            return 1;
+    }
+    # else
+    OVERLAPPED whole;
+
+    /* from offset 0 (given in whole) to the largest offset possible */
+    memset(& whole, 0, sizeof(OVERLAPPED));
+    if (! LockFileEx((HANDLE)_get_osfhandle(_fileno(fl)), is_exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, \
+        MAXDWORD, MAXDWORD, & whole))
+        return 1;
+    # endif
+
+    return 0;
+}
+
+/*
+    Release the lock taken by Lock_file, after what was written has been flushed. Closing the file releases
+    it too, but only at some later time on Windows.
+*/
+static void Unlock_file(FILE *fl)
+{
+    # ifndef _WIN32
+    (void)fl;
+    # else
+    OVERLAPPED whole;
+
+    memset(& whole, 0, sizeof(OVERLAPPED));
+    UnlockFileEx((HANDLE)_get_osfhandle(_fileno(fl)), 0, MAXDWORD, MAXDWORD, & whole);
+    # endif
+
+    return;
+}
+
+/* returns 0 if found, 1 if not (or no cache file yet). */
+int Look_up_cache(char const *cache_name, unsigned long long state_hash, unsigned int iop, \
+    double *E_ptr, double *e_HOMO_ptr)
+{
+    FILE *cache_ifl = NULL;
+    char buf[BUFSIZ + 1] = "";
+    unsigned long long hash = 0ull;
+    unsigned int iop_read = 0u;
+    double E = 0.0, e_HOMO = 0.0;
+    int is_found = 0;
+
+    cache_ifl = fopen(cache_name, "rt");
+    if (! cache_ifl)
+        return 1;
+    if (Lock_file(cache_ifl, 0))
+    {
+        fprintf(stderr, "Warning! Cannot lock cache file \"%s\", ignore it.\n", cache_name);
+        Close_file(cache_ifl);
+        return 1;
+    }
+    while (fgets(buf, BUFSIZ, cache_ifl))
+    {
+        if (* buf == '#')
+            continue;
+        if (sscanf(buf, "%llx %u %*s %lg %lg", & hash, & iop_read, & E, & e_HOMO) != 4)
+            continue;
+        if (hash == state_hash && iop_read == iop)
+        {
+            * E_ptr = E;
+            * e_HOMO_ptr = e_HOMO;
+            is_found = 1;
+        }
+    }
+    Unlock_file(cache_ifl);
+    Close_file(cache_ifl);
+
+    return is_found ? 0 : 1;
+}
+
+/* returns 0 on success */
+int Store_in_cache(char const *cache_name, unsigned long long state_hash, unsigned int iop, \
+    char const *state_stem, double E, double e_HOMO)
+{
+    FILE *cache_ofl = NULL;
+    long cache_size = 0l;
+
+    cache_ofl = fopen(cache_name, "at");
+    if (! cache_ofl)
+    {
+        fprintf(stderr, "Warning! Cannot open cache file \"%s\" for writing.\n", cache_name);
+        return 1;
+    }
+    if (Lock_file(cache_ofl, 1))
+    {
+        fprintf(stderr, "Warning! Cannot lock cache file \"%s\".\n", cache_name);
+        Close_file(cache_ofl);
+        return 1;
+    }
+    fseek(cache_ofl, 0l, SEEK_END);
+    cache_size = ftell(cache_ofl);
+    if (! cache_size)
+        fprintf(cache_ofl, "%s", CACHE_HEADER);
+    fprintf(cache_ofl, "%016llx %05u %s %.17g %.17g\n", state_hash, iop, state_stem, E, e_HOMO);
+    fflush(cache_ofl);
+    if (ferror(cache_ofl))
+    {
+        fprintf(stderr, "Warning! Failed to write cache file \"%s\".\n", cache_name);
+        Unlock_file(cache_ofl);
+        Close_file(cache_ofl);
+        return 1;
+    }
+    Unlock_file(cache_ofl);
+    Close_file(cache_ofl);
+
+    return 0;
+}
@@ -0,0 +1,15 @@
+/* cache of the energies of each state at each w, shared by all runs which use the same cache file */
+# ifndef DFT_W_CACHE_H
+# define DFT_W_CACHE_H
+
+/* see dft_w_cache.c */
+
+unsigned long long Hash_string(unsigned long long hash, char const *str);
+
+int Look_up_cache(char const *cache_name, unsigned long long state_hash, unsigned int iop, \
+    double *E_ptr, double *e_HOMO_ptr);
+
+int Store_in_cache(char const *cache_name, unsigned long long state_hash, unsigned int iop, \
+    char const *state_stem, double E, double e_HOMO);
+
+# endif /* DFT_W_CACHE_H */
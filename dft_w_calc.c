@@ -0,0 +1,2218 @@
+/* calculate J and J^2 of a given w (literally omega) with Gaussian, shared by optimize_DFT_w and scan_DFT_w */
+
+# include "dft_w_calc.h"
+# include "gau_run.h"
+# include "dft_w_cache.h"
+# include "gau_log.h"
+# include <stdlib.h>
+# include <string.h>
+# include <ctype.h>
+# ifdef _WIN32
+# include <io.h>
+# include <direct.h>
+# else
+# include <unistd.h>
+# include <dirent.h>
+# endif
+# include <sys/stat.h>
+# include <math.h>
+
+# define Close_file(flp) fclose(flp); flp = NULL
+
+/* how often the outputs of running jobs are read in the supervised mode */
+# define WATCH_INTERVAL_MS 500u
+
+char const *const state_names[NUM_STATE] = {"N", "N+1", "N-1"};
+char const *const state_stems[NUM_STATE] = {"N", "Np1", "Nm1"};
+
+/* turn "\r\n" and "\n" at the end of a line into nothing */
+static void Strip_line_feed(char *line)
+{
+    char *line_end = NULL;
+
+    if ((line_end = strchr(line, '\r')) && (line_end[1] == '\n' || line_end[1] == '\0'))
+        * line_end = '\0';
+    if ((line_end = strchr(line, '\n')))
+        * line_end = '\0';
+
+    return;
+}
+
+static int Append_string(char **dest_ptr, size_t *dest_len_ptr, char const *src)
+{
+    size_t src_len = strlen(src);
+    char *new_dest = (char *)realloc(* dest_ptr, * dest_len_ptr + src_len + 1u);
+
+    if (! new_dest)
+        return 1;
+    memcpy(new_dest + * dest_len_ptr, src, src_len + 1u);
+    * dest_ptr = new_dest;
+    * dest_len_ptr += src_len;
+
+    return 0;
+}
+
+/* if line is a Link 0 command "%key=value" (key is case-insensitive), returns where value starts, otherwise NULL */
+static char const *Link0_value(char const *line, char const *key)
+{
+    size_t ichar = 0u;
+
+    if (* line != '%')
+        return NULL;
+    ++ line;
+    for (ichar = 0u; key[ichar]; ++ ichar)
+    {
+        if (tolower((unsigned char)line[ichar]) != tolower((unsigned char)key[ichar]))
+            return NULL;
+    }
+    line += ichar;
+    while (* line == ' ' || * line == '\t')
+        ++ line;
+    if (* line != '=')
+        return NULL;
+    ++ line;
+    while (* line == ' ' || * line == '\t')
+        ++ line;
+
+    return line;
+}
+
+/* whether str contains word, case-insensitive */
+static bool Contains_nocase(char const *str, char const *word)
+{
+    size_t ichar = 0u;
+
+    for (; * str; ++ str)
+    {
+        for (ichar = 0u; word[ichar]; ++ ichar)
+        {
+            if (tolower((unsigned char)str[ichar]) != tolower((unsigned char)word[ichar]))
+                break;
+        }
+        if (! word[ichar])
+            return true;
+    }
+
+    return false;
+}
+
+/* parse "%Mem" value like "1GB" or "100MW" (bare numbers are words), returns 0 on success. */
+int Parse_mem(char const *str, double *bytes_ptr)
+{
+    double value = 0.0;
+    char unit[BUFSIZ + 1] = "";
+    double scale = 8.0;
+    unsigned int ichar = 0u;
+
+    unit[0] = '\0';
+    if (sscanf(str, "%lf%s", & value, unit) < 1 || value <= 0.0)
+        return 1;
+    for (ichar = 0u; unit[ichar]; ++ ichar)
+        unit[ichar] = (char)toupper((unsigned char)unit[ichar]);
+    if (! * unit || ! strcmp(unit, "W"))
+        scale = 8.0;
+    else if (! strcmp(unit, "KB"))
+        scale = 1024.0;
+    else if (! strcmp(unit, "MB"))
+        scale = 1024.0 * 1024.0;
+    else if (! strcmp(unit, "GB"))
+        scale = 1024.0 * 1024.0 * 1024.0;
+    else if (! strcmp(unit, "TB"))
+        scale = 1024.0 * 1024.0 * 1024.0 * 1024.0;
+    else if (! strcmp(unit, "KW"))
+        scale = 8.0 * 1024.0;
+    else if (! strcmp(unit, "MW"))
+        scale = 8.0 * 1024.0 * 1024.0;
+    else if (! strcmp(unit, "GW"))
+        scale = 8.0 * 1024.0 * 1024.0 * 1024.0;
+    else if (! strcmp(unit, "TW"))
+        scale = 8.0 * 1024.0 * 1024.0 * 1024.0 * 1024.0;
+    else
+        return 1;
+    * bytes_ptr = value * scale;
+
+    return 0;
+}
+
+/* parse the objective like "both", "IP" (J_N alone) or "EA" (J_N+1 alone), in any case, returns 0 on success. */
+int Parse_objective(char const *str, unsigned int *objective_ptr)
+{
+    char name[8] = "";
+    unsigned int ichar = 0u;
+
+    for (ichar = 0u; str[ichar] && ichar < sizeof(name) - 1u; ++ ichar)
+        name[ichar] = (char)toupper((unsigned char)str[ichar]);
+    name[ichar] = '\0';
+    if (str[ichar])
+        return 1;
+    if (! strcmp(name, "BOTH"))
+        * objective_ptr = OBJECTIVE_J_BOTH;
+    else if (! strcmp(name, "IP"))
+        * objective_ptr = OBJECTIVE_J_N;
+    else if (! strcmp(name, "EA"))
+        * objective_ptr = OBJECTIVE_J_NP1;
+    else
+        return 1;
+
+    return 0;
+}
+
+/* "%Mem" of bytes, in MB, or in KB if less than 1 MB */
+static void Write_mem_line(FILE *gjf_ofl, double bytes)
+{
+    if (bytes >= 1024.0 * 1024.0)
+        fprintf(gjf_ofl, "%%Mem=%.0lfMB\n", floor(bytes / (1024.0 * 1024.0)));
+    else
+        fprintf(gjf_ofl, "%%Mem=%.0lfKB\n", floor(bytes / 1024.0) > 1.0 ? floor(bytes / 1024.0) : 1.0);
+
+    return;
+}
+
+/*
+    Write a Link 0 command for the i_part-th of num_part jobs which run at the same time,
+    so that they share the processors and the memory given in the template instead of each taking all of them.
+    If num_core is not 0, it replaces the number of processors given in the template before sharing.
+    The checkpoint file is renamed after the input file so that the jobs do not overwrite each other.
+*/
+static void Write_link0_line(FILE *gjf_ofl, char const *line, unsigned int num_part, unsigned int i_part, \
+    unsigned int num_core, char const *gjf_name)
+{
+    char const *value = NULL;
+    unsigned int *cpus = NULL;
+    unsigned int num_cpu = 0u, first = 0u, last = 0u, num_proc = 0u;
+    char *cpu_list = NULL;
+    double bytes = 0.0;
+    char chk_name[BUFSIZ + 1] = "";
+    char *extension = NULL;
+    char const *gjf_base = NULL;
+    size_t gjf_stem_len = 0u;
+
+    if (num_part <= 1u && ! num_core)
+    {
+        fprintf(gjf_ofl, "%s\n", line);
+        return;
+    }
+
+    if ((value = Link0_value(line, "CPU")))
+    {
+        cpus = (unsigned int *)malloc(MAX_NUM_CPU * sizeof(unsigned int));
+        cpu_list = (char *)malloc(MAX_NUM_CPU * 12u);
+        if (cpus && cpu_list && (num_cpu = Parse_cpu_list(value, cpus, MAX_NUM_CPU)))
+        {
+            /* take the first num_core processors, or continue after the last one if there are not enough */
+            if (num_core)
+            {
+                for (; num_cpu < num_core && num_cpu < MAX_NUM_CPU; ++ num_cpu)
+                    cpus[num_cpu] = cpus[num_cpu - 1u] + 1u;
+                if (num_cpu > num_core)
+                    num_cpu = num_core;
+            }
+            first = i_part * num_cpu / num_part;
+            last = (i_part + 1u) * num_cpu / num_part;
+            /* fewer processors than jobs, they have to share */
+            if (first == last)
+            {
+                first = i_part % num_cpu;
+                last = first + 1u;
+            }
+            Format_cpu_list(cpus + first, last - first, cpu_list);
+            fprintf(gjf_ofl, "%%CPU=%s\n", cpu_list);
+        }
+        else
+            fprintf(gjf_ofl, "%s\n", line);
+        free(cpus);
+        free(cpu_list);
+        return;
+    }
+    if ((value = Link0_value(line, "NProcShared")) || (value = Link0_value(line, "NProc")))
+    {
+        if (num_core || (sscanf(value, "%u", & num_proc) == 1 && num_proc))
+        {
+            if (num_core)
+                num_proc = num_core;
+            num_proc = num_proc / num_part + (i_part < num_proc % num_part ? 1u : 0u);
+            fprintf(gjf_ofl, "%%NProcShared=%u\n", num_proc ? num_proc : 1u);
+        }
+        else
+            fprintf(gjf_ofl, "%s\n", line);
+        return;
+    }
+    if (num_part <= 1u)
+    {
+        fprintf(gjf_ofl, "%s\n", line);
+        return;
+    }
+    if ((value = Link0_value(line, "Mem")))
+    {
+        if (! Parse_mem(value, & bytes))
+            Write_mem_line(gjf_ofl, bytes / num_part);
+        else
+            fprintf(gjf_ofl, "%s\n", line);
+        return;
+    }
+    if ((value = Link0_value(line, "Chk")))
+    {
+        strncpy(chk_name, value, BUFSIZ);
+        gjf_base = strrchr(gjf_name, '/');
+        gjf_base = gjf_base ? gjf_base + 1 : gjf_name;
+        gjf_stem_len = strrchr(gjf_base, '.') ? (size_t)(strrchr(gjf_base, '.') - gjf_base) : strlen(gjf_base);
+        extension = strrchr(chk_name, '.');
+        if (extension && ! strchr(extension, '/') && ! strchr(extension, '\\'))
+            * extension = '\0';
+        fprintf(gjf_ofl, "%%Chk=%s_%.*s.chk\n", chk_name, (int)gjf_stem_len, gjf_base);
+        return;
+    }
+    fprintf(gjf_ofl, "%s\n", line);
+
+    return;
+}
+
+static int Compare_cpus(void const *cpu1, void const *cpu2)
+{
+    unsigned int c1 = * (unsigned int const *)cpu1, c2 = * (unsigned int const *)cpu2;
+
+    return c1 < c2 ? -1 : c1 > c2;
+}
+
+/*
+    Write "%CPU" and "%Mem" giving the i_part-th of num_part jobs running at the same time a slice of temp->topo
+    of its own (see Split_node_cpus), in place of those in the template.
+    The processors shared are those of temp->topo, only those listed in "%CPU" of the template if any are,
+    and only the first temp->num_core of them, or as many as the template gives, if it does.
+    The memory shared is temp->mem_bytes if not 0, or "%Mem" of the template if given, or 3/4 of that available.
+*/
+static void Write_pinned_link0(FILE *gjf_ofl, Gjf_template const *temp, unsigned int num_part, unsigned int i_part)
+{
+    Node_cpu *cpus = (Node_cpu *)malloc((temp->topo->num_cpu + 1u) * sizeof(Node_cpu));
+    unsigned int *listed_cpus = (unsigned int *)malloc(MAX_NUM_CPU * sizeof(unsigned int));
+    char *cpu_list = (char *)malloc(MAX_NUM_CPU * 12u);
+    unsigned int num_listed = 0u, num_proc = 0u, num_cpu = 0u, icpu = 0u, ilisted = 0u, first = 0u, iline = 0u;
+    char const *value = NULL;
+    double bytes = temp->mem_bytes;
+
+    for (iline = 0u; iline < temp->num_head_line; ++ iline)
+    {
+        if ((value = Link0_value(temp->head_lines[iline], "CPU")) && listed_cpus)
+            num_listed = Parse_cpu_list(value, listed_cpus, MAX_NUM_CPU);
+        else if ((value = Link0_value(temp->head_lines[iline], "NProcShared")) || \
+            (value = Link0_value(temp->head_lines[iline], "NProc")))
+        {
+            if (sscanf(value, "%u", & num_proc) != 1)
+                num_proc = 0u;
+        }
+        else if ((value = Link0_value(temp->head_lines[iline], "Mem")) && ! temp->mem_bytes && \
+            Parse_mem(value, & bytes))
+            bytes = 0.0;
+    }
+    if (! bytes)
+        bytes = temp->topo->available_bytes * 0.75;
+    if (bytes > 0.0)
+        Write_mem_line(gjf_ofl, bytes / num_part);
+    if (! cpus || ! listed_cpus || ! cpu_list)
+    {
+        free(cpus);
+        free(listed_cpus);
+        free(cpu_list);
+        return;
+    }
+
+    /* the processors of the template which this node has, all of them if there are none */
+    for (icpu = 0u; icpu < temp->topo->num_cpu; ++ icpu)
+    {
+        for (ilisted = 0u; ilisted < num_listed && listed_cpus[ilisted] != temp->topo->cpus[icpu].cpu; ++ ilisted)
+            ;
+        if (! num_listed || ilisted < num_listed)
+            cpus[num_cpu ++] = temp->topo->cpus[icpu];
+    }
+    if (! num_cpu)
+    {
+        memcpy(cpus, temp->topo->cpus, temp->topo->num_cpu * sizeof(Node_cpu));
+        num_cpu = temp->topo->num_cpu;
+    }
+    if (temp->num_core)
+        num_proc = temp->num_core;
+    else if (num_listed)
+        num_proc = num_listed;
+    if (num_proc && num_proc < num_cpu)
+        num_cpu = num_proc;
+    num_cpu = Split_node_cpus(cpus, num_cpu, num_part, i_part, & first);
+    for (icpu = 0u; icpu < num_cpu; ++ icpu)
+        listed_cpus[icpu] = cpus[first + icpu].cpu;
+    qsort(listed_cpus, num_cpu, sizeof(unsigned int), Compare_cpus);
+    if (num_cpu)
+    {
+        Format_cpu_list(listed_cpus, num_cpu, cpu_list);
+        fprintf(gjf_ofl, "%%CPU=%s\n", cpu_list);
+    }
+    free(cpus);
+    free(listed_cpus);
+    free(cpu_list);
+
+    return;
+}
+
+/* find g16 or g09 in the directories of environment variable "GAUSS_EXEDIR", returns 0 on success. */
+int Find_gau_exe(char *gau_exe)
+{
+    char env_gauss_exedir_copy[BUFSIZ + 1] = "";
+    char *env_gauss_exedir = NULL;
+    char const *env_gauss_exedir_ptr = getenv("GAUSS_EXEDIR");
+    char const *const exe_names[] = {"g16", "g09"}; /* assume it is Gaussian 16 first */
+    unsigned int iexe = 0u;
+    # ifdef _WIN32
+    char const path_splitter[] = ";";
+    # else
+    char const path_splitter[] = ":";
+    # endif
+
+    * gau_exe = '\0';
+    if (! env_gauss_exedir_ptr || ! strcmp(env_gauss_exedir_ptr, ""))
+    {
+        fprintf(stderr, "Error! Environment variable \"GAUSS_EXEDIR\" is not set properly!\n");
+        return 1;
+    }
+    strncpy(env_gauss_exedir_copy, env_gauss_exedir_ptr, BUFSIZ);
+    /* the path is kept as it is, blanks and all, the jobs are not started by a shell */
+    for (env_gauss_exedir = strtok(env_gauss_exedir_copy, path_splitter); env_gauss_exedir; \
+        env_gauss_exedir = strtok(NULL, path_splitter))
+    {
+        for (iexe = 0u; iexe < sizeof(exe_names) / sizeof(char const *); ++ iexe)
+        {
+            # ifdef _WIN32
+            snprintf(gau_exe, BUFSIZ + 1, "%s\\%s.exe", env_gauss_exedir, exe_names[iexe]);
+            # else
+            snprintf(gau_exe, BUFSIZ + 1, "%s/%s", env_gauss_exedir, exe_names[iexe]);
+            # endif
+            if (! access(gau_exe, X_OK))
+                return 0;
+        }
+    }
+    * gau_exe = '\0';
+    fprintf(stderr, "Error! Cannot find either g16 or g09 as executable.\n");
+
+    return 1;
+}
+
+/* hash of everything the results of each state depend on but w, Link 0 commands and the title do not change them */
+static void Hash_template_states(Gjf_template *temp)
+{
+    char buf[64] = "";
+    unsigned int istate = 0u, iline = 0u;
+    unsigned long long hash = 0ull;
+
+    for (istate = 0u; istate < NUM_STATE; ++ istate)
+    {
+        hash = 0ull;
+        for (iline = 0u; iline < temp->num_head_line; ++ iline)
+        {
+            if (* temp->head_lines[iline] != '%')
+            {
+                hash = Hash_string(hash, temp->head_lines[iline]);
+                hash = Hash_string(hash, "\n");
+            }
+        }
+        sprintf(buf, "%d %u\n", temp->charges[istate], temp->multis[istate]);
+        hash = Hash_string(hash, buf);
+        temp->state_hashes[istate] = Hash_string(hash, temp->body);
+    }
+
+    return;
+}
+
+/*
+    Read the template, and set the charges and multiplicities of all states.
+    multi_np1 and multi_nm1 are 0 for "multiplicity of reference state" + 1.
+    Returns 0 on success.
+*/
+int Read_template(Gjf_template *temp, char const *temp_name, unsigned int multi_np1, unsigned int multi_nm1)
+{
+    FILE *temp_ifl = NULL;
+    char buf[BUFSIZ + 1] = "";
+    char **new_head_lines = NULL;
+    size_t title_len = 0u, body_len = 0u;
+    int charge_n = 0;
+    unsigned int multi_n = 0u;
+
+    memset(temp, 0, sizeof(Gjf_template));
+    temp_ifl = fopen(temp_name, "rt");
+    if (! temp_ifl)
+    {
+        fprintf(stderr, "Error! Cannot find \"%s\".\n", temp_name);
+        return 1;
+    }
+    if (Append_string(& temp->title, & title_len, "") || Append_string(& temp->body, & body_len, ""))
+    {
+        fprintf(stderr, "Error! Cannot allocate memory for reading \"%s\".\n", temp_name);
+        Close_file(temp_ifl);
+        Free_template(temp);
+        return 1;
+    }
+    /* link 0, route section and a blank line followed */
+    while (fgets(buf, BUFSIZ, temp_ifl))
+    {
+        Strip_line_feed(buf);
+        if (! * buf)
+            break;
+        new_head_lines = (char **)realloc(temp->head_lines, (temp->num_head_line + 1u) * sizeof(char *));
+        if (! new_head_lines || ! (new_head_lines[temp->num_head_line] = (char *)malloc(strlen(buf) + 1u)))
+        {
+            fprintf(stderr, "Error! Cannot allocate memory for reading \"%s\".\n", temp_name);
+            if (new_head_lines)
+                temp->head_lines = new_head_lines;
+            Close_file(temp_ifl);
+            Free_template(temp);
+            return 1;
+        }
+        temp->head_lines = new_head_lines;
+        strcpy(temp->head_lines[temp->num_head_line ++], buf);
+    }
+    /* title and a blank line followed */
+    while (fgets(buf, BUFSIZ, temp_ifl))
+    {
+        Strip_line_feed(buf);
+        if (Append_string(& temp->title, & title_len, buf) || Append_string(& temp->title, & title_len, "\n"))
+        {
+            fprintf(stderr, "Error! Cannot allocate memory for reading \"%s\".\n", temp_name);
+            Close_file(temp_ifl);
+            Free_template(temp);
+            return 1;
+        }
+        if (! * buf)
+            break;
+    }
+    /* charge and multiplicity */
+    if (! fgets(buf, BUFSIZ, temp_ifl) || sscanf(buf, "%d %u", & charge_n, & multi_n) != 2)
+    {
+        fprintf(stderr, "Error! Cannot read the charge and multiplicity from template file.\n");
+        Close_file(temp_ifl);
+        Free_template(temp);
+        return 1;
+    }
+    if (! multi_n)
+    {
+        fprintf(stderr, "Error! Multiplicity cannot be zero, but it is zero in template file for N state.\n");
+        Close_file(temp_ifl);
+        Free_template(temp);
+        return 1;
+    }
+    if (! multi_np1)
+        multi_np1 = multi_n + 1;
+    else if (! ((multi_np1 - multi_n) & 1))
+    {
+        fprintf(stderr, "Error! Multiplicity of N+1 state and N state must have different parity.\n");
+        Close_file(temp_ifl);
+        Free_template(temp);
+        return 1;
+    }
+    if (! multi_nm1)
+        multi_nm1 = multi_n + 1;
+    else if (! ((multi_nm1 - multi_n) & 1))
+    {
+        fprintf(stderr, "Error! Multiplicity of N-1 state and N state must have different parity.\n");
+        Close_file(temp_ifl);
+        Free_template(temp);
+        return 1;
+    }
+    temp->charges[STATE_N] = charge_n;
+    temp->charges[STATE_NP1] = charge_n - 1;
+    temp->charges[STATE_NM1] = charge_n + 1;
+    temp->multis[STATE_N] = multi_n;
+    temp->multis[STATE_NP1] = multi_np1;
+    temp->multis[STATE_NM1] = multi_nm1;
+    /* atom coordinates and others */
+    while (fgets(buf, BUFSIZ, temp_ifl))
+    {
+        Strip_line_feed(buf);
+        if (Append_string(& temp->body, & body_len, buf) || Append_string(& temp->body, & body_len, "\n"))
+        {
+            fprintf(stderr, "Error! Cannot allocate memory for reading \"%s\".\n", temp_name);
+            Close_file(temp_ifl);
+            Free_template(temp);
+            return 1;
+        }
+    }
+    Close_file(temp_ifl);
+    Hash_template_states(temp);
+
+    return 0;
+}
+
+void Free_template(Gjf_template *temp)
+{
+    unsigned int iline = 0u;
+
+    for (iline = 0u; iline < temp->num_head_line; ++ iline)
+        free(temp->head_lines[iline]);
+    free(temp->head_lines);
+    temp->head_lines = NULL;
+    temp->num_head_line = 0u;
+    free(temp->title);
+    temp->title = NULL;
+    free(temp->body);
+    temp->body = NULL;
+
+    return;
+}
+
+/*
+    the word of route line saying the method and the basis set, like "LC-wPBE/6-311+G**", where '/' comes before
+    any '=' or '(' (unlike "IOp(3/107=...)"), and its length, NULL if there is none
+*/
+static char const *Find_method_word(char const *line, size_t *len_ptr)
+{
+    size_t len = 0u, slash = 0u;
+
+    while (* line)
+    {
+        line += strspn(line, " \t");
+        len = strcspn(line, " \t");
+        slash = strcspn(line, "/=(");
+        if (slash < len && line[slash] == '/')
+        {
+            * len_ptr = len;
+            return line;
+        }
+        line += len;
+    }
+
+    return NULL;
+}
+
+/*
+    Make low_temp a copy of temp at a lower fidelity for tuning w roughly: the basis set in the route section
+    replaced by basis unless it is NULL, and "SCF=Conver=<scf_conver>" added to it unless scf_conver is 0.
+    The results of low_temp have hashes of their own, so they are told apart from those of temp in the cache.
+    Free_template(low_temp) after use. Returns 0 on success.
+*/
+int Copy_template_at_fidelity(Gjf_template *low_temp, Gjf_template const *temp, char const *basis, \
+    unsigned int scf_conver)
+{
+    char const *word = NULL, *slash = NULL;
+    char old_basis[BUFSIZ + 1] = "";
+    size_t word_len = 0u, line_len = 0u;
+    unsigned int iline = 0u;
+    bool is_basis_replaced = false, is_scf_added = false;
+
+    * low_temp = * temp;
+    low_temp->head_lines = (char **)calloc(temp->num_head_line, sizeof(char *));
+    low_temp->title = (char *)malloc(strlen(temp->title) + 1u);
+    low_temp->body = (char *)malloc(strlen(temp->body) + 1u);
+    if (! low_temp->head_lines || ! low_temp->title || ! low_temp->body)
+    {
+        fprintf(stderr, "Error! Cannot allocate memory for the template at a lower fidelity.\n");
+        low_temp->num_head_line = 0u;
+        Free_template(low_temp);
+        return 1;
+    }
+    strcpy(low_temp->title, temp->title);
+    strcpy(low_temp->body, temp->body);
+    for (iline = 0u; iline < temp->num_head_line; ++ iline)
+    {
+        line_len = strlen(temp->head_lines[iline]);
+        low_temp->head_lines[iline] = (char *)malloc(line_len + (basis ? strlen(basis) : 0u) + 32u);
+        if (! low_temp->head_lines[iline])
+        {
+            fprintf(stderr, "Error! Cannot allocate memory for the template at a lower fidelity.\n");
+            Free_template(low_temp);
+            return 1;
+        }
+        strcpy(low_temp->head_lines[iline], temp->head_lines[iline]);
+        if (* temp->head_lines[iline] == '%')
+            continue;
+        if (scf_conver && Contains_nocase(temp->head_lines[iline], "scf"))
+        {
+            fprintf(stderr, "Error! Cannot loosen the SCF of a template which says \"SCF\" itself.\n");
+            Free_template(low_temp);
+            return 1;
+        }
+        if (basis && ! is_basis_replaced && (word = Find_method_word(temp->head_lines[iline], & word_len)))
+        {
+            slash = strchr(word, '/');
+            sprintf(old_basis, "%.*s", (int)(word + word_len - slash - 1), slash + 1);
+            if (Contains_nocase(old_basis, "gen"))
+            {
+                fprintf(stderr, "Error! Cannot replace the basis set of a template which gives it as \"Gen\".\n");
+                Free_template(low_temp);
+                return 1;
+            }
+            sprintf(low_temp->head_lines[iline] + (slash + 1 - temp->head_lines[iline]), "%s%s", basis, \
+                word + word_len);
+            is_basis_replaced = true;
+        }
+        if (scf_conver && ! is_scf_added)
+        {
+            sprintf(low_temp->head_lines[iline] + strlen(low_temp->head_lines[iline]), " SCF=Conver=%u", scf_conver);
+            is_scf_added = true;
+        }
+    }
+    if (basis && ! is_basis_replaced)
+    {
+        fprintf(stderr, "Error! Cannot find the basis set, like \"LC-wPBE/6-311+G**\", in the route section.\n");
+        Free_template(low_temp);
+        return 1;
+    }
+    Hash_template_states(low_temp);
+
+    return 0;
+}
+
+/*
+    Write the input of state at w into gjf_ofl, see Write_state_input. With is_from_chk, the geometry and the
+    SCF guess are read from chk_name, written by the step before in the same job, unless the route section of
+    the template says how to get them itself.
+*/
+static void Write_state_step(FILE *gjf_ofl, Gjf_template const *temp, unsigned int state, double w, \
+    unsigned int num_part, unsigned int i_part, char const *chk_name, char const *old_chk_name, bool is_from_chk, \
+    char const *gjf_name)
+{
+    unsigned int iline = 0u;
+    bool is_guess_given = false, is_geom_given = false, is_route_written = false;
+    char const *body = temp->body;
+
+    /* link 0, route section and a blank line followed */
+    if (temp->topo)
+        Write_pinned_link0(gjf_ofl, temp, num_part, i_part);
+    else if (temp->num_core)
+    {
+        for (iline = 0u; iline < temp->num_head_line; ++ iline)
+        {
+            if (Link0_value(temp->head_lines[iline], "CPU") || Link0_value(temp->head_lines[iline], "NProcShared") || \
+                Link0_value(temp->head_lines[iline], "NProc"))
+                break;
+        }
+        /* no processors given in the template, say it ourselves */
+        if (iline == temp->num_head_line)
+            Write_link0_line(gjf_ofl, "%NProcShared=1", num_part, i_part, temp->num_core, gjf_name);
+    }
+    if (chk_name)
+    {
+        if (old_chk_name && strcmp(old_chk_name, chk_name))
+            fprintf(gjf_ofl, "%%OldChk=%s\n", old_chk_name);
+        fprintf(gjf_ofl, "%%Chk=%s\n", chk_name);
+        /* the user knows better if the guess or the geometry is given in the template */
+        for (iline = 0u; iline < temp->num_head_line; ++ iline)
+        {
+            if (* temp->head_lines[iline] != '%' && Contains_nocase(temp->head_lines[iline], "guess"))
+                is_guess_given = true;
+            if (* temp->head_lines[iline] != '%' && Contains_nocase(temp->head_lines[iline], "geom"))
+                is_geom_given = true;
+        }
+    }
+    for (iline = 0u; iline < temp->num_head_line; ++ iline)
+    {
+        if (* temp->head_lines[iline] == '%')
+        {
+            if (chk_name && (Link0_value(temp->head_lines[iline], "Chk") || \
+                Link0_value(temp->head_lines[iline], "OldChk")))
+                continue;
+            if (temp->topo && (Link0_value(temp->head_lines[iline], "CPU") || \
+                Link0_value(temp->head_lines[iline], "NProcShared") || \
+                Link0_value(temp->head_lines[iline], "NProc") || Link0_value(temp->head_lines[iline], "Mem")))
+                continue;
+            Write_link0_line(gjf_ofl, temp->head_lines[iline], num_part, i_part, temp->num_core, gjf_name);
+        }
+        else if (* temp->head_lines[iline] == '#')
+        {
+            fprintf(gjf_ofl, "%s IOp(3/107=%05u00000,3/108=%05u00000)", temp->head_lines[iline], \
+                W_to_iop(w), W_to_iop(w));
+            if (chk_name && (old_chk_name || is_from_chk) && ! is_guess_given && ! is_route_written)
+                fprintf(gjf_ofl, " Guess=Read");
+            if (chk_name && is_from_chk && ! is_geom_given && ! is_route_written)
+                fprintf(gjf_ofl, " Geom=Check");
+            fprintf(gjf_ofl, "\n");
+            is_route_written = true;
+        }
+        else
+            fprintf(gjf_ofl, "%s\n", temp->head_lines[iline]);
+    }
+    fprintf(gjf_ofl, "\n");
+    /* title and a blank line followed */
+    fprintf(gjf_ofl, "%s", temp->title);
+    /* charge and multiplicity */
+    fprintf(gjf_ofl, "%d %u\n", temp->charges[state], temp->multis[state]);
+    /* atom coordinates and others, only the others if the geometry is read, after a blank line for none */
+    if (chk_name && is_from_chk && ! is_geom_given)
+    {
+        while (* body && * body != '\n')
+            body = strchr(body, '\n') ? strchr(body, '\n') + 1 : body + strlen(body);
+        if (* body)
+            ++ body;
+        fprintf(gjf_ofl, "\n");
+    }
+    fprintf(gjf_ofl, "%s", body);
+
+    return;
+}
+
+/*
+    Write the Gaussian input file of state at w.
+    The job is the i_part-th of num_part jobs which run at the same time (num_part is 1 if it runs alone).
+    If chk_name is not NULL, it replaces the checkpoint file in the template. Then if old_chk_name is not NULL,
+    the SCF guess is read from chk_name, after Gaussian copies old_chk_name to it if they are different.
+    Returns 0 on success.
+*/
+int Write_state_input(Gjf_template const *temp, unsigned int state, double w, \
+    unsigned int num_part, unsigned int i_part, char const *chk_name, char const *old_chk_name, char const *gjf_name)
+{
+    FILE *gjf_ofl = NULL;
+
+    gjf_ofl = fopen(gjf_name, "wt");
+    if (! gjf_ofl)
+    {
+        fprintf(stderr, "Error! Cannot open \"%s\" for writing.\n", gjf_name);
+        return 1;
+    }
+    Write_state_step(gjf_ofl, temp, state, w, num_part, i_part, chk_name, old_chk_name, false, gjf_name);
+    if (ferror(gjf_ofl))
+    {
+        fprintf(stderr, "Error! Failed to write \"%s\".\n", gjf_name);
+        Close_file(gjf_ofl);
+        return 1;
+    }
+    Close_file(gjf_ofl);
+
+    return 0;
+}
+
+/*
+    Write the Gaussian input file of the states in state_mask (1 << state for each) at w, a step for each
+    in the order of N, N+1 and N-1, chained by "--Link1--". The steps share the checkpoint file chk_name,
+    and every step but the first reads the geometry and the SCF guess from it. Returns 0 on success.
+*/
+static int Write_link1_input(Gjf_template const *temp, unsigned int state_mask, double w, \
+    unsigned int num_part, unsigned int i_part, char const *chk_name, char const *gjf_name)
+{
+    FILE *gjf_ofl = NULL;
+    unsigned int istate = 0u, num_step = 0u;
+
+    gjf_ofl = fopen(gjf_name, "wt");
+    if (! gjf_ofl)
+    {
+        fprintf(stderr, "Error! Cannot open \"%s\" for writing.\n", gjf_name);
+        return 1;
+    }
+    for (istate = 0u; istate < NUM_STATE; ++ istate)
+    {
+        if (! (state_mask & (1u << istate)))
+            continue;
+        /* a blank line more does no harm if the step ends with one already */
+        if (num_step ++)
+            fprintf(gjf_ofl, "\n--Link1--\n");
+        Write_state_step(gjf_ofl, temp, istate, w, num_part, i_part, chk_name, NULL, num_step > 1u, gjf_name);
+    }
+    if (ferror(gjf_ofl))
+    {
+        fprintf(stderr, "Error! Failed to write \"%s\".\n", gjf_name);
+        Close_file(gjf_ofl);
+        return 1;
+    }
+    Close_file(gjf_ofl);
+
+    return 0;
+}
+
+/* the number, from "%CPU" or "%NProcShared", 1 if neither is given. */
+unsigned int Count_template_cores(Gjf_template const *temp)
+{
+    unsigned int iline = 0u;
+    char const *value = NULL;
+    unsigned int *cpus = NULL;
+    unsigned int num_core = 0u;
+
+    for (iline = 0u; iline < temp->num_head_line; ++ iline)
+    {
+        if ((value = Link0_value(temp->head_lines[iline], "CPU")))
+        {
+            cpus = (unsigned int *)malloc(MAX_NUM_CPU * sizeof(unsigned int));
+            if (cpus)
+                num_core = Parse_cpu_list(value, cpus, MAX_NUM_CPU);
+            free(cpus);
+            cpus = NULL;
+        }
+        else if ((value = Link0_value(temp->head_lines[iline], "NProcShared")) || \
+            (value = Link0_value(temp->head_lines[iline], "NProc")))
+        {
+            if (sscanf(value, "%u", & num_core) != 1)
+                num_core = 0u;
+        }
+    }
+
+    return num_core ? num_core : 1u;
+}
+
+/* file_name, of size bytes, becomes something like "<prefix>Np1_tag.gjf", or "" and returns 1 if it does not fit. */
+int Get_state_file_name(char *file_name, size_t size, char const *prefix, unsigned int state, char const *tag, \
+    char const *extension)
+{
+    if (snprintf(file_name, size, "%s%s%s%s", prefix, state_stems[state], tag, extension) >= (int)size)
+    {
+        fprintf(stderr, "Error! File name \"%s%s%s%s\" is too long.\n", prefix, state_stems[state], tag, extension);
+        * file_name = '\0';
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+    the value written to IOp(3/107) and IOp(3/108) for w, in 1E-4, truncated,
+    but w like 0.29 (0.2899999...) and iop * 1E-4 are taken as on the lattice.
+*/
+unsigned int W_to_iop(double w)
+{
+    return (unsigned int)(w * 1E4 + 1E-6);
+}
+
+/* tag of the files of w, like "_02000" for w = 0.2000 */
+void Get_w_tag(char *tag, double w)
+{
+    sprintf(tag, "_%05u", W_to_iop(w));
+
+    return;
+}
+
+/*
+    file in dir keeping the input or the output of state at w, like "<dir>/benzene_Np1_02000.out" for
+    the prefix "mols/benzene_", so the files of a template are found whatever tag its jobs ran with.
+    record_name has size bytes, and becomes "" if the name does not fit, then 1 is returned.
+*/
+static int Get_record_name(char *record_name, size_t size, char const *dir, char const *prefix, unsigned int state, \
+    double w, char const *extension)
+{
+    char const *base = prefix + strlen(prefix);
+    char tag[BUFSIZ + 1] = "";
+    int length = 0;
+
+    while (base > prefix && base[- 1] != '/' && base[- 1] != '\\')
+        -- base;
+    Get_w_tag(tag, w);
+    # ifdef _WIN32
+    length = snprintf(record_name, size, "%s\\%s%s%s%s", dir, base, state_stems[state], tag, extension);
+    # else
+    length = snprintf(record_name, size, "%s/%s%s%s%s", dir, base, state_stems[state], tag, extension);
+    # endif
+    if (length < 0 || (size_t)length >= size)
+    {
+        * record_name = '\0';
+        return 1;
+    }
+
+    return 0;
+}
+
+/* create dir to keep the files of the jobs in, if it does not exist yet, returns 0 on success. */
+int Make_record_dir(char const *dir)
+{
+    struct stat dir_stat;
+
+    if (! stat(dir, & dir_stat))
+    {
+        if (dir_stat.st_mode & S_IFDIR)
+            return 0;
+        fprintf(stderr, "Error! \"%s\" exists but is not a directory.\n", dir);
+        return 1;
+    }
+    # ifdef _WIN32
+    if (_mkdir(dir))
+    # else
+    if (mkdir(dir, 0755))
+    # endif
+    {
+        fprintf(stderr, "Error! Cannot create directory \"%s\".\n", dir);
+        return 1;
+    }
+
+    return 0;
+}
+
+# ifndef _WIN32
+/* remove path, and everything in it if it is a directory, returns 0 on success. */
+static int Remove_tree(char const *path)
+{
+    struct stat path_stat;
+    DIR *dir = NULL;
+    struct dirent *entry = NULL;
+    char *entry_path = NULL;
+    int error = 0;
+
+    if (lstat(path, & path_stat))
+        return 1;
+    if (! S_ISDIR(path_stat.st_mode))
+        return remove(path) ? 1 : 0;
+    dir = opendir(path);
+    entry_path = (char *)malloc(strlen(path) + 256u + 2u);
+    if (! dir || ! entry_path)
+    {
+        if (dir)
+            closedir(dir);
+        free(entry_path);
+        return 1;
+    }
+    while ((entry = readdir(dir)))
+    {
+        if (! strcmp(entry->d_name, ".") || ! strcmp(entry->d_name, "..") || strlen(entry->d_name) > 255u)
+            continue;
+        sprintf(entry_path, "%s/%s", path, entry->d_name);
+        error |= Remove_tree(entry_path);
+    }
+    closedir(dir);
+    free(entry_path);
+
+    return rmdir(path) ? 1 : error;
+}
+
+/* the scratch directory of this run, removed on the way out (see Set_exit_cleanup) */
+static char scratch_to_remove[BUFSIZ + 1] = "";
+
+static void Remove_scratch_at_exit()
+{
+    if (* scratch_to_remove)
+        Remove_tree(scratch_to_remove);
+    * scratch_to_remove = '\0';
+
+    return;
+}
+# endif
+
+/*
+    Create a directory of this run in root, like "/dev/shm/dft_w.Xa81Qz", into scratch_dir, which is removed
+    with everything in it when we exit, even if the run fails or is interrupted. Returns 0 on success.
+*/
+int Make_scratch_dir(char *scratch_dir, char const *root)
+{
+    # ifndef _WIN32
+    if (strlen(root) + 16u > BUFSIZ)
+    {
+        fprintf(stderr, "Error! Scratch directory \"%s\" is too long.\n", root);
+        return 1;
+    }
+    sprintf(scratch_dir, "%s/dft_w.XXXXXX", root);
+    if (! mkdtemp(scratch_dir))
+    {
+        fprintf(stderr, "Error! Cannot create a directory in \"%s\".\n", root);
+        * scratch_dir = '\0';
+        return 1;
+    }
+    strcpy(scratch_to_remove, scratch_dir);
+    Set_exit_cleanup(Remove_scratch_at_exit);
+
+    return 0;
+    # else
+    fprintf(stderr, "Error! Scratch directory \"%s\" cannot be used on Windows.\n", root);
+    * scratch_dir = '\0';
+    return 1;
+    # endif
+}
+
+/*
+    where the files of a job go in calc->scratch_dir, like "<scratch_dir>/mols_benzene_" for the prefix
+    "mols/benzene_", so that the templates of a batch in different directories do not share names.
+    It becomes "" and 1 is returned if it does not fit in BUFSIZ + 1 bytes.
+*/
+static int Get_scratch_prefix(char *scratch_prefix, Dft_w_calc const *calc)
+{
+    char *flat = NULL;
+
+    if (snprintf(scratch_prefix, BUFSIZ + 1, "%s/%s", calc->scratch_dir, calc->file_prefix) > BUFSIZ)
+    {
+        fprintf(stderr, "Error! File name \"%s/%s\" is too long.\n", calc->scratch_dir, calc->file_prefix);
+        * scratch_prefix = '\0';
+        return 1;
+    }
+    /* all of it is there, so the prefix starts within it */
+    for (flat = scratch_prefix + strlen(calc->scratch_dir) + 1u; * flat; ++ flat)
+    {
+        if (* flat == '/' || * flat == '\\')
+            * flat = '_';
+    }
+
+    return 0;
+}
+
+/*
+    the directory of the job of state with tag in calc->scratch_dir, like "<scratch_dir>/mols_benzene_Np1_02000",
+    or "" if it does not fit in BUFSIZ + 1 bytes, then 1 is returned.
+*/
+static int Get_job_dir(char *job_dir, Dft_w_calc const *calc, unsigned int state, char const *tag)
+{
+    char scratch_prefix[BUFSIZ + 1] = "";
+
+    * job_dir = '\0';
+    if (Get_scratch_prefix(scratch_prefix, calc))
+        return 1;
+    if (snprintf(job_dir, BUFSIZ + 1, "%s%s%s", scratch_prefix, state_stems[state], tag) > BUFSIZ)
+    {
+        fprintf(stderr, "Error! File name \"%s%s%s\" is too long.\n", scratch_prefix, state_stems[state], tag);
+        * job_dir = '\0';
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+    file_name becomes the file of the job of state with tag, "<prefix>Np1_tag.gjf" in the working directory,
+    or "Np1.gjf" in the directory of the job (see Get_job_dir) with calc->scratch_dir.
+    It becomes "" and 1 is returned if it does not fit in BUFSIZ + 1 bytes.
+*/
+int Get_job_file_name(char *file_name, Dft_w_calc const *calc, unsigned int state, char const *tag, \
+    char const *extension)
+{
+    char job_dir[BUFSIZ + 1] = "";
+
+    if (! * calc->scratch_dir)
+        return Get_state_file_name(file_name, BUFSIZ + 1, calc->file_prefix, state, tag, extension);
+    if (Get_job_dir(job_dir, calc, state, tag))
+    {
+        * file_name = '\0';
+        return 1;
+    }
+    if (snprintf(file_name, BUFSIZ + 1, "%s/%s%s", job_dir, state_stems[state], extension) > BUFSIZ)
+    {
+        fprintf(stderr, "Error! File name \"%s/%s%s\" is too long.\n", job_dir, state_stems[state], extension);
+        * file_name = '\0';
+        return 1;
+    }
+
+    return 0;
+}
+
+static int Copy_file(char const *src_name, char const *dst_name)
+{
+    FILE *src_ifl = NULL, *dst_ofl = NULL;
+    char buf[BUFSIZ] = "";
+    size_t num_read = 0u;
+    int error = 0;
+
+    src_ifl = fopen(src_name, "rb");
+    if (! src_ifl)
+        return 1;
+    dst_ofl = fopen(dst_name, "wb");
+    if (! dst_ofl)
+    {
+        Close_file(src_ifl);
+        return 1;
+    }
+    while (! error && (num_read = fread(buf, 1u, BUFSIZ, src_ifl)))
+        error = fwrite(buf, 1u, num_read, dst_ofl) != num_read;
+    Close_file(src_ifl);
+    Close_file(dst_ofl);
+
+    return error;
+}
+
+/*
+    checkpoint file of state at IOp value iop, like "<prefix>Np1_02000.chk", in calc->scratch_dir if any,
+    or "" if it does not fit in BUFSIZ + 1 bytes, then 1 is returned.
+*/
+static int Get_chk_name(char *chk_name, Dft_w_calc const *calc, unsigned int state, unsigned int iop)
+{
+    char scratch_prefix[BUFSIZ + 1] = "";
+
+    * chk_name = '\0';
+    if (* calc->scratch_dir && Get_scratch_prefix(scratch_prefix, calc))
+        return 1;
+    if (snprintf(chk_name, BUFSIZ + 1, "%s%s_%05u.chk", * calc->scratch_dir ? scratch_prefix : calc->file_prefix, \
+        state_stems[state], iop) > BUFSIZ)
+    {
+        fprintf(stderr, "Error! Checkpoint file name of %s state is too long.\n", state_names[state]);
+        * chk_name = '\0';
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+    With calc->scratch_dir, copy the output of the job of state with tag, which failed, to "<prefix>Np1_tag.out"
+    in the working directory, so that it is not removed with the scratch directory.
+*/
+void Keep_failed_output(Dft_w_calc const *calc, unsigned int state, char const *tag)
+{
+    char out_name[BUFSIZ + 1] = "";
+    char kept_name[BUFSIZ + 1] = "";
+
+    if (! * calc->scratch_dir)
+        return;
+    Get_job_file_name(out_name, calc, state, tag, ".out");
+    if (Get_state_file_name(kept_name, BUFSIZ + 1, calc->file_prefix, state, tag, ".out"))
+        return;
+    if (Copy_file(out_name, kept_name))
+        fprintf(stderr, "Warning! Cannot keep \"%s\" as \"%s\".\n", out_name, kept_name);
+    else
+        fprintf(stderr, "The output of the job for %s state is kept as \"%s\".\n", state_names[state], kept_name);
+
+    return;
+}
+
+/* the checkpoint file of state kept with the IOp value nearest to iop, returns its index or -1 if none. */
+static int Find_nearest_chk(Dft_w_calc const *calc, unsigned int state, unsigned int iop)
+{
+    unsigned int ichk = 0u;
+    int inearest = -1;
+    unsigned int distance = 0u, nearest_distance = 0u;
+
+    for (ichk = 0u; ichk < calc->nums_chk[state]; ++ ichk)
+    {
+        distance = calc->chk_iops[state][ichk] > iop ? calc->chk_iops[state][ichk] - iop : \
+            iop - calc->chk_iops[state][ichk];
+        if (inearest < 0 || distance < nearest_distance)
+        {
+            inearest = (int)ichk;
+            nearest_distance = distance;
+        }
+    }
+
+    return inearest;
+}
+
+/*
+    Write "<state><tag>.gjf" for w, and the command which runs it into "<state><tag>.out".
+    The job is the i_part-th of num_part jobs which run at the same time (num_part is 1 if it runs alone).
+    With calc->scratch_dir, the files are in the directory of the job there instead (see Get_job_file_name),
+    which is its GAUSS_SCRDIR as well.
+    With calc->replay_dir, the output recorded there is copied in place instead, and the command is blank.
+    Returns 0 on success.
+*/
+int Prepare_state_job(Dft_w_calc const *calc, unsigned int state, double w, char const *tag, \
+    unsigned int num_part, unsigned int i_part, Gau_command *command)
+{
+    return Prepare_link1_job(calc, 1u << state, w, tag, num_part, i_part, command);
+}
+
+/* the first of the states in state_mask (1 << state for each), whose files a job of them all uses */
+static unsigned int First_state(unsigned int state_mask)
+{
+    unsigned int state = 0u;
+
+    while (state < NUM_STATE - 1u && ! (state_mask & (1u << state)))
+        ++ state;
+
+    return state;
+}
+
+/* how many states are in state_mask */
+unsigned int Count_states(unsigned int state_mask)
+{
+    unsigned int istate = 0u, num_state = 0u;
+
+    for (istate = 0u; istate < NUM_STATE; ++ istate)
+    {
+        if (state_mask & (1u << istate))
+            ++ num_state;
+    }
+
+    return num_state;
+}
+
+/* the names of the states in state_mask for printing, like "N,N+1,N-1" */
+void Get_states_label(char *label, unsigned int state_mask)
+{
+    unsigned int istate = 0u;
+
+    * label = '\0';
+    for (istate = 0u; istate < NUM_STATE; ++ istate)
+    {
+        if (! (state_mask & (1u << istate)))
+            continue;
+        if (* label)
+            strcat(label, ",");
+        strcat(label, state_names[istate]);
+    }
+
+    return;
+}
+
+/*
+    Like Prepare_state_job, but the job runs all the states in state_mask (1 << state for each) at w chained
+    by "--Link1--" (see Write_link1_input), with the files of the first of them, and "<state><tag>.chk" shared
+    by the steps. Its output is read by Finish_link1_job. With a single state, it is just Prepare_state_job.
+*/
+int Prepare_link1_job(Dft_w_calc const *calc, unsigned int state_mask, double w, char const *tag, \
+    unsigned int num_part, unsigned int i_part, Gau_command *command)
+{
+    unsigned int state = First_state(state_mask);
+    char gjf_name[BUFSIZ + 1] = "";
+    char out_name[BUFSIZ + 1] = "";
+    char chk_name[BUFSIZ + 1] = "";
+    char old_chk_name[BUFSIZ + 1] = "";
+    char record_name[2 * BUFSIZ + 2] = "";
+    char job_dir[BUFSIZ + 1] = "";
+    FILE *record_ifl = NULL;
+    int inearest = -1;
+
+    Clear_command(command);
+    if (* calc->scratch_dir && (Get_job_dir(job_dir, calc, state, tag) || Make_record_dir(job_dir)))
+        return 1;
+    /* the other files of the job have names no longer than these */
+    if (Get_job_file_name(gjf_name, calc, state, tag, ".gjf") || Get_job_file_name(out_name, calc, state, tag, ".out"))
+        return 1;
+    if (Count_states(state_mask) > 1u)
+    {
+        Get_job_file_name(chk_name, calc, state, tag, ".chk");
+        if (Write_link1_input(& calc->temp, state_mask, w, num_part, i_part, chk_name, gjf_name))
+            return 1;
+    }
+    else if (calc->is_chain_guess)
+    {
+        /* the first job of a state starts from scratch, but still leaves its checkpoint file for later ones */
+        if (Get_chk_name(chk_name, calc, state, W_to_iop(w)))
+            return 1;
+        inearest = Find_nearest_chk(calc, state, W_to_iop(w));
+        if (inearest >= 0)
+            Get_chk_name(old_chk_name, calc, state, calc->chk_iops[state][inearest]);
+        if (Write_state_input(& calc->temp, state, w, num_part, i_part, chk_name, \
+            inearest >= 0 ? old_chk_name : NULL, gjf_name))
+            return 1;
+    }
+    else if (Write_state_input(& calc->temp, state, w, num_part, i_part, NULL, NULL, gjf_name))
+        return 1;
+    if (* calc->replay_dir)
+    {
+        if (Get_record_name(record_name, sizeof(record_name), calc->replay_dir, calc->file_prefix, state, w, ".out"))
+        {
+            fprintf(stderr, "Error! The name of the output of %s state at w = %6.4lf recorded in \"%s\" is too long.\n", \
+                state_names[state], w, calc->replay_dir);
+            return 1;
+        }
+        record_ifl = fopen(record_name, "rb");
+        if (! record_ifl)
+        {
+            fprintf(stderr, "Error! No output of %s state at w = %6.4lf recorded, \"%s\" is missing.\n", \
+                state_names[state], w, record_name);
+            return 1;
+        }
+        Close_file(record_ifl);
+        if (Copy_file(record_name, out_name))
+        {
+            fprintf(stderr, "Error! Cannot copy \"%s\" to \"%s\".\n", record_name, out_name);
+            return 1;
+        }
+        /* nothing left to run, the job ends at once (see Start_job) */
+        return 0;
+    }
+    if (* calc->scratch_dir && \
+        snprintf(command->env, BUFSIZ + 1, "GAUSS_SCRDIR=%s", job_dir) > BUFSIZ)
+    {
+        fprintf(stderr, "Error! Scratch directory \"%s\" is too long.\n", job_dir);
+        return 1;
+    }
+    if (Add_command_arg(command, calc->gau_exe) || Add_command_arg(command, gjf_name) || \
+        Add_command_arg(command, out_name))
+        return 1;
+
+    return 0;
+}
+
+/*
+    Read the electron energy and the HOMO energy of a state from a Gaussian output file,
+    or from what stream has followed of it if it is not NULL. Returns 0 on success.
+*/
+static int Read_gau_output(char const *out_name, unsigned int state, Gau_log_stream *stream, \
+    double *E_ptr, double *e_HOMO_ptr, unsigned int *num_scf_cycle_ptr)
+{
+    Gau_log_info info;
+    int error = GAU_LOG_OK;
+
+    if (stream)
+    {
+        error = Finish_gau_log_stream(stream);
+        info = stream->info;
+    }
+    else
+        error = Parse_gau_log(out_name, & info);
+    if (error)
+    {
+        fprintf(stderr, "Error! Cannot read energies of state %s from \"%s\": %s! Check your Gaussian output files.\n", \
+            state_names[state], out_name, Gau_log_error_string(error));
+        return 1;
+    }
+    * E_ptr = info.E_scf;
+    * e_HOMO_ptr = info.e_HOMO_alpha;
+    * num_scf_cycle_ptr = info.num_scf_cycle;
+
+    return 0;
+}
+
+/*
+    a hash of everything the results depend on but w, for telling the records of this template and objective
+    from others, the states not in objective are hashed as 0.
+*/
+unsigned long long Get_template_hash(Gjf_template const *temp, unsigned int objective)
+{
+    char hashes_str[NUM_STATE * 16u + 1u] = "";
+    unsigned int istate = 0u;
+
+    for (istate = 0u; istate < NUM_STATE; ++ istate)
+        sprintf(hashes_str + istate * 16u, "%016llx", objective & (1u << istate) ? temp->state_hashes[istate] : 0ull);
+
+    return Hash_string(0ull, hashes_str);
+}
+
+/* fill point of w from the journal, including J, returns true if it is found. */
+bool Look_up_point(Dft_w_calc const *calc, double w, Dft_w_point *point)
+{
+    if (! calc->journal || ! Look_up_journal(calc->journal, W_to_iop(w), point->E, point->e_HOMO))
+        return false;
+    point->w = w;
+    Calc_J_of_point(point, calc->objective);
+
+    return true;
+}
+
+/* record point into the journal, if there is one */
+void Record_point(Dft_w_calc *calc, Dft_w_point const *point, double seconds)
+{
+    if (calc->journal)
+        Append_journal(calc->journal, W_to_iop(point->w), point->w, point->E, point->e_HOMO, point->J, \
+            point->J_squared, seconds);
+
+    return;
+}
+
+/* fill the energies of state at w from the cache, returns true if they are found. */
+bool Look_up_state(Dft_w_calc const *calc, unsigned int state, double w, Dft_w_point *point)
+{
+    if (! * calc->cache_name)
+        return false;
+
+    return ! Look_up_cache(calc->cache_name, calc->temp.state_hashes[state], W_to_iop(w), \
+        & point->E[state], & point->e_HOMO[state]);
+}
+
+/*
+    Wait until the job in one of the slots ends, like Wait_any_slot.
+    If calc->is_supervised, the outputs of the running jobs are followed meanwhile, streams[i] for the job
+    in slots i, and a job is killed as soon as its output shows that it is bound to fail.
+    streams is not used otherwise and can be NULL.
+*/
+int Watch_any_slot(Dft_w_calc const *calc, Gau_slots *slots, Gau_log_stream *streams, \
+    unsigned int *task_id_ptr, int *exit_status_ptr)
+{
+    unsigned int islot = 0u;
+    int iended = -1;
+    int failure = 0;
+
+    if (! calc->is_supervised)
+        return Wait_any_slot(slots, task_id_ptr, exit_status_ptr);
+    while ((iended = Wait_any_slot_for(slots, WATCH_INTERVAL_MS, task_id_ptr, exit_status_ptr)) == GAU_RUN_TIMEOUT)
+    {
+        for (islot = 0u; islot < slots->num_slot; ++ islot)
+        {
+            if (! slots->jobs[islot].pid || streams[islot].failure)
+                continue;
+            if ((failure = Follow_gau_log_stream(& streams[islot])))
+            {
+                fprintf(stderr, "Error! Killing the job writing \"%s\": %s.\n", streams[islot].log_name, \
+                    Gau_log_error_string(failure));
+                Kill_job(& slots->jobs[islot]);
+            }
+        }
+    }
+
+    return iended;
+}
+
+/*
+    Print how much the job of state at w used after it ends, if calc->is_echo. Unless is_to_finish, that is its
+    output is going to be read by Finish_state, which traces it then, the job is put into the trace here.
+*/
+void Report_job(Dft_w_calc const *calc, unsigned int state, double w, Gau_job const *job, bool is_to_finish)
+{
+    Report_link1_job(calc, 1u << state, w, job, is_to_finish);
+
+    return;
+}
+
+/* like Report_job, for the job of the states in state_mask (see Prepare_link1_job) */
+void Report_link1_job(Dft_w_calc const *calc, unsigned int state_mask, double w, Gau_job const *job, \
+    bool is_to_finish)
+{
+    char label[NUM_STATE * 4u] = "";
+
+    Get_states_label(label, state_mask);
+    if (calc->is_echo)
+        printf("Gaussian job for %s state%s at w = %6.4lf took %.1lf s of CPU time and %.1lf MB of memory at most.\n", \
+            label, Count_states(state_mask) > 1u ? "s" : "", w, job->cpu_time, (double)job->max_rss_kb / 1024.0);
+    if (! is_to_finish)
+        Trace_job(calc->trace, calc->file_prefix, label, w, W_to_iop(w), job, false, 0.0, 0u);
+
+    return;
+}
+
+/* copy the input and the output of the job of state at w into calc->record_dir */
+static void Record_job_files(Dft_w_calc const *calc, unsigned int state, double w, char const *tag)
+{
+    char const *const extensions[2] = {".gjf", ".out"};
+    unsigned int iextension = 0u;
+    char file_name[BUFSIZ + 1] = "";
+    char record_name[2 * BUFSIZ + 2] = "";
+
+    for (iextension = 0u; iextension < 2u; ++ iextension)
+    {
+        Get_job_file_name(file_name, calc, state, tag, extensions[iextension]);
+        if (Get_record_name(record_name, sizeof(record_name), calc->record_dir, calc->file_prefix, state, w, \
+            extensions[iextension]))
+            fprintf(stderr, "Warning! Cannot record \"%s\" in \"%s\": the name is too long.\n", \
+                file_name, calc->record_dir);
+        else if (Copy_file(file_name, record_name))
+            fprintf(stderr, "Warning! Cannot record \"%s\" as \"%s\".\n", file_name, record_name);
+    }
+
+    return;
+}
+
+/*
+    Read "<state><tag>.out" of w after job ends (or take what stream has read from it, if it is not NULL),
+    put the energies into the cache, and remember the checkpoint file it leaves for later jobs.
+    With calc->record_dir, the input and the output are copied there first, even if they cannot be read.
+    The job is put into the trace with what was read. Returns 0 on success.
+*/
+int Finish_state(Dft_w_calc *calc, unsigned int state, double w, char const *tag, Gau_job const *job, \
+    Gau_log_stream *stream, Dft_w_point *point)
+{
+    char out_name[BUFSIZ + 1] = "";
+    unsigned int *new_chk_iops = NULL;
+    unsigned int num_scf_cycle = 0u;
+    int inearest = -1;
+    double time_parse_start = 0.0;
+    bool is_parsed = false;
+
+    Get_job_file_name(out_name, calc, state, tag, ".out");
+    if (* calc->record_dir)
+        Record_job_files(calc, state, w, tag);
+    time_parse_start = Get_monotonic_time();
+    is_parsed = ! Read_gau_output(out_name, state, stream, & point->E[state], & point->e_HOMO[state], & num_scf_cycle);
+    Trace_job(calc->trace, calc->file_prefix, state_names[state], w, W_to_iop(w), job, is_parsed, \
+        Get_monotonic_time() - time_parse_start, num_scf_cycle);
+    if (! is_parsed)
+    {
+        Keep_failed_output(calc, state, tag);
+        return 1;
+    }
+    if (calc->is_chain_guess)
+    {
+        inearest = Find_nearest_chk(calc, state, W_to_iop(w));
+        if (inearest < 0 || calc->chk_iops[state][inearest] != W_to_iop(w))
+        {
+            new_chk_iops = (unsigned int *)realloc(calc->chk_iops[state], \
+                (calc->nums_chk[state] + 1u) * sizeof(unsigned int));
+            if (new_chk_iops)
+            {
+                calc->chk_iops[state] = new_chk_iops;
+                calc->chk_iops[state][calc->nums_chk[state] ++] = W_to_iop(w);
+            }
+        }
+    }
+    if (* calc->cache_name)
+        Store_in_cache(calc->cache_name, calc->temp.state_hashes[state], W_to_iop(w), state_stems[state], \
+            point->E[state], point->e_HOMO[state]);
+
+    return 0;
+}
+
+/*
+    Like Finish_state, for the job of the states in state_mask at w (see Prepare_link1_job), whose output is
+    split into the steps of the states. The states read fine are put into the cache even if a later one fails.
+    stream is only used if there is a single state, the job is just that of Prepare_state_job then.
+*/
+int Finish_link1_job(Dft_w_calc *calc, unsigned int state_mask, double w, char const *tag, Gau_job const *job, \
+    Gau_log_stream *stream, Dft_w_point *point)
+{
+    unsigned int state = First_state(state_mask);
+    char out_name[BUFSIZ + 1] = "";
+    char label[NUM_STATE * 4u] = "";
+    Gau_log_info info;
+    unsigned int istate = 0u, istep = 0u;
+    unsigned int num_scf_cycle = 0u;
+    int error = GAU_LOG_OK;
+    double time_parse_start = 0.0;
+
+    if (Count_states(state_mask) < 2u)
+        return Finish_state(calc, state, w, tag, job, stream, point);
+    Get_job_file_name(out_name, calc, state, tag, ".out");
+    if (* calc->record_dir)
+        Record_job_files(calc, state, w, tag);
+    time_parse_start = Get_monotonic_time();
+    for (istate = 0u; istate < NUM_STATE && ! error; ++ istate)
+    {
+        if (! (state_mask & (1u << istate)))
+            continue;
+        if ((error = Parse_gau_log_step(out_name, istep ++, & info)))
+        {
+            fprintf(stderr, "Error! Cannot read energies of state %s from \"%s\": %s! " \
+                "Check your Gaussian output files.\n", state_names[istate], out_name, Gau_log_error_string(error));
+            break;
+        }
+        point->E[istate] = info.E_scf;
+        point->e_HOMO[istate] = info.e_HOMO_alpha;
+        num_scf_cycle += info.num_scf_cycle;
+        if (* calc->cache_name)
+            Store_in_cache(calc->cache_name, calc->temp.state_hashes[istate], W_to_iop(w), state_stems[istate], \
+                point->E[istate], point->e_HOMO[istate]);
+    }
+    Get_states_label(label, state_mask);
+    Trace_job(calc->trace, calc->file_prefix, label, w, W_to_iop(w), job, ! error, \
+        Get_monotonic_time() - time_parse_start, num_scf_cycle);
+    if (error)
+    {
+        Keep_failed_output(calc, state, tag);
+        return 1;
+    }
+
+    return 0;
+}
+
+/* calculate J and J^2 after the energies of the states in objective are known */
+void Calc_J_of_point(Dft_w_point *point, unsigned int objective)
+{
+    point->J_n = 0.0;
+    if (objective & (1u << STATE_NM1))
+        point->J_n = point->e_HOMO[STATE_N] + point->E[STATE_NM1] - point->E[STATE_N];
+    point->J_np1 = 0.0;
+    if (objective & (1u << STATE_NP1))
+        point->J_np1 = point->e_HOMO[STATE_NP1] + point->E[STATE_N] - point->E[STATE_NP1];
+    point->J = fabs(point->J_n) + fabs(point->J_np1);
+    point->J_squared = point->J_n * point->J_n + point->J_np1 * point->J_np1;
+
+    return;
+}
+
+/*
+    Run the jobs of the states in run_states at w while following their outputs, concurrently or one by one,
+    and read their energies into point. As soon as one job fails, the others are killed and the rest are not
+    started. Returns 0 on success.
+*/
+static int Run_states_supervised(Dft_w_calc *calc, double w, unsigned int num_run, unsigned int const *run_states, \
+    Gau_command const *commands, Dft_w_point *point)
+{
+    Gau_slots slots;
+    Gau_log_stream streams[NUM_STATE];
+    char out_name[BUFSIZ + 1] = "";
+    unsigned int next_run = 0u, irun = 0u;
+    int islot = -1;
+    int exit_status = 0;
+    bool is_failed = false;
+
+    if (Init_slots(& slots, calc->is_concurrent ? num_run : 1u))
+        return 1;
+    slots.timeout_s = calc->job_timeout;
+    for (;;)
+    {
+        while (! is_failed && next_run < num_run && (islot = Find_free_slot(& slots)) >= 0)
+        {
+            if (calc->is_echo)
+            {
+                printf("Running Gaussian for %s state:\n", state_names[run_states[next_run]]);
+                Print_command(& commands[next_run]);
+            }
+            Get_job_file_name(out_name, calc, run_states[next_run], "", ".out");
+            Init_gau_log_stream(& streams[islot], out_name, calc->max_scf_cycle);
+            if (Start_in_slot(& slots, (unsigned int)islot, next_run, & commands[next_run]))
+                is_failed = true;
+            ++ next_run;
+        }
+        if ((islot = Watch_any_slot(calc, & slots, streams, & irun, & exit_status)) < 0)
+            break;
+        Report_job(calc, run_states[irun], w, & slots.jobs[islot], ! is_failed && ! exit_status);
+        if (is_failed)
+            continue;
+        if (exit_status)
+        {
+            fprintf(stderr, "Error! Gaussian job for %s state failed with exit status %d.\n", \
+                state_names[run_states[irun]], exit_status);
+            Keep_failed_output(calc, run_states[irun], "");
+        }
+        if (exit_status || Finish_state(calc, run_states[irun], w, "", & slots.jobs[islot], & streams[islot], point))
+        {
+            is_failed = true;
+            Kill_all_slots(& slots);
+        }
+    }
+    Free_slots(& slots);
+
+    return is_failed ? 1 : 0;
+}
+
+/*
+    Run the states in run_states at w in one job chained by "--Link1--" (see Prepare_link1_job) while following
+    its output if calc->is_supervised, and read their energies into point. Returns 0 on success.
+*/
+static int Run_states_link1(Dft_w_calc *calc, double w, unsigned int num_run, unsigned int const *run_states, \
+    Dft_w_point *point)
+{
+    Gau_slots slots;
+    Gau_log_stream stream;
+    char out_name[BUFSIZ + 1] = "";
+    Gau_command command;
+    char label[NUM_STATE * 4u] = "";
+    unsigned int state_mask = 0u, irun = 0u, itask = 0u;
+    int islot = -1;
+    int exit_status = 0;
+    bool is_failed = false;
+
+    for (irun = 0u; irun < num_run; ++ irun)
+        state_mask |= 1u << run_states[irun];
+    Get_states_label(label, state_mask);
+    if (Prepare_link1_job(calc, state_mask, w, "", 1u, 0u, & command) || Init_slots(& slots, 1u))
+        return 1;
+    slots.timeout_s = calc->job_timeout;
+    if (calc->is_echo)
+    {
+        printf("Running Gaussian for %s states in one job:\n", label);
+        Print_command(& command);
+    }
+    Get_job_file_name(out_name, calc, run_states[0], "", ".out");
+    Init_gau_log_stream(& stream, out_name, calc->max_scf_cycle);
+    if (Start_in_slot(& slots, 0u, 0u, & command) || \
+        (islot = Watch_any_slot(calc, & slots, & stream, & itask, & exit_status)) < 0)
+        is_failed = true;
+    else
+    {
+        Report_link1_job(calc, state_mask, w, & slots.jobs[islot], ! exit_status);
+        if (exit_status)
+        {
+            fprintf(stderr, "Error! Gaussian job for %s states failed with exit status %d.\n", label, exit_status);
+            Keep_failed_output(calc, run_states[0], "");
+            is_failed = true;
+        }
+        else if (Finish_link1_job(calc, state_mask, w, "", & slots.jobs[islot], NULL, point))
+            is_failed = true;
+    }
+    Free_slots(& slots);
+
+    return is_failed ? 1 : 0;
+}
+
+/*
+    Run Gaussian for N, N+1 and N-1 states at w (only those in calc->objective), and calculate J and J^2 from the
+    outputs. States found in the cache are not run again, and with calc->is_link1, the others run in a single job.
+    The files used are "N.gjf", "N.out", "Np1.gjf", "Np1.out", "Nm1.gjf" and "Nm1.out".
+    Returns 0 on success.
+*/
+int Calc_J_from_w(Dft_w_calc *calc, double w, Dft_w_point *point)
+{
+    unsigned int istate = 0u, irun = 0u;
+    unsigned int num_run = 0u;
+    unsigned int run_states[NUM_STATE] = {0u};
+    Gau_command commands[NUM_STATE];
+    Gau_job jobs[NUM_STATE];
+    unsigned int num_ended = 0u;
+    int num_failed = 0;
+    double time_start = Get_monotonic_time();
+
+    memset(point, 0, sizeof(Dft_w_point));
+    point->w = w;
+    if (Look_up_point(calc, w, point))
+    {
+        if (calc->is_echo)
+            printf("Found w = %6.4lf in journal.\n", w);
+        return 0;
+    }
+    for (istate = 0u; istate < NUM_STATE; ++ istate)
+    {
+        if (! (calc->objective & (1u << istate)))
+            continue;
+        if (Look_up_state(calc, istate, w, point))
+        {
+            if (calc->is_echo)
+                printf("Found %s state in cache.\n", state_names[istate]);
+        }
+        else
+            run_states[num_run ++] = istate;
+    }
+
+    if (calc->is_link1 && num_run > 1u)
+    {
+        if (Run_states_link1(calc, w, num_run, run_states, point))
+        {
+            fprintf(stderr, "Check your template file and temporary Gaussian output files.\n");
+            return 1;
+        }
+        Calc_J_of_point(point, calc->objective);
+        point->seconds = Get_monotonic_time() - time_start;
+        Record_point(calc, point, point->seconds);
+        return 0;
+    }
+
+    /* prepare files */
+    for (irun = 0u; irun < num_run; ++ irun)
+    {
+        if (Prepare_state_job(calc, run_states[irun], w, "", calc->is_concurrent ? num_run : 1u, \
+            calc->is_concurrent ? irun : 0u, & commands[irun]))
+            return 1;
+    }
+
+    /* Invoke Gaussian */
+    if (calc->is_supervised)
+    {
+        if (Run_states_supervised(calc, w, num_run, run_states, commands, point))
+        {
+            fprintf(stderr, "Check your template file and temporary Gaussian output files.\n");
+            return 1;
+        }
+        Calc_J_of_point(point, calc->objective);
+        point->seconds = Get_monotonic_time() - time_start;
+        Record_point(calc, point, point->seconds);
+        return 0;
+    }
+    if (calc->is_concurrent && num_run > 1u)
+    {
+        if (calc->is_echo)
+        {
+            printf("Running Gaussian for %u states concurrently:\n", num_run);
+            for (irun = 0u; irun < num_run; ++ irun)
+                Print_command(& commands[irun]);
+        }
+        num_failed = Run_commands(commands, num_run, true, calc->job_timeout, jobs);
+        num_ended = num_run;
+        for (irun = 0u; irun < num_run; ++ irun)
+            Report_job(calc, run_states[irun], w, & jobs[irun], ! jobs[irun].exit_status);
+        if (num_failed)
+        {
+            for (irun = 0u; irun < num_run; ++ irun)
+            {
+                if (jobs[irun].exit_status)
+                {
+                    fprintf(stderr, "Error! Gaussian job for %s state failed with exit status %d.\n", \
+                        state_names[run_states[irun]], jobs[irun].exit_status);
+                    Keep_failed_output(calc, run_states[irun], "");
+                }
+                else
+                    fprintf(stderr, "Gaussian job for %s state terminated normally.\n", \
+                        state_names[run_states[irun]]);
+            }
+        }
+    }
+    else
+    {
+        for (irun = 0u; irun < num_run; ++ irun)
+        {
+            if (calc->is_echo)
+            {
+                printf("Running Gaussian for %s state:\n", state_names[run_states[irun]]);
+                Print_command(& commands[irun]);
+            }
+            num_failed = Run_commands(& commands[irun], 1u, false, calc->job_timeout, & jobs[irun]);
+            ++ num_ended;
+            Report_job(calc, run_states[irun], w, & jobs[irun], ! num_failed);
+            if (num_failed)
+            {
+                fprintf(stderr, "Error! Gaussian job for %s state failed with exit status %d.\n", \
+                    state_names[run_states[irun]], jobs[irun].exit_status);
+                Keep_failed_output(calc, run_states[irun], "");
+                break;
+            }
+        }
+    }
+
+    /* Calculates J^2 and J, the states which ran fine are read (and cached) even if another one failed */
+    for (irun = 0u; irun < num_ended; ++ irun)
+    {
+        if (! jobs[irun].exit_status && Finish_state(calc, run_states[irun], w, "", & jobs[irun], NULL, point))
+            ++ num_failed;
+    }
+    if (num_failed)
+    {
+        fprintf(stderr, "Check your template file and temporary Gaussian output files.\n");
+        return 1;
+    }
+    Calc_J_of_point(point, calc->objective);
+    point->seconds = Get_monotonic_time() - time_start;
+    Record_point(calc, point, point->seconds);
+
+    return 0;
+}
+
+/*
+    Evaluate at most max_eval w at the same time, each with the jobs of its states in a slot of their own
+    (a slot for each state in calc->objective with calc->is_concurrent, and 1 otherwise or with calc->is_link1,
+    where the states of a w run in a single job), so the processors and memory in the template are split among
+    max_eval times that many jobs. Returns 0 on success.
+*/
+int Init_pool(Dft_w_pool *pool, Dft_w_calc *calc, unsigned int max_eval)
+{
+    return Init_shared_pool(pool, calc, max_eval, \
+        max_eval * (calc->is_concurrent && ! calc->is_link1 ? Count_states(calc->objective) : 1u));
+}
+
+/*
+    Like Init_pool, but the jobs of at most max_eval w, of calc or of any other template given to Start_point_of,
+    share num_slot slots, and the processors and memory in each template are split among num_slot jobs.
+    Whether the jobs are supervised is taken from calc for all of them.
+*/
+int Init_shared_pool(Dft_w_pool *pool, Dft_w_calc *calc, unsigned int max_eval, unsigned int num_slot)
+{
+    memset(pool, 0, sizeof(Dft_w_pool));
+    pool->calc = calc;
+    pool->max_eval = max_eval;
+    pool->evals = (Dft_w_eval *)calloc(max_eval, sizeof(Dft_w_eval));
+    pool->streams = (Gau_log_stream *)calloc(num_slot, sizeof(Gau_log_stream));
+    if (! pool->evals || ! pool->streams || Init_slots(& pool->slots, num_slot))
+    {
+        fprintf(stderr, "Error! Cannot allocate memory for evaluating %u w at the same time.\n", max_eval);
+        free(pool->evals);
+        free(pool->streams);
+        memset(pool, 0, sizeof(Dft_w_pool));
+        return 1;
+    }
+    pool->slots.timeout_s = calc->job_timeout;
+
+    return 0;
+}
+
+static void Release_eval(Dft_w_pool *pool, unsigned int ieval)
+{
+    char tag[BUFSIZ + 1] = "";
+
+    Get_w_tag(tag, pool->evals[ieval].point.w);
+    Remove_state_files(pool->evals[ieval].calc, tag);
+    memset(& pool->evals[ieval], 0, sizeof(Dft_w_eval));
+
+    return;
+}
+
+/* kill the jobs running for evals[ieval] */
+static void Kill_eval_jobs(Dft_w_pool *pool, unsigned int ieval)
+{
+    unsigned int islot = 0u;
+
+    for (islot = 0u; islot < pool->slots.num_slot; ++ islot)
+    {
+        if (pool->slots.jobs[islot].pid && pool->slots.task_ids[islot] / NUM_STATE == ieval)
+            Kill_job(& pool->slots.jobs[islot]);
+    }
+
+    return;
+}
+
+/* kill whatever is still running, wait for it, and remove the files left */
+void Free_pool(Dft_w_pool *pool)
+{
+    unsigned int ieval = 0u, itask = 0u;
+    int exit_status = 0;
+
+    if (! pool->evals)
+        return;
+    Kill_all_slots(& pool->slots);
+    while (Wait_any_slot(& pool->slots, & itask, & exit_status) >= 0)
+        ;
+    for (ieval = 0u; ieval < pool->max_eval; ++ ieval)
+    {
+        if (pool->evals[ieval].is_used)
+            Release_eval(pool, ieval);
+    }
+    Free_slots(& pool->slots);
+    free(pool->evals);
+    free(pool->streams);
+    memset(pool, 0, sizeof(Dft_w_pool));
+
+    return;
+}
+
+/* start the jobs waiting, in the order their w were started, returns 0 on success. */
+static int Fill_pool(Dft_w_pool *pool)
+{
+    Dft_w_eval *eval = NULL;
+    unsigned int ieval = 0u, istate = 0u, ijob_state = 0u;
+    int ifirst = -1, islot = -1;
+    char tag[BUFSIZ + 1] = "";
+    char out_name[BUFSIZ + 1] = "";
+    char label[NUM_STATE * 4u] = "";
+    Gau_command command;
+
+    while ((islot = Find_free_slot(& pool->slots)) >= 0)
+    {
+        /* the earliest w with a state not started */
+        ifirst = -1;
+        for (ieval = 0u; ieval < pool->max_eval; ++ ieval)
+        {
+            eval = & pool->evals[ieval];
+            if (! eval->is_used || eval->is_cancelled || eval->is_failed || \
+                (eval->is_state_starteds[0] && eval->is_state_starteds[1] && eval->is_state_starteds[2]))
+                continue;
+            if (ifirst < 0 || eval->order < pool->evals[ifirst].order)
+                ifirst = (int)ieval;
+        }
+        if (ifirst < 0)
+            return 0;
+        eval = & pool->evals[ifirst];
+        for (istate = 0u; eval->is_state_starteds[istate]; ++ istate)
+            ;
+        /* with calc->is_link1, the states left all run in the job of the first of them */
+        eval->job_state_masks[istate] = 0u;
+        for (ijob_state = istate; ijob_state < NUM_STATE; ++ ijob_state)
+        {
+            if (! eval->is_state_starteds[ijob_state] && (ijob_state == istate || eval->calc->is_link1))
+            {
+                eval->is_state_starteds[ijob_state] = true;
+                eval->job_state_masks[istate] |= 1u << ijob_state;
+            }
+        }
+        Get_w_tag(tag, eval->point.w);
+        Get_job_file_name(out_name, eval->calc, istate, tag, ".out");
+        if (Prepare_link1_job(eval->calc, eval->job_state_masks[istate], eval->point.w, tag, pool->slots.num_slot, \
+            (unsigned int)islot, & command))
+        {
+            eval->is_failed = true;
+            return 1;
+        }
+        if (eval->calc->is_echo)
+        {
+            Get_states_label(label, eval->job_state_masks[istate]);
+            printf("Running Gaussian for %s state%s at w = %6.4lf:\n", label, \
+                Count_states(eval->job_state_masks[istate]) > 1u ? "s" : "", eval->point.w);
+            Print_command(& command);
+        }
+        Init_gau_log_stream(& pool->streams[islot], out_name, pool->calc->max_scf_cycle);
+        if (Start_in_slot(& pool->slots, (unsigned int)islot, (unsigned int)ifirst * NUM_STATE + istate, & command))
+        {
+            eval->is_failed = true;
+            return 1;
+        }
+        ++ eval->num_running;
+    }
+
+    return 0;
+}
+
+/* wait until one of the jobs ends and account for it, returns -1 if no job is running. */
+static int Reap_pool_job(Dft_w_pool *pool)
+{
+    Dft_w_eval *eval = NULL;
+    unsigned int ieval = 0u, istate = 0u, itask = 0u, state_mask = 0u;
+    int islot = -1, exit_status = 0;
+    char tag[BUFSIZ + 1] = "";
+    char label[NUM_STATE * 4u] = "";
+
+    islot = Watch_any_slot(pool->calc, & pool->slots, pool->streams, & itask, & exit_status);
+    if (islot < 0)
+        return -1;
+    ieval = itask / NUM_STATE;
+    istate = itask % NUM_STATE;
+    eval = & pool->evals[ieval];
+    state_mask = eval->job_state_masks[istate];
+    -- eval->num_running;
+    Report_link1_job(eval->calc, state_mask, eval->point.w, & pool->slots.jobs[islot], \
+        ! eval->is_cancelled && ! eval->is_failed && ! exit_status);
+    if (eval->is_cancelled || eval->is_failed)
+        return 0;
+    Get_w_tag(tag, eval->point.w);
+    if (exit_status)
+    {
+        Get_states_label(label, state_mask);
+        fprintf(stderr, "Error! Gaussian job for %s state%s at w = %6.4lf failed with exit status %d.\n", \
+            label, Count_states(state_mask) > 1u ? "s" : "", eval->point.w, exit_status);
+        Keep_failed_output(eval->calc, istate, tag);
+    }
+    if (exit_status || Finish_link1_job(eval->calc, state_mask, eval->point.w, tag, & pool->slots.jobs[islot], \
+        pool->calc->is_supervised ? & pool->streams[islot] : NULL, & eval->point))
+    {
+        /* the other states of this w are useless now */
+        eval->is_failed = true;
+        Kill_eval_jobs(pool, ieval);
+    }
+    else
+        eval->num_state_done += Count_states(state_mask);
+
+    return 0;
+}
+
+/*
+    Start evaluating J at w, the states found in the cache are not run again.
+    Returns 0 on success, and 1 if max_eval w are being evaluated already.
+*/
+int Start_point(Dft_w_pool *pool, double w)
+{
+    return Start_point_of(pool, pool->calc, w);
+}
+
+/* like Start_point, but w is for the template of calc */
+int Start_point_of(Dft_w_pool *pool, Dft_w_calc *calc, double w)
+{
+    Dft_w_eval *eval = NULL;
+    unsigned int ieval = 0u, istate = 0u;
+
+    /* the jobs of a w cancelled use the same files as those of it started again, so they have to be gone first */
+    for (ieval = 0u; ieval < pool->max_eval; ++ ieval)
+    {
+        eval = & pool->evals[ieval];
+        if (eval->is_used && eval->is_cancelled && eval->calc == calc && W_to_iop(eval->point.w) == W_to_iop(w))
+        {
+            while (eval->num_running && Reap_pool_job(pool) >= 0)
+                ;
+            Release_eval(pool, ieval);
+        }
+    }
+    /* the other w cancelled keep their places until their jobs are killed */
+    for (;;)
+    {
+        for (ieval = 0u; ieval < pool->max_eval; ++ ieval)
+        {
+            if (pool->evals[ieval].is_cancelled && ! pool->evals[ieval].num_running)
+                Release_eval(pool, ieval);
+            if (! pool->evals[ieval].is_used)
+                break;
+        }
+        if (ieval < pool->max_eval || Reap_pool_job(pool) < 0)
+            break;
+    }
+    if (ieval == pool->max_eval)
+    {
+        fprintf(stderr, "Error! Cannot evaluate more than %u w at the same time.\n", pool->max_eval);
+        return 1;
+    }
+    eval = & pool->evals[ieval];
+    memset(eval, 0, sizeof(Dft_w_eval));
+    eval->calc = calc;
+    eval->is_used = true;
+    eval->order = pool->num_started ++;
+    eval->point.w = w;
+    eval->time_start = Get_monotonic_time();
+    if (Look_up_point(calc, w, & eval->point))
+    {
+        if (calc->is_echo)
+            printf("Found w = %6.4lf in journal.\n", w);
+        eval->is_replayed = true;
+        for (istate = 0u; istate < NUM_STATE; ++ istate)
+            eval->is_state_starteds[istate] = true;
+        eval->num_state_done = NUM_STATE;
+        return 0;
+    }
+    /* the states not in the objective are never run */
+    for (istate = 0u; istate < NUM_STATE; ++ istate)
+    {
+        if (! (calc->objective & (1u << istate)) || Look_up_state(calc, istate, w, & eval->point))
+        {
+            eval->is_state_starteds[istate] = true;
+            ++ eval->num_state_done;
+        }
+    }
+    Fill_pool(pool);
+
+    return 0;
+}
+
+/*
+    Wait until the evaluation of one w ends, and copy it into point.
+    Returns 0 on success, 1 if it failed (only point->w is set then), and -1 if nothing is being evaluated.
+*/
+int Wait_any_point(Dft_w_pool *pool, Dft_w_point *point)
+{
+    Dft_w_calc *calc = NULL;
+
+    return Wait_any_point_of(pool, & calc, point);
+}
+
+/* like Wait_any_point, and * calc_ptr becomes the one the w was started with */
+int Wait_any_point_of(Dft_w_pool *pool, Dft_w_calc **calc_ptr, Dft_w_point *point)
+{
+    Dft_w_eval *eval = NULL;
+    unsigned int ieval = 0u;
+    bool is_failed = false;
+
+    for (;;)
+    {
+        for (ieval = 0u; ieval < pool->max_eval; ++ ieval)
+        {
+            eval = & pool->evals[ieval];
+            if (! eval->is_used || eval->num_running)
+                continue;
+            if (eval->is_cancelled)
+                Release_eval(pool, ieval);
+            else if (eval->is_failed || eval->num_state_done == NUM_STATE)
+            {
+                is_failed = eval->is_failed;
+                * calc_ptr = eval->calc;
+                * point = eval->point;
+                if (! is_failed)
+                    Calc_J_of_point(point, eval->calc->objective);
+                if (! is_failed && ! eval->is_replayed)
+                {
+                    point->seconds = Get_monotonic_time() - eval->time_start;
+                    Record_point(eval->calc, point, point->seconds);
+                }
+                Release_eval(pool, ieval);
+                return is_failed ? 1 : 0;
+            }
+        }
+        Fill_pool(pool);
+        if (Reap_pool_job(pool) < 0)
+            return -1;
+    }
+}
+
+/* stop evaluating w of pool->calc, whose result is not wanted any more */
+void Cancel_point(Dft_w_pool *pool, double w)
+{
+    unsigned int ieval = 0u;
+
+    for (ieval = 0u; ieval < pool->max_eval; ++ ieval)
+    {
+        if (pool->evals[ieval].is_used && ! pool->evals[ieval].is_cancelled && \
+            pool->evals[ieval].calc == pool->calc && W_to_iop(pool->evals[ieval].point.w) == W_to_iop(w))
+        {
+            pool->evals[ieval].is_cancelled = true;
+            Kill_eval_jobs(pool, ieval);
+            if (! pool->evals[ieval].num_running)
+                Release_eval(pool, ieval);
+        }
+    }
+
+    return;
+}
+
+/*
+    remove "<prefix>N<tag>.gjf", "<prefix>N<tag>.out" and the same files of other states (and "<prefix>N<tag>.chk"
+    with calc->is_link1), or with calc->scratch_dir, the directories of those jobs with everything Gaussian
+    has left in them.
+*/
+void Remove_state_files(Dft_w_calc const *calc, char const *tag)
+{
+    unsigned int istate = 0u;
+    char file_name[BUFSIZ + 1] = "";
+
+    for (istate = 0u; istate < NUM_STATE; ++ istate)
+    {
+        # ifndef _WIN32
+        if (* calc->scratch_dir)
+        {
+            if (! Get_job_dir(file_name, calc, istate, tag))
+                Remove_tree(file_name);
+            continue;
+        }
+        # endif
+        Get_job_file_name(file_name, calc, istate, tag, ".gjf");
+        remove(file_name);
+        Get_job_file_name(file_name, calc, istate, tag, ".out");
+        remove(file_name);
+        if (calc->is_link1)
+        {
+            Get_job_file_name(file_name, calc, istate, tag, ".chk");
+            remove(file_name);
+        }
+    }
+
+    return;
+}
+
+/* remove the checkpoint files kept for guesses */
+void Remove_chk_files(Dft_w_calc *calc)
+{
+    unsigned int istate = 0u, ichk = 0u;
+    char chk_name[BUFSIZ + 1] = "";
+
+    for (istate = 0u; istate < NUM_STATE; ++ istate)
+    {
+        for (ichk = 0u; ichk < calc->nums_chk[istate]; ++ ichk)
+        {
+            if (! Get_chk_name(chk_name, calc, istate, calc->chk_iops[istate][ichk]))
+                remove(chk_name);
+        }
+        free(calc->chk_iops[istate]);
+        calc->chk_iops[istate] = NULL;
+        calc->nums_chk[istate] = 0u;
+    }
+
+    return;
+}
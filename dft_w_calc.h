@@ -0,0 +1,202 @@
+/* calculate J and J^2 of a given w (literally omega) with Gaussian, shared by optimize_DFT_w and scan_DFT_w */
+# ifndef DFT_W_CALC_H
+# define DFT_W_CALC_H
+
+# include <stdio.h>
+# include <stdbool.h>
+# include "gau_run.h"
+# include "gau_log.h"
+# include "dft_w_journal.h"
+# include "dft_w_trace.h"
+# include "node_topo.h"
+# include <time.h>
+
+/* the reference state, the state with an extra electron, and the state with an electron removed */
+# define NUM_STATE 3u
+# define STATE_N 0u
+# define STATE_NP1 1u
+# define STATE_NM1 2u
+
+/* what J is made of, as the states each needs: both J_N and J_N+1, J_N alone (the IP), or J_N+1 alone (the EA) */
+# define OBJECTIVE_J_BOTH ((1u << STATE_N) | (1u << STATE_NP1) | (1u << STATE_NM1))
+# define OBJECTIVE_J_N ((1u << STATE_N) | (1u << STATE_NM1))
+# define OBJECTIVE_J_NP1 ((1u << STATE_N) | (1u << STATE_NP1))
+
+extern char const *const state_names[NUM_STATE]; /* for printing: "N", "N+1" and "N-1" */
+extern char const *const state_stems[NUM_STATE]; /* for file names: "N", "Np1" and "Nm1" */
+
+/* the content of "template.gjf" split into pieces */
+typedef struct
+{
+    char **head_lines; /* Link 0 commands and route section, without line feeds */
+    unsigned int num_head_line;
+    char *title; /* title section and the blank line followed */
+    int charges[NUM_STATE];
+    unsigned int multis[NUM_STATE];
+    char *body; /* atom coordinates and others */
+    unsigned int num_core; /* processors shared by the jobs running at the same time, 0 for as in Link 0 */
+    unsigned long long state_hashes[NUM_STATE]; /* hash of everything the results of each state depend on, but w */
+    Node_topology const *topo; /* each job is pinned to a slice of its processors and memory, NULL for as in Link 0 */
+    double mem_bytes; /* with topo, the memory shared by the jobs running at the same time, 0 for as in Link 0 */
+} Gjf_template;
+
+/* everything needed to evaluate J at a given w */
+typedef struct
+{
+    Gjf_template temp;
+    char gau_exe[BUFSIZ + 1];
+    bool is_concurrent; /* run the jobs of N, N+1 and N-1 states at the same time */
+    bool is_echo; /* print the commands before running them */
+    char cache_name[BUFSIZ + 1]; /* file of results computed before, "" for not using */
+    bool is_chain_guess; /* start SCF from the checkpoint file of the nearest w computed before */
+    unsigned int *chk_iops[NUM_STATE]; /* IOp values of the checkpoint files kept for each state */
+    unsigned int nums_chk[NUM_STATE];
+    bool is_supervised; /* follow the outputs while the jobs run, and kill the jobs bound to fail */
+    unsigned int max_scf_cycle; /* a job running more SCF cycles is bound to fail, 0 for no limit */
+    Dft_w_journal *journal; /* where every w evaluated is recorded, and found again on resuming, NULL for none */
+    char file_prefix[BUFSIZ + 1]; /* put before the names of all the files of the jobs, like "mols/benzene_" */
+    unsigned int num_eval; /* w evaluated so far, for printing */
+    char record_dir[BUFSIZ + 1]; /* where the input and the output of every job are kept, "" for not keeping */
+    char replay_dir[BUFSIZ + 1]; /* where the outputs are taken from instead of running Gaussian, "" for running */
+    unsigned int job_timeout; /* seconds a job may run before it is killed, 0 for no limit */
+    Dft_w_trace *trace; /* where every job and every step of the optimizer are traced, NULL for none */
+    char scratch_dir[BUFSIZ + 1]; /* of this run, each job in a directory of its own there, "" for working here */
+    bool is_link1; /* run the states of a w not in the cache in a single job, chained by "--Link1--" */
+    unsigned int objective; /* OBJECTIVE_J_BOTH, OBJECTIVE_J_N or OBJECTIVE_J_NP1, the other states are not run */
+} Dft_w_calc;
+
+/* what we know about a single w */
+typedef struct
+{
+    double w;
+    double E[NUM_STATE]; /* electron energies */
+    double e_HOMO[NUM_STATE]; /* HOMO energies */
+    double J_n, J_np1; /* e_HOMO + IP of N and N+1 states, signed, 0 if not in the objective */
+    double J, J_squared;
+    double seconds; /* taken to evaluate it, 0 if it was found in the journal */
+} Dft_w_point;
+
+/* a w being evaluated in a Dft_w_pool */
+typedef struct
+{
+    Dft_w_calc *calc; /* of the template the w is for */
+    Dft_w_point point;
+    bool is_used;
+    bool is_cancelled; /* not wanted any more, waiting for its jobs to be killed */
+    bool is_failed;
+    bool is_state_starteds[NUM_STATE]; /* including those found in the cache */
+    unsigned int job_state_masks[NUM_STATE]; /* the states run by the job of each state, see Prepare_link1_job */
+    unsigned int num_state_done;
+    unsigned int num_running;
+    unsigned long order; /* earlier ones get the free slots first */
+    double time_start; /* by Get_monotonic_time */
+    bool is_replayed; /* found in the journal */
+} Dft_w_eval;
+
+/*
+    several w evaluated at the same time, of one template or more, the files of each tagged with its w.
+    The jobs of all the w share the slots, earlier w first.
+*/
+typedef struct
+{
+    Dft_w_calc *calc; /* the template of Start_point, and how the jobs are watched */
+    unsigned int max_eval;
+    Dft_w_eval *evals;
+    unsigned long num_started;
+    Gau_slots slots; /* the task of a job is its eval index * NUM_STATE + state */
+    Gau_log_stream *streams; /* for each slot */
+} Dft_w_pool;
+
+/* see dft_w_calc.c */
+
+int Find_gau_exe(char *gau_exe);
+
+int Parse_mem(char const *str, double *bytes_ptr);
+
+int Parse_objective(char const *str, unsigned int *objective_ptr);
+
+int Read_template(Gjf_template *temp, char const *temp_name, unsigned int multi_np1, unsigned int multi_nm1);
+
+void Free_template(Gjf_template *temp);
+
+int Copy_template_at_fidelity(Gjf_template *low_temp, Gjf_template const *temp, char const *basis, \
+    unsigned int scf_conver);
+
+int Write_state_input(Gjf_template const *temp, unsigned int state, double w, \
+    unsigned int num_part, unsigned int i_part, char const *chk_name, char const *old_chk_name, char const *gjf_name);
+
+unsigned int Count_template_cores(Gjf_template const *temp);
+
+unsigned int W_to_iop(double w);
+
+int Get_state_file_name(char *file_name, size_t size, char const *prefix, unsigned int state, char const *tag, \
+    char const *extension);
+
+void Get_w_tag(char *tag, double w);
+
+int Make_record_dir(char const *dir);
+
+int Make_scratch_dir(char *scratch_dir, char const *root);
+
+int Get_job_file_name(char *file_name, Dft_w_calc const *calc, unsigned int state, char const *tag, \
+    char const *extension);
+
+void Keep_failed_output(Dft_w_calc const *calc, unsigned int state, char const *tag);
+
+int Prepare_state_job(Dft_w_calc const *calc, unsigned int state, double w, char const *tag, \
+    unsigned int num_part, unsigned int i_part, Gau_command *command);
+
+unsigned int Count_states(unsigned int state_mask);
+
+void Get_states_label(char *label, unsigned int state_mask);
+
+int Prepare_link1_job(Dft_w_calc const *calc, unsigned int state_mask, double w, char const *tag, \
+    unsigned int num_part, unsigned int i_part, Gau_command *command);
+
+unsigned long long Get_template_hash(Gjf_template const *temp, unsigned int objective);
+
+bool Look_up_point(Dft_w_calc const *calc, double w, Dft_w_point *point);
+
+void Record_point(Dft_w_calc *calc, Dft_w_point const *point, double seconds);
+
+bool Look_up_state(Dft_w_calc const *calc, unsigned int state, double w, Dft_w_point *point);
+
+int Watch_any_slot(Dft_w_calc const *calc, Gau_slots *slots, Gau_log_stream *streams, \
+    unsigned int *task_id_ptr, int *exit_status_ptr);
+
+void Report_job(Dft_w_calc const *calc, unsigned int state, double w, Gau_job const *job, bool is_to_finish);
+
+void Report_link1_job(Dft_w_calc const *calc, unsigned int state_mask, double w, Gau_job const *job, \
+    bool is_to_finish);
+
+int Finish_state(Dft_w_calc *calc, unsigned int state, double w, char const *tag, Gau_job const *job, \
+    Gau_log_stream *stream, Dft_w_point *point);
+
+int Finish_link1_job(Dft_w_calc *calc, unsigned int state_mask, double w, char const *tag, Gau_job const *job, \
+    Gau_log_stream *stream, Dft_w_point *point);
+
+void Calc_J_of_point(Dft_w_point *point, unsigned int objective);
+
+int Calc_J_from_w(Dft_w_calc *calc, double w, Dft_w_point *point);
+
+int Init_pool(Dft_w_pool *pool, Dft_w_calc *calc, unsigned int max_eval);
+
+int Init_shared_pool(Dft_w_pool *pool, Dft_w_calc *calc, unsigned int max_eval, unsigned int num_slot);
+
+void Free_pool(Dft_w_pool *pool);
+
+int Start_point(Dft_w_pool *pool, double w);
+
+int Start_point_of(Dft_w_pool *pool, Dft_w_calc *calc, double w);
+
+int Wait_any_point(Dft_w_pool *pool, Dft_w_point *point);
+
+int Wait_any_point_of(Dft_w_pool *pool, Dft_w_calc **calc_ptr, Dft_w_point *point);
+
+void Cancel_point(Dft_w_pool *pool, double w);
+
+void Remove_state_files(Dft_w_calc const *calc, char const *tag);
+
+void Remove_chk_files(Dft_w_calc *calc);
+
+# endif /* DFT_W_CALC_H */
@@ -0,0 +1,153 @@
+/* journal of the w evaluated by a run, so that a run killed halfway can be resumed */
+
+# include "dft_w_journal.h"
+# include "dft_w_calc.h"
+# include <stdlib.h>
+# include <string.h>
+# ifdef _WIN32
+# include <io.h>
+# else
+# include <unistd.h>
+# endif
+
+# define Close_file(flp) fclose(flp); flp = NULL
+
+/*
+    The journal is plain text, one line for each w evaluated, appended and flushed to the disk
+    (fsync) as soon as the energies of all states are known:
+        <hash of the template> <IOp value> <w> <E of N, N+1, N-1> <HOMO energies of N, N+1, N-1> <J> <J^2> <seconds>
+    A line cut by a crash cannot be parsed and is skipped, so the journal is always usable.
+*/
+
+# define JOURNAL_HEADER "# hash iop w E_N E_N+1 E_N-1 e_HOMO_N e_HOMO_N+1 e_HOMO_N-1 J J^2 seconds\n"
+
+/* read the records of template_hash from the journal, returns 0 on success. */
+static int Read_journal(Dft_w_journal *journal)
+{
+    FILE *journal_ifl = NULL;
+    char buf[BUFSIZ + 1] = "";
+    unsigned long long hash = 0ull;
+    unsigned int iop = 0u, max_record = 0u;
+    double Es[NUM_STATE], e_HOMOs[NUM_STATE];
+    void *new_ptrs[3] = {NULL};
+
+    journal_ifl = fopen(journal->name, "rt");
+    if (! journal_ifl)
+        return 0;
+    while (fgets(buf, BUFSIZ, journal_ifl))
+    {
+        if (* buf == '#' || ! strchr(buf, '\n'))
+            continue;
+        if (sscanf(buf, "%llx %u %*g %lg %lg %lg %lg %lg %lg %*g %*g %*g", & hash, & iop, & Es[0], & Es[1], & Es[2], \
+            & e_HOMOs[0], & e_HOMOs[1], & e_HOMOs[2]) != 8 || hash != journal->template_hash)
+            continue;
+        if (journal->num_record == max_record)
+        {
+            max_record = max_record ? 2u * max_record : 16u;
+            new_ptrs[0] = realloc(journal->iops, max_record * sizeof(unsigned int));
+            if (new_ptrs[0])
+                journal->iops = (unsigned int *)new_ptrs[0];
+            new_ptrs[1] = realloc(journal->Es, max_record * NUM_STATE * sizeof(double));
+            if (new_ptrs[1])
+                journal->Es = (double *)new_ptrs[1];
+            new_ptrs[2] = realloc(journal->e_HOMOs, max_record * NUM_STATE * sizeof(double));
+            if (new_ptrs[2])
+                journal->e_HOMOs = (double *)new_ptrs[2];
+            if (! new_ptrs[0] || ! new_ptrs[1] || ! new_ptrs[2])
+            {
+                fprintf(stderr, "Error! Cannot allocate memory for reading journal \"%s\".\n", journal->name);
+                Close_file(journal_ifl);
+                return 1;
+            }
+        }
+        journal->iops[journal->num_record] = iop;
+        memcpy(journal->Es + journal->num_record * NUM_STATE, Es, NUM_STATE * sizeof(double));
+        memcpy(journal->e_HOMOs + journal->num_record * NUM_STATE, e_HOMOs, NUM_STATE * sizeof(double));
+        ++ journal->num_record;
+    }
+    Close_file(journal_ifl);
+
+    return 0;
+}
+
+/*
+    With is_resume, read the records of the template from the journal, and go on appending to it.
+    Otherwise start a new journal, replacing the old one. Returns 0 on success.
+*/
+int Open_journal(Dft_w_journal *journal, char const *name, unsigned long long template_hash, bool is_resume)
+{
+    FILE *journal_ofl = NULL;
+
+    memset(journal, 0, sizeof(Dft_w_journal));
+    strncpy(journal->name, name, BUFSIZ);
+    journal->template_hash = template_hash;
+    if (is_resume)
+        return Read_journal(journal);
+    journal_ofl = fopen(journal->name, "wt");
+    if (! journal_ofl)
+    {
+        fprintf(stderr, "Error! Cannot create journal \"%s\".\n", journal->name);
+        return 1;
+    }
+    fprintf(journal_ofl, "%s", JOURNAL_HEADER);
+    Close_file(journal_ofl);
+
+    return 0;
+}
+
+void Close_journal(Dft_w_journal *journal)
+{
+    free(journal->iops);
+    free(journal->Es);
+    free(journal->e_HOMOs);
+    memset(journal, 0, sizeof(Dft_w_journal));
+
+    return;
+}
+
+/* fill the energies of all states at IOp value iop, returns true if they are found. */
+bool Look_up_journal(Dft_w_journal const *journal, unsigned int iop, double *Es, double *e_HOMOs)
+{
+    unsigned int irecord = 0u;
+
+    /* the last one wins */
+    for (irecord = journal->num_record; irecord; -- irecord)
+    {
+        if (journal->iops[irecord - 1u] == iop)
+        {
+            memcpy(Es, journal->Es + (irecord - 1u) * NUM_STATE, NUM_STATE * sizeof(double));
+            memcpy(e_HOMOs, journal->e_HOMOs + (irecord - 1u) * NUM_STATE, NUM_STATE * sizeof(double));
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* append a record and make sure it is on the disk before returning, returns 0 on success. */
+int Append_journal(Dft_w_journal *journal, unsigned int iop, double w, double const *Es, double const *e_HOMOs, \
+    double J, double J_squared, double seconds)
+{
+    FILE *journal_ofl = NULL;
+    int error = 0;
+
+    journal_ofl = fopen(journal->name, "at");
+    if (! journal_ofl)
+    {
+        fprintf(stderr, "Warning! Cannot open journal \"%s\" for writing.\n", journal->name);
+        return 1;
+    }
+    fprintf(journal_ofl, "%016llx %05u %.4lf %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.0lf\n", \
+        journal->template_hash, iop, w, Es[0], Es[1], Es[2], e_HOMOs[0], e_HOMOs[1], e_HOMOs[2], J, J_squared, seconds);
+    error = fflush(journal_ofl) || ferror(journal_ofl);
+    # ifdef _WIN32
+    error = error || _commit(_fileno(journal_ofl));
+    # else
+    error = error || fsync(fileno(journal_ofl));
+    # endif
+    if (error)
+        fprintf(stderr, "Warning! Failed to write journal \"%s\".\n", journal->name);
+    Close_file(journal_ofl);
+
+    return error;
+}
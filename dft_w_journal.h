@@ -0,0 +1,30 @@
+/* journal of the w evaluated by a run, so that a run killed halfway can be resumed */
+# ifndef DFT_W_JOURNAL_H
+# define DFT_W_JOURNAL_H
+
+# include <stdio.h>
+# include <stdbool.h>
+
+/* the records read back from a journal, and where new ones go */
+typedef struct
+{
+    char name[BUFSIZ + 1];
+    unsigned long long template_hash; /* records of other templates are ignored */
+    unsigned int num_record;
+    unsigned int *iops;
+    double *Es; /* NUM_STATE for each record */
+    double *e_HOMOs; /* NUM_STATE for each record */
+} Dft_w_journal;
+
+/* see dft_w_journal.c */
+
+int Open_journal(Dft_w_journal *journal, char const *name, unsigned long long template_hash, bool is_resume);
+
+void Close_journal(Dft_w_journal *journal);
+
+bool Look_up_journal(Dft_w_journal const *journal, unsigned int iop, double *Es, double *e_HOMOs);
+
+int Append_journal(Dft_w_journal *journal, unsigned int iop, double w, double const *Es, double const *e_HOMOs, \
+    double J, double J_squared, double seconds);
+
+# endif /* DFT_W_JOURNAL_H */
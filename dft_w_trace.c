@@ -0,0 +1,111 @@
+/* trace of every Gaussian job and every step of the optimizer in JSON Lines, for looking at the performance */
+
+# include "dft_w_trace.h"
+# include <string.h>
+
+# define Close_file(flp) fclose(flp); flp = NULL
+
+/*
+    One JSON object on each line, flushed at once so that the trace can be followed while the run goes on.
+    Every record has "record" ("job" or "step"), "template" (the prefix of the files of the template, "" for
+    "template.gjf" in the current directory) and "t", the seconds from the start of the trace when it was written.
+    A job record is written when the job has ended and its output has been read:
+        "state", "w", "iop", "exit_status", "timed_out", "parsed" (whether the energies were read),
+        "spawn_s", "run_s", "parse_s", "cpu_s", "max_rss_kb" and "scf_cycles" (0 if not read).
+    A step record is written when J^2 of a w asked for by the optimizer is known:
+        "iteration", "w", "a" and "b" (the interval of uncertainty w was chosen in, null if the optimizer does
+        not tell), "step" ("guess", "golden", "parabolic", or what the optimizer is, like "scan"), "J_squared"
+        and "seconds" (taken by the step).
+    All times are from a monotonic clock.
+*/
+
+/* str as a JSON string, with quotes */
+static void Write_json_string(FILE *ofl, char const *str)
+{
+    fputc('"', ofl);
+    for (; * str; ++ str)
+    {
+        if (* str == '"' || * str == '\\')
+            fprintf(ofl, "\\%c", * str);
+        else if ((unsigned char)* str < 0x20u)
+            fprintf(ofl, "\\u%04x", (unsigned int)(unsigned char)* str);
+        else
+            fputc(* str, ofl);
+    }
+    fputc('"', ofl);
+
+    return;
+}
+
+/* the fields every record starts with */
+static void Write_record_head(Dft_w_trace const *trace, char const *record, char const *template_name)
+{
+    fprintf(trace->trace_ofl, "{\"record\": \"%s\", \"template\": ", record);
+    Write_json_string(trace->trace_ofl, template_name);
+    fprintf(trace->trace_ofl, ", \"t\": %.6lf", Get_monotonic_time() - trace->time_origin);
+
+    return;
+}
+
+/* start a new trace called name, replacing the old one. Returns 0 on success. */
+int Open_trace(Dft_w_trace *trace, char const *name)
+{
+    memset(trace, 0, sizeof(Dft_w_trace));
+    strncpy(trace->name, name, BUFSIZ);
+    trace->trace_ofl = fopen(name, "wt");
+    if (! trace->trace_ofl)
+    {
+        fprintf(stderr, "Error! Cannot open trace \"%s\" for writing.\n", name);
+        return 1;
+    }
+    trace->time_origin = Get_monotonic_time();
+
+    return 0;
+}
+
+void Close_trace(Dft_w_trace *trace)
+{
+    if (trace->trace_ofl)
+    {
+        Close_file(trace->trace_ofl);
+    }
+
+    return;
+}
+
+/* the record of a job of state_name at w which has ended, parse_time and num_scf_cycle are not used unless is_parsed */
+void Trace_job(Dft_w_trace *trace, char const *template_name, char const *state_name, double w, unsigned int iop, \
+    Gau_job const *job, bool is_parsed, double parse_time, unsigned int num_scf_cycle)
+{
+    if (! trace || ! trace->trace_ofl)
+        return;
+    Write_record_head(trace, "job", template_name);
+    fprintf(trace->trace_ofl, ", \"state\": \"%s\", \"w\": %.4lf, \"iop\": %u, \"exit_status\": %d, " \
+        "\"timed_out\": %s, \"parsed\": %s", state_name, w, iop, job->exit_status, \
+        job->is_timed_out ? "true" : "false", is_parsed ? "true" : "false");
+    fprintf(trace->trace_ofl, ", \"spawn_s\": %.6lf, \"run_s\": %.6lf, \"parse_s\": %.6lf, \"cpu_s\": %.6lf, " \
+        "\"max_rss_kb\": %ld, \"scf_cycles\": %u}\n", job->spawn_time, job->run_time, is_parsed ? parse_time : 0.0, \
+        job->cpu_time, job->max_rss_kb, is_parsed ? num_scf_cycle : 0u);
+    fflush(trace->trace_ofl);
+
+    return;
+}
+
+/* the record of the iter-th step of the optimizer, bracket is {a, b}, or NULL if not known */
+void Trace_step(Dft_w_trace *trace, char const *template_name, unsigned int iter, double w, double J_squared, \
+    double const *bracket, char const *step_type, double seconds)
+{
+    if (! trace || ! trace->trace_ofl)
+        return;
+    Write_record_head(trace, "step", template_name);
+    fprintf(trace->trace_ofl, ", \"iteration\": %u, \"w\": %.6lf", iter, w);
+    if (bracket)
+        fprintf(trace->trace_ofl, ", \"a\": %.6lf, \"b\": %.6lf", bracket[0], bracket[1]);
+    else
+        fprintf(trace->trace_ofl, ", \"a\": null, \"b\": null");
+    fprintf(trace->trace_ofl, ", \"step\": \"%s\", \"J_squared\": %.10lf, \"seconds\": %.6lf}\n", step_type, \
+        J_squared, seconds);
+    fflush(trace->trace_ofl);
+
+    return;
+}
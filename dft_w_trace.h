@@ -0,0 +1,29 @@
+/* trace of every Gaussian job and every step of the optimizer in JSON Lines, for looking at the performance */
+# ifndef DFT_W_TRACE_H
+# define DFT_W_TRACE_H
+
+# include <stdio.h>
+# include <stdbool.h>
+# include "gau_run.h"
+
+/* where the records go */
+typedef struct
+{
+    char name[BUFSIZ + 1];
+    FILE *trace_ofl;
+    double time_origin; /* by Get_monotonic_time, when the trace was opened */
+} Dft_w_trace;
+
+/* see dft_w_trace.c */
+
+int Open_trace(Dft_w_trace *trace, char const *name);
+
+void Close_trace(Dft_w_trace *trace);
+
+void Trace_job(Dft_w_trace *trace, char const *template_name, char const *state_name, double w, unsigned int iop, \
+    Gau_job const *job, bool is_parsed, double parse_time, unsigned int num_scf_cycle);
+
+void Trace_step(Dft_w_trace *trace, char const *template_name, unsigned int iter, double w, double J_squared, \
+    double const *bracket, char const *step_type, double seconds);
+
+# endif /* DFT_W_TRACE_H */
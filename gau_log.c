@@ -0,0 +1,538 @@
+/* extract energies from Gaussian output files */
+
+# ifndef _WIN32
+# define _GNU_SOURCE /* memrchr */
+# endif
+# include "gau_log.h"
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# ifndef _WIN32
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+# endif
+
+/*
+    The whole output is mapped into memory once, and everything is searched backward from its end,
+    so only the tail of the file after the last "SCF Done" is actually touched in the usual case.
+    Searching relies on memrchr() and memchr(), which are vectorized in glibc.
+*/
+
+/* bytes at the end of the file in which "Normal termination" is looked for */
+# define TERMINATION_TAIL 4096u
+
+/* eigenvalues are printed in fields of this width after "--" */
+# define EIGEN_FIELD_WIDTH 10u
+
+static char const *Rfind_char(char const *buf, int c, size_t len)
+{
+    # if defined(__GLIBC__)
+    return (char const *)memrchr(buf, c, len);
+    # else
+    while (len)
+    {
+        -- len;
+        if (buf[len] == (char)c)
+            return buf + len;
+    }
+    return NULL;
+    # endif
+}
+
+/* the last occurrence of needle in buf[0, len), or NULL */
+static char const *Rfind(char const *buf, size_t len, char const *needle)
+{
+    size_t needle_len = strlen(needle);
+    size_t num_candidate = 0u;
+    char const *candidate = NULL;
+
+    if (len < needle_len)
+        return NULL;
+    num_candidate = len - needle_len + 1u;
+    while (num_candidate)
+    {
+        candidate = Rfind_char(buf, * needle, num_candidate);
+        if (! candidate)
+            return NULL;
+        if (! memcmp(candidate, needle, needle_len))
+            return candidate;
+        num_candidate = (size_t)(candidate - buf);
+    }
+
+    return NULL;
+}
+
+/* whether [line, line_end) contains word */
+static bool Line_contains(char const *line, char const *line_end, char const *word)
+{
+    return Rfind(line, (size_t)(line_end - line), word) != NULL;
+}
+
+static char const *Line_start(char const *buf, char const *pos)
+{
+    char const *prev_lf = Rfind_char(buf, '\n', (size_t)(pos - buf));
+
+    return prev_lf ? prev_lf + 1 : buf;
+}
+
+static char const *Line_end(char const *pos, char const *buf_end)
+{
+    char const *lf = (char const *)memchr(pos, '\n', (size_t)(buf_end - pos));
+
+    return lf ? lf : buf_end;
+}
+
+/* start of the line before the one starting at line, or NULL if it is the first line */
+static char const *Prev_line(char const *buf, char const *line)
+{
+    if (line == buf)
+        return NULL;
+
+    return Line_start(buf, line - 1);
+}
+
+/*
+    Read the first and the last eigenvalues of a line like " Alpha  occ. eigenvalues --   -0.50000  -0.30000".
+    Fields are cut by their width, since large negative values are printed without spaces between them.
+    Returns the number of values read.
+*/
+static unsigned int Parse_eigen_line(char const *line, char const *line_end, double *first_ptr, double *last_ptr)
+{
+    char field[EIGEN_FIELD_WIDTH + 1u] = "";
+    char const *values = NULL;
+    size_t len = 0u;
+    unsigned int num_value = 0u, ivalue = 0u;
+
+    values = Rfind(line, (size_t)(line_end - line), "--");
+    if (! values)
+        return 0u;
+    values += 2;
+    if (values < line_end && * values == ' ') /* the label is " eigenvalues -- ", then 5F10.5 */
+        ++ values;
+    while (line_end > values && strchr(" \t\r\n", line_end[-1]) && line_end[-1])
+        -- line_end;
+    len = (size_t)(line_end - values);
+    num_value = (unsigned int)(len / EIGEN_FIELD_WIDTH);
+    if (! num_value || len % EIGEN_FIELD_WIDTH)
+        return 0u;
+    for (ivalue = 0u; ivalue < num_value; ivalue += num_value - 1u)
+    {
+        memcpy(field, values + ivalue * EIGEN_FIELD_WIDTH, EIGEN_FIELD_WIDTH);
+        field[EIGEN_FIELD_WIDTH] = '\0';
+        if (sscanf(field, "%lg", ivalue ? last_ptr : first_ptr) != 1)
+            return 0u;
+        if (num_value == 1u)
+        {
+            * last_ptr = * first_ptr;
+            break;
+        }
+    }
+
+    return num_value;
+}
+
+/*
+    Find the last block of "<spin> virt." lines in [from, buf_end), and read the HOMO from the "<spin>  occ." line
+    just before its first line, and the LUMO from its first line. Returns a GAU_LOG_* code.
+*/
+static int Parse_eigen_block(char const *buf, char const *from, char const *buf_end, char const *spin, \
+    double *e_HOMO_ptr, double *e_LUMO_ptr)
+{
+    char virt_word[32] = "";
+    char occ_word[32] = "";
+    char const *virt = NULL, *line = NULL, *prev = NULL;
+    double dummy = 0.0;
+
+    sprintf(virt_word, "%s virt.", spin);
+    sprintf(occ_word, "%s  occ.", spin);
+    virt = Rfind(from, (size_t)(buf_end - from), virt_word);
+    if (! virt)
+        return GAU_LOG_ERR_NO_EIGEN;
+    line = Line_start(buf, virt);
+    while ((prev = Prev_line(buf, line)) && Line_contains(prev, line, virt_word))
+        line = prev;
+    if (! Parse_eigen_line(line, Line_end(line, buf_end), e_LUMO_ptr, & dummy))
+        return GAU_LOG_ERR_BAD_EIGEN;
+    if (! prev || ! Line_contains(prev, line, occ_word) || ! Parse_eigen_line(prev, line, & dummy, e_HOMO_ptr))
+        return GAU_LOG_ERR_BAD_EIGEN;
+
+    return GAU_LOG_OK;
+}
+
+/* parse a Gaussian output already in memory, returns a GAU_LOG_* code. */
+int Parse_gau_log_buffer(char const *buf, size_t len, Gau_log_info *info)
+{
+    char const *buf_end = buf + len;
+    char const *scf = NULL, *scf_end = NULL, *tail = NULL;
+    char line[BUFSIZ + 1] = "";
+    char *value = NULL;
+    size_t line_len = 0u;
+    int error = GAU_LOG_OK;
+
+    memset(info, 0, sizeof(Gau_log_info));
+
+    /* electron energy of the last SCF */
+    scf = Rfind(buf, len, "SCF Done");
+    if (! scf)
+        return GAU_LOG_ERR_NO_SCF;
+    scf_end = Line_end(scf, buf_end);
+    line_len = (size_t)(scf_end - scf) < BUFSIZ ? (size_t)(scf_end - scf) : BUFSIZ;
+    memcpy(line, scf, line_len);
+    line[line_len] = '\0';
+    if (! (value = strchr(line, '=')) || sscanf(value + 1, "%lg", & info->E_scf) != 1)
+        return GAU_LOG_ERR_BAD_SCF;
+    if ((value = strstr(line, "after")))
+        sscanf(value + 5, "%u", & info->num_scf_cycle);
+
+    /* orbital energies printed after it */
+    error = Parse_eigen_block(buf, scf_end, buf_end, "Alpha", & info->e_HOMO_alpha, & info->e_LUMO_alpha);
+    if (error)
+        return error;
+    if (! Parse_eigen_block(buf, scf_end, buf_end, "Beta", & info->e_HOMO_beta, & info->e_LUMO_beta))
+        info->has_beta = true;
+
+    tail = len > TERMINATION_TAIL ? buf_end - TERMINATION_TAIL : buf;
+    info->is_normal_termination = Rfind(tail, (size_t)(buf_end - tail), "Normal termination") != NULL;
+
+    return GAU_LOG_OK;
+}
+
+/* the first occurrence of needle in buf[0, len), or NULL */
+static char const *Find(char const *buf, size_t len, char const *needle)
+{
+    size_t needle_len = strlen(needle);
+    char const *buf_end = buf + len;
+    char const *candidate = NULL;
+
+    while ((size_t)(buf_end - buf) >= needle_len && (candidate = (char const *)memchr(buf, * needle, \
+        (size_t)(buf_end - buf) - needle_len + 1u)))
+    {
+        if (! memcmp(candidate, needle, needle_len))
+            return candidate;
+        buf = candidate + 1;
+    }
+
+    return NULL;
+}
+
+/*
+    Parse the istep-th (from 0) step of an output of steps chained by "--Link1--", each of which ends with
+    its own "Normal termination" line. Returns a GAU_LOG_* code, GAU_LOG_ERR_TERMINATION if the step or an
+    earlier one ended with "Error termination", and GAU_LOG_ERR_NO_SCF if the output ends before the step.
+*/
+static int Parse_gau_log_step_buffer(char const *buf, size_t len, unsigned int istep, Gau_log_info *info)
+{
+    char const *buf_end = buf + len;
+    char const *step = buf, *step_end = NULL;
+    char const *normal = NULL, *error = NULL;
+    unsigned int istep_found = 0u;
+
+    memset(info, 0, sizeof(Gau_log_info));
+    for (istep_found = 0u; ; ++ istep_found)
+    {
+        normal = Find(step, (size_t)(buf_end - step), "Normal termination");
+        error = Find(step, (size_t)(buf_end - step), "Error termination");
+        if (error && (! normal || error < normal))
+            return GAU_LOG_ERR_TERMINATION;
+        /* the step still running if it has not ended */
+        step_end = normal ? Line_end(normal, buf_end) : buf_end;
+        if (istep_found == istep)
+            break;
+        if (! normal)
+            return GAU_LOG_ERR_NO_SCF;
+        step = step_end;
+    }
+
+    return Parse_gau_log_buffer(step, (size_t)(step_end - step), info);
+}
+
+/* parse the istep-th step of Gaussian output file log_name, or the whole of it if istep < 0 */
+static int Parse_gau_log_file(char const *log_name, int istep, Gau_log_info *info)
+{
+    int error = GAU_LOG_OK;
+    # ifndef _WIN32
+    int fd = -1;
+    struct stat log_stat;
+    void *map = NULL;
+
+    memset(info, 0, sizeof(Gau_log_info));
+    fd = open(log_name, O_RDONLY);
+    if (fd < 0)
+        return GAU_LOG_ERR_OPEN;
+    if (fstat(fd, & log_stat))
+    {
+        close(fd);
+        return GAU_LOG_ERR_OPEN;
+    }
+    if (! log_stat.st_size)
+    {
+        close(fd);
+        return GAU_LOG_ERR_NO_SCF;
+    }
+    map = mmap(NULL, (size_t)log_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return GAU_LOG_ERR_OPEN;
+    if (istep < 0)
+        error = Parse_gau_log_buffer((char const *)map, (size_t)log_stat.st_size, info);
+    else
+        error = Parse_gau_log_step_buffer((char const *)map, (size_t)log_stat.st_size, (unsigned int)istep, info);
+    munmap(map, (size_t)log_stat.st_size);
+    # else
+    FILE *log_ifl = NULL;
+    long log_size = 0l;
+    char *buf = NULL;
+
+    memset(info, 0, sizeof(Gau_log_info));
+    log_ifl = fopen(log_name, "rb");
+    if (! log_ifl)
+        return GAU_LOG_ERR_OPEN;
+    fseek(log_ifl, 0l, SEEK_END);
+    log_size = ftell(log_ifl);
+    fseek(log_ifl, 0l, SEEK_SET);
+    if (log_size <= 0l)
+    {
+        fclose(log_ifl);
+        return log_size ? GAU_LOG_ERR_OPEN : GAU_LOG_ERR_NO_SCF;
+    }
+    buf = (char *)malloc((size_t)log_size);
+    if (! buf || fread(buf, 1u, (size_t)log_size, log_ifl) != (size_t)log_size)
+    {
+        free(buf);
+        fclose(log_ifl);
+        return GAU_LOG_ERR_OPEN;
+    }
+    fclose(log_ifl);
+    if (istep < 0)
+        error = Parse_gau_log_buffer(buf, (size_t)log_size, info);
+    else
+        error = Parse_gau_log_step_buffer(buf, (size_t)log_size, (unsigned int)istep, info);
+    free(buf);
+    # endif
+
+    return error;
+}
+
+/* parse Gaussian output file log_name, returns a GAU_LOG_* code. */
+int Parse_gau_log(char const *log_name, Gau_log_info *info)
+{
+    return Parse_gau_log_file(log_name, -1, info);
+}
+
+/*
+    parse the istep-th (from 0) step of Gaussian output file log_name, of a job chained by "--Link1--",
+    returns a GAU_LOG_* code.
+*/
+int Parse_gau_log_step(char const *log_name, unsigned int istep, Gau_log_info *info)
+{
+    return Parse_gau_log_file(log_name, (int)istep, info);
+}
+
+char const *Gau_log_error_string(int error)
+{
+    switch (error)
+    {
+    case GAU_LOG_OK:
+        return "no error";
+    case GAU_LOG_ERR_OPEN:
+        return "cannot open or read the file";
+    case GAU_LOG_ERR_NO_SCF:
+        return "no \"SCF Done\" found";
+    case GAU_LOG_ERR_BAD_SCF:
+        return "cannot read the electron energy after \"SCF Done\"";
+    case GAU_LOG_ERR_NO_EIGEN:
+        return "no orbital energies found after the last \"SCF Done\"";
+    case GAU_LOG_ERR_BAD_EIGEN:
+        return "cannot read the HOMO or LUMO energy";
+    case GAU_LOG_ERR_TERMINATION:
+        return "Gaussian reported \"Error termination\"";
+    case GAU_LOG_ERR_NOT_CONVERGED:
+        return "SCF did not converge";
+    case GAU_LOG_ERR_RUNAWAY:
+        return "too many SCF cycles";
+    default:
+        return "unknown error";
+    }
+}
+
+/*
+    The streaming parser sees the output line by line, in the order Gaussian writes it, and keeps
+    only what the last SCF gives, so that everything is known as soon as the job ends.
+    It also notices the signs that the job is doomed, so that it can be killed at once.
+*/
+
+void Init_gau_log_stream(Gau_log_stream *stream, char const *log_name, unsigned int max_scf_cycle)
+{
+    memset(stream, 0, sizeof(Gau_log_stream));
+    strncpy(stream->log_name, log_name, BUFSIZ);
+    stream->max_scf_cycle = max_scf_cycle;
+    stream->last_occ_spin = -1;
+
+    return;
+}
+
+/* a whole line without its line feed */
+static void Feed_gau_log_line(Gau_log_stream *stream, char const *line, char const *line_end)
+{
+    static char const *const spins[2] = {"Alpha", "Beta"};
+    char buf[BUFSIZ + 1] = "";
+    char word[32] = "";
+    char *value = NULL;
+    size_t len = (size_t)(line_end - line) < BUFSIZ ? (size_t)(line_end - line) : BUFSIZ;
+    int ispin = 0, occ_spin = -1;
+    double first = 0.0, last = 0.0;
+    unsigned int cycle = 0u;
+
+    memcpy(buf, line, len);
+    buf[len] = '\0';
+
+    for (ispin = 0; ispin < 2; ++ ispin)
+    {
+        sprintf(word, "%s  occ. eigenvalues", spins[ispin]);
+        if (strstr(buf, word))
+        {
+            if (Parse_eigen_line(buf, buf + len, & first, & last))
+            {
+                occ_spin = ispin;
+                stream->last_occ_e = last;
+            }
+            break;
+        }
+        sprintf(word, "%s virt. eigenvalues", spins[ispin]);
+        /* only the first "virt." line, just after the last "occ." line */
+        if (strstr(buf, word) && stream->last_occ_spin == ispin && Parse_eigen_line(buf, buf + len, & first, & last))
+        {
+            stream->has_eigens[ispin] = true;
+            if (ispin)
+            {
+                stream->info.e_HOMO_beta = stream->last_occ_e;
+                stream->info.e_LUMO_beta = first;
+            }
+            else
+            {
+                stream->info.e_HOMO_alpha = stream->last_occ_e;
+                stream->info.e_LUMO_alpha = first;
+            }
+            break;
+        }
+    }
+    stream->last_occ_spin = occ_spin;
+    if (ispin < 2)
+        return;
+
+    if (strstr(buf, "SCF Done"))
+    {
+        if ((value = strchr(buf, '=')) && sscanf(value + 1, "%lg", & stream->info.E_scf) == 1)
+        {
+            stream->has_scf = true;
+            stream->has_eigens[0] = stream->has_eigens[1] = false;
+            stream->info.num_scf_cycle = 0u;
+            if ((value = strstr(buf, "after")))
+                sscanf(value + 5, "%u", & stream->info.num_scf_cycle);
+        }
+        stream->scf_cycle = 0u;
+    }
+    else if (sscanf(buf, " Cycle %u", & cycle) == 1)
+    {
+        stream->scf_cycle = cycle;
+        if (stream->max_scf_cycle && cycle > stream->max_scf_cycle && ! stream->failure)
+            stream->failure = GAU_LOG_ERR_RUNAWAY;
+    }
+    else if (strstr(buf, "Convergence failure"))
+    {
+        if (! stream->failure)
+            stream->failure = GAU_LOG_ERR_NOT_CONVERGED;
+    }
+    else if (strstr(buf, "Error termination"))
+    {
+        if (! stream->failure)
+            stream->failure = GAU_LOG_ERR_TERMINATION;
+    }
+    else if (strstr(buf, "Normal termination"))
+        stream->info.is_normal_termination = true;
+
+    return;
+}
+
+/* parse the next len bytes of the output, returns the failure seen so far, 0 if none. */
+int Feed_gau_log_stream(Gau_log_stream *stream, char const *data, size_t len)
+{
+    char const *data_end = data + len;
+    char const *lf = NULL;
+    size_t num_copy = 0u;
+
+    while (data < data_end)
+    {
+        lf = (char const *)memchr(data, '\n', (size_t)(data_end - data));
+        if (! stream->line_len && lf)
+        {
+            /* a whole line in data, no need to copy it */
+            Feed_gau_log_line(stream, data, lf);
+            data = lf + 1;
+            continue;
+        }
+        num_copy = (size_t)((lf ? lf : data_end) - data);
+        if (num_copy > BUFSIZ - stream->line_len)
+            num_copy = BUFSIZ - stream->line_len;
+        memcpy(stream->line + stream->line_len, data, num_copy);
+        stream->line_len += num_copy;
+        if (! lf)
+            break;
+        Feed_gau_log_line(stream, stream->line, stream->line + stream->line_len);
+        stream->line_len = 0u;
+        data = lf + 1;
+    }
+
+    return stream->failure;
+}
+
+/*
+    Parse what has been appended to the output since the last call, returns the failure seen so far, 0 if none.
+    It is not an error if the file does not exist yet.
+*/
+int Follow_gau_log_stream(Gau_log_stream *stream)
+{
+    FILE *log_ifl = NULL;
+    char buf[BUFSIZ * 16];
+    size_t num_read = 0u;
+
+    log_ifl = fopen(stream->log_name, "rb");
+    if (! log_ifl)
+        return stream->failure;
+    if (! fseek(log_ifl, stream->offset, SEEK_SET))
+    {
+        while ((num_read = fread(buf, 1u, sizeof(buf), log_ifl)))
+        {
+            Feed_gau_log_stream(stream, buf, num_read);
+            stream->offset += (long)num_read;
+        }
+    }
+    fclose(log_ifl);
+
+    return stream->failure;
+}
+
+/*
+    Read the rest of the output after the job ends, returns a GAU_LOG_* code like Parse_gau_log,
+    and the results are in stream->info.
+*/
+int Finish_gau_log_stream(Gau_log_stream *stream)
+{
+    Follow_gau_log_stream(stream);
+    if (stream->line_len)
+    {
+        Feed_gau_log_line(stream, stream->line, stream->line + stream->line_len);
+        stream->line_len = 0u;
+    }
+    stream->info.has_beta = stream->has_eigens[1];
+    if (stream->failure)
+        return stream->failure;
+    if (! stream->has_scf)
+        return GAU_LOG_ERR_NO_SCF;
+    if (! stream->has_eigens[0])
+        return GAU_LOG_ERR_NO_EIGEN;
+
+    return GAU_LOG_OK;
+}
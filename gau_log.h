@@ -0,0 +1,66 @@
+/* extract energies from Gaussian output files */
+# ifndef GAU_LOG_H
+# define GAU_LOG_H
+
+# include <stdio.h>
+# include <stddef.h>
+# include <stdbool.h>
+
+/* error codes of Parse_gau_log */
+# define GAU_LOG_OK 0
+# define GAU_LOG_ERR_OPEN 1 /* cannot open or read the file */
+# define GAU_LOG_ERR_NO_SCF 2 /* no "SCF Done" */
+# define GAU_LOG_ERR_BAD_SCF 3 /* "SCF Done" without a readable energy */
+# define GAU_LOG_ERR_NO_EIGEN 4 /* no "Alpha virt." after the last "SCF Done" */
+# define GAU_LOG_ERR_BAD_EIGEN 5 /* no readable "Alpha  occ." line before "Alpha virt." */
+# define GAU_LOG_ERR_TERMINATION 6 /* "Error termination" */
+# define GAU_LOG_ERR_NOT_CONVERGED 7 /* "Convergence failure" of SCF */
+# define GAU_LOG_ERR_RUNAWAY 8 /* more SCF cycles than allowed */
+
+/* everything read from the last SCF of a Gaussian output */
+typedef struct
+{
+    double E_scf; /* electron energy */
+    unsigned int num_scf_cycle; /* 0 if not printed */
+    double e_HOMO_alpha, e_LUMO_alpha;
+    bool has_beta; /* beta orbitals are printed for unrestricted wavefunctions */
+    double e_HOMO_beta, e_LUMO_beta;
+    bool is_normal_termination;
+} Gau_log_info;
+
+/* an output read piece by piece while Gaussian is still writing it */
+typedef struct
+{
+    char log_name[BUFSIZ + 1];
+    long offset; /* bytes of the file read so far */
+    char line[BUFSIZ + 1]; /* the line not ended yet, truncated if too long */
+    size_t line_len;
+    unsigned int max_scf_cycle; /* 0 for no limit */
+    unsigned int scf_cycle; /* the last "Cycle" line of the SCF running */
+    bool has_scf;
+    bool has_eigens[2]; /* alpha and beta orbital energies read after the last "SCF Done" */
+    int last_occ_spin; /* spin of the previous line if it is an "occ." line, -1 if it is not */
+    double last_occ_e; /* the last value on that line */
+    int failure; /* GAU_LOG_ERR_TERMINATION, ..., 0 if none is seen so far */
+    Gau_log_info info;
+} Gau_log_stream;
+
+/* see gau_log.c */
+
+int Parse_gau_log_buffer(char const *buf, size_t len, Gau_log_info *info);
+
+int Parse_gau_log(char const *log_name, Gau_log_info *info);
+
+int Parse_gau_log_step(char const *log_name, unsigned int istep, Gau_log_info *info);
+
+char const *Gau_log_error_string(int error);
+
+void Init_gau_log_stream(Gau_log_stream *stream, char const *log_name, unsigned int max_scf_cycle);
+
+int Feed_gau_log_stream(Gau_log_stream *stream, char const *data, size_t len);
+
+int Follow_gau_log_stream(Gau_log_stream *stream);
+
+int Finish_gau_log_stream(Gau_log_stream *stream);
+
+# endif /* GAU_LOG_H */
@@ -0,0 +1,918 @@
+/* run Gaussian jobs (or any other commands) one by one or concurrently */
+
+# include "gau_run.h"
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <time.h>
+# ifndef _WIN32
+# include <errno.h>
+# include <signal.h>
+# include <spawn.h>
+# include <sys/types.h>
+# include <sys/time.h>
+# include <sys/resource.h>
+# include <sys/wait.h>
+# include <unistd.h>
+
+extern char **environ;
+# else
+# include <windows.h>
+# endif
+
+/* the pid of a job which ended at once without a process, until it is waited for */
+# define PID_ENDED -1l
+
+/* the exit status of a job killed on Windows, as if by SIGTERM elsewhere */
+# define KILLED_EXIT_STATUS 143
+
+/* how often Wait_any_job_for checks whether a job has ended */
+# define POLL_INTERVAL_MS 20u
+
+/* how often Wait_any_job checks whether a job has run out of time */
+# define TIMEOUT_CHECK_MS 1000u
+
+/* at most this many process groups are killed if we are interrupted, jobs beyond them are left alone */
+# define MAX_GROUP 256u
+
+# ifndef _WIN32
+/*
+    Every job runs in a process group of its own, so that it can be killed together with everything
+    Gaussian launches. Such groups no longer get the signals of the terminal, so we pass them on.
+*/
+static volatile sig_atomic_t job_groups[MAX_GROUP];
+static bool is_handler_set = false;
+# endif
+
+/* see Set_exit_cleanup */
+static void (*exit_cleanup)() = NULL;
+
+static void Run_exit_cleanup()
+{
+    void (*cleanup)() = exit_cleanup;
+
+    exit_cleanup = NULL;
+    if (cleanup)
+        cleanup();
+
+    return;
+}
+
+# ifndef _WIN32
+
+static void Kill_groups_and_exit(int sig)
+{
+    unsigned int igroup = 0u;
+
+    for (igroup = 0u; igroup < MAX_GROUP; ++ igroup)
+    {
+        if (job_groups[igroup])
+            kill(- (pid_t)job_groups[igroup], SIGTERM);
+    }
+    /* we are going down anyway, so it does not matter that the cleanup is not async-signal-safe */
+    Run_exit_cleanup();
+    signal(sig, SIG_DFL);
+    raise(sig);
+
+    return;
+}
+
+static int const handled_sigs[] = {SIGINT, SIGTERM, SIGHUP, SIGPIPE};
+
+static void Set_signal_handlers()
+{
+    struct sigaction action, old_action;
+    unsigned int isig = 0u;
+
+    if (is_handler_set)
+        return;
+    is_handler_set = true;
+    memset(& action, 0, sizeof(struct sigaction));
+    action.sa_handler = Kill_groups_and_exit;
+    sigemptyset(& action.sa_mask);
+    for (isig = 0u; isig < sizeof(handled_sigs) / sizeof(int); ++ isig)
+    {
+        /* keep what was ignored, like SIGHUP under nohup */
+        if (! sigaction(handled_sigs[isig], NULL, & old_action) && old_action.sa_handler == SIG_DFL)
+            sigaction(handled_sigs[isig], & action, NULL);
+    }
+
+    return;
+}
+
+/*
+    A child killed before its exec() would run Kill_groups_and_exit with our list of groups, and kill the
+    other jobs too. So the signals are blocked while a job is spawned, and the child takes the default
+    actions back before it unblocks them (see Start_job).
+*/
+static void Get_handled_signals(sigset_t *set)
+{
+    unsigned int isig = 0u;
+
+    sigemptyset(set);
+    for (isig = 0u; isig < sizeof(handled_sigs) / sizeof(int); ++ isig)
+        sigaddset(set, handled_sigs[isig]);
+
+    return;
+}
+
+static void Block_signals(sigset_t *old_set)
+{
+    sigset_t block_set;
+
+    Get_handled_signals(& block_set);
+    sigprocmask(SIG_BLOCK, & block_set, old_set);
+
+    return;
+}
+
+static void Add_group(pid_t pid)
+{
+    unsigned int igroup = 0u;
+
+    for (igroup = 0u; igroup < MAX_GROUP; ++ igroup)
+    {
+        if (! job_groups[igroup])
+        {
+            job_groups[igroup] = (sig_atomic_t)pid;
+            return;
+        }
+    }
+
+    return;
+}
+
+static void Remove_group(pid_t pid)
+{
+    unsigned int igroup = 0u;
+
+    for (igroup = 0u; igroup < MAX_GROUP; ++ igroup)
+    {
+        if (job_groups[igroup] == (sig_atomic_t)pid)
+            job_groups[igroup] = 0;
+    }
+
+    return;
+}
+# endif
+
+# ifndef _WIN32
+/* turn what waitpid() gives into an exit status, 128 + signal number if it was killed. */
+static int Decode_wait_status(int wait_status)
+{
+    if (WIFEXITED(wait_status))
+        return WEXITSTATUS(wait_status);
+    if (WIFSIGNALED(wait_status))
+        return 128 + WTERMSIG(wait_status);
+    return -1;
+}
+# endif
+
+/*
+    Seconds from some fixed moment, never going back even if the clock of the system is set.
+    On Windows clock() counts the wall-clock time since the program started, which does as well.
+*/
+double Get_monotonic_time()
+{
+    # ifndef _WIN32
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, & now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1E-9;
+    # else
+    return (double)clock() / CLOCKS_PER_SEC;
+    # endif
+}
+
+# ifndef _WIN32
+/*
+    Our environment with env (like "GAUSS_SCRDIR=/dev/shm/job", NULL for none) in place of the variable of
+    the same name, if any. Returns it, to be freed (but not its strings), or NULL if it cannot be allocated.
+*/
+static char **Make_job_environ(char const *env)
+{
+    unsigned int num_env = 0u, ienv = 0u, num_job_env = 0u;
+    size_t name_len = env ? (size_t)(strchr(env, '=') - env) + 1u : 0u;
+    char **job_environ = NULL;
+
+    while (environ[num_env])
+        ++ num_env;
+    job_environ = (char **)malloc((num_env + 2u) * sizeof(char *));
+    if (! job_environ)
+        return NULL;
+    for (ienv = 0u; ienv < num_env; ++ ienv)
+    {
+        if (! env || strncmp(environ[ienv], env, name_len))
+            job_environ[num_job_env ++] = environ[ienv];
+    }
+    if (env)
+        job_environ[num_job_env ++] = (char *)env;
+    job_environ[num_job_env] = NULL;
+
+    return job_environ;
+}
+# else
+/*
+    args joined into a command line, quoted so that the program splits it back into the same words,
+    like "\"C:\\my g16\\g16.exe\" N.gjf N.out". Returns it, to be freed, or NULL if it cannot be allocated.
+*/
+static char *Join_args(char const *const *args)
+{
+    unsigned int iarg = 0u;
+    size_t line_len = 0u, num_slash = 0u;
+    char const *ch = NULL;
+    char *line = NULL, *end = NULL;
+
+    for (iarg = 0u; args[iarg]; ++ iarg)
+        line_len += 2u * strlen(args[iarg]) + 3u;
+    line = (char *)malloc(line_len + 1u);
+    if (! line)
+        return NULL;
+    end = line;
+    for (iarg = 0u; args[iarg]; ++ iarg)
+    {
+        if (iarg)
+            * (end ++) = ' ';
+        if (* args[iarg] && ! strpbrk(args[iarg], " \t\""))
+        {
+            strcpy(end, args[iarg]);
+            end += strlen(end);
+            continue;
+        }
+        /* backslashes are doubled only before a quote, which is escaped */
+        * (end ++) = '"';
+        for (ch = args[iarg]; ; ++ ch)
+        {
+            for (num_slash = 0u; * ch == '\\'; ++ ch)
+                ++ num_slash;
+            if (! * ch || * ch == '"')
+                num_slash *= 2u;
+            for (; num_slash; -- num_slash)
+                * (end ++) = '\\';
+            if (! * ch)
+                break;
+            if (* ch == '"')
+                * (end ++) = '\\';
+            * (end ++) = * ch;
+        }
+        * (end ++) = '"';
+    }
+    * end = '\0';
+
+    return line;
+}
+
+/*
+    Our environment block with env (like "GAUSS_SCRDIR=D:\\job") in place of the variable of the same name,
+    if any, for CreateProcess(). Returns it, to be freed, or NULL if it cannot be allocated.
+*/
+static char *Make_env_block(char const *env)
+{
+    char *ours = GetEnvironmentStringsA();
+    char const *entry = NULL;
+    char *block = NULL, *end = NULL;
+    size_t name_len = (size_t)(strchr(env, '=') - env) + 1u, size = strlen(env) + 2u;
+
+    if (! ours)
+        return NULL;
+    for (entry = ours; * entry; entry += strlen(entry) + 1u)
+        size += strlen(entry) + 1u;
+    block = (char *)malloc(size);
+    if (block)
+    {
+        end = block;
+        for (entry = ours; * entry; entry += strlen(entry) + 1u)
+        {
+            /* the names are case-insensitive here */
+            if (! _strnicmp(entry, env, name_len))
+                continue;
+            strcpy(end, entry);
+            end += strlen(entry) + 1u;
+        }
+        strcpy(end, env);
+        end += strlen(env) + 1u;
+        * end = '\0';
+    }
+    FreeEnvironmentStringsA(ours);
+
+    return block;
+}
+
+/*
+    A job object holding process and everything it launches, like a process group elsewhere, so that they are
+    killed together by Kill_job, and when we exit in any way. Returns NULL if it cannot be made, then only
+    process itself can be killed.
+*/
+static HANDLE Make_job_group(HANDLE process)
+{
+    HANDLE group = CreateJobObjectA(NULL, NULL);
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION limit;
+
+    if (! group)
+        return NULL;
+    memset(& limit, 0, sizeof(JOBOBJECT_EXTENDED_LIMIT_INFORMATION));
+    limit.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+    if (! SetInformationJobObject(group, JobObjectExtendedLimitInformation, & limit, sizeof(limit)) || \
+        ! AssignProcessToJobObject(group, process))
+    {
+        CloseHandle(group);
+        return NULL;
+    }
+
+    return group;
+}
+# endif
+
+/* command becomes blank, with no words and nothing set in the environment */
+void Clear_command(Gau_command *command)
+{
+    command->num_arg = 0u;
+    * command->env = '\0';
+
+    return;
+}
+
+/* append a word to command, returns 0 on success, and 1 if there are too many words or it is too long. */
+int Add_command_arg(Gau_command *command, char const *arg)
+{
+    if (command->num_arg == GAU_MAX_ARG || strlen(arg) > BUFSIZ)
+    {
+        fprintf(stderr, "Error! Too many or too long words in a command, at \"%s\".\n", arg);
+        return 1;
+    }
+    strcpy(command->args[command->num_arg ++], arg);
+
+    return 0;
+}
+
+/* print command on a line for showing, the words with blanks in double quotes, nothing if it is blank */
+void Print_command(Gau_command const *command)
+{
+    unsigned int iarg = 0u;
+
+    if (! command->num_arg)
+        return;
+    if (* command->env && strpbrk(command->env, " \t"))
+        printf("%.*s\"%s\" ", (int)(strchr(command->env, '=') - command->env) + 1, command->env, \
+            strchr(command->env, '=') + 1);
+    else if (* command->env)
+        printf("%s ", command->env);
+    for (iarg = 0u; iarg < command->num_arg; ++ iarg)
+        printf(strpbrk(command->args[iarg], " \t") ? "%s\"%s\"" : "%s%s", iarg ? " " : "", command->args[iarg]);
+    printf("\n");
+
+    return;
+}
+
+/*
+    Launch args in background, returns 0 on success. It is not given to a shell: args[0] is the program,
+    found in PATH, and args, ended by NULL, are its arguments as they are. env (like "GAUSS_SCRDIR=/dev/shm/job",
+    NULL or "" for none) is put into its environment, the rest of which is ours. The job runs in a process
+    group of its own (a job object on Windows, see Make_job_group), and job->timeout_s is kept as set by the caller.
+    Without args[0], nothing runs, and the job ends at once with exit status 0 when it is waited for,
+    for a job whose output is in place already, like one replayed.
+*/
+int Start_job(Gau_job *job, char const *const *args, char const *env)
+{
+    # ifndef _WIN32
+    sigset_t old_set, default_set;
+    posix_spawnattr_t attr;
+    char **job_environ = NULL;
+    pid_t pid = 0;
+    int error = 0;
+    # else
+    char *line = NULL, *env_block = NULL;
+    STARTUPINFOA startup;
+    PROCESS_INFORMATION info;
+    # endif
+
+    job->exit_status = 0;
+    job->is_timed_out = false;
+    job->cpu_time = 0.0;
+    job->max_rss_kb = 0l;
+    job->time_start = Get_monotonic_time();
+    job->spawn_time = 0.0;
+    job->run_time = 0.0;
+    job->pid = 0l;
+    if (! args[0])
+    {
+        job->pid = PID_ENDED;
+        return 0;
+    }
+    if (env && ! * env)
+        env = NULL;
+    if (env && ! strchr(env, '='))
+    {
+        fprintf(stderr, "Error! Cannot launch \"%s\": \"%s\" is not like NAME=VALUE.\n", args[0], env);
+        job->exit_status = -1;
+        return 1;
+    }
+    /* what we have printed comes before anything printed by the job */
+    fflush(NULL);
+    # ifndef _WIN32
+    job_environ = Make_job_environ(env);
+    if (! job_environ)
+    {
+        fprintf(stderr, "Error! Cannot launch \"%s\": out of memory.\n", args[0]);
+        job->exit_status = -1;
+        return 1;
+    }
+    Set_signal_handlers();
+    Block_signals(& old_set);
+    Get_handled_signals(& default_set);
+    posix_spawnattr_init(& attr);
+    posix_spawnattr_setflags(& attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+    posix_spawnattr_setpgroup(& attr, 0);
+    posix_spawnattr_setsigdefault(& attr, & default_set);
+    posix_spawnattr_setsigmask(& attr, & old_set);
+    error = posix_spawnp(& pid, args[0], NULL, & attr, (char *const *)args, job_environ);
+    posix_spawnattr_destroy(& attr);
+    free(job_environ);
+    if (error)
+    {
+        sigprocmask(SIG_SETMASK, & old_set, NULL);
+        fprintf(stderr, "Error! Cannot launch \"%s\": %s.\n", args[0], strerror(error));
+        job->exit_status = -1;
+        return 1;
+    }
+    job->pid = (long)pid;
+    Add_group(pid);
+    sigprocmask(SIG_SETMASK, & old_set, NULL);
+    job->spawn_time = Get_monotonic_time() - job->time_start;
+    job->time_start += job->spawn_time;
+    # else
+    line = Join_args(args);
+    env_block = env ? Make_env_block(env) : NULL;
+    if (! line || (env && ! env_block))
+    {
+        fprintf(stderr, "Error! Cannot launch \"%s\": out of memory.\n", args[0]);
+        free(line);
+        free(env_block);
+        job->exit_status = -1;
+        return 1;
+    }
+    memset(& startup, 0, sizeof(STARTUPINFOA));
+    startup.cb = sizeof(STARTUPINFOA);
+    /* suspended until it is in its job object, so that nothing it launches gets out */
+    if (! CreateProcessA(NULL, line, NULL, NULL, TRUE, CREATE_SUSPENDED, env_block, NULL, & startup, & info))
+    {
+        fprintf(stderr, "Error! Cannot launch \"%s\": Windows error %lu.\n", args[0], (unsigned long)GetLastError());
+        free(line);
+        free(env_block);
+        job->exit_status = -1;
+        return 1;
+    }
+    free(line);
+    free(env_block);
+    job->process = info.hProcess;
+    job->group = Make_job_group(info.hProcess);
+    ResumeThread(info.hThread);
+    CloseHandle(info.hThread);
+    job->pid = (long)info.dwProcessId;
+    job->spawn_time = Get_monotonic_time() - job->time_start;
+    job->time_start += job->spawn_time;
+    # endif
+
+    return 0;
+}
+
+/* Start_job with the words and the environment of command */
+int Start_command(Gau_job *job, Gau_command const *command)
+{
+    char const *args[GAU_MAX_ARG + 1u] = {NULL};
+    unsigned int iarg = 0u;
+
+    for (iarg = 0u; iarg < command->num_arg; ++ iarg)
+        args[iarg] = command->args[iarg];
+    args[command->num_arg] = NULL;
+
+    return Start_job(job, args, command->env);
+}
+
+# ifndef _WIN32
+/* mark the job of pid as ended with what wait4() tells, returns its index, or num_job if it is not one of jobs. */
+static int Reap_job(Gau_job *jobs, unsigned int num_job, pid_t pid, int wait_status, struct rusage const *usage)
+{
+    unsigned int ijob = 0u;
+
+    for (ijob = 0u; ijob < num_job; ++ ijob)
+    {
+        if (jobs[ijob].pid == (long)pid)
+        {
+            jobs[ijob].pid = 0l;
+            jobs[ijob].exit_status = Decode_wait_status(wait_status);
+            jobs[ijob].cpu_time = (double)usage->ru_utime.tv_sec + (double)usage->ru_utime.tv_usec * 1E-6 + \
+                (double)usage->ru_stime.tv_sec + (double)usage->ru_stime.tv_usec * 1E-6;
+            jobs[ijob].max_rss_kb = (long)usage->ru_maxrss;
+            jobs[ijob].run_time = Get_monotonic_time() - jobs[ijob].time_start;
+            Remove_group(pid);
+            break;
+        }
+    }
+
+    return (int)ijob;
+}
+# else
+/* mark jobs[ijob], whose process has ended, as ended with its exit code and what its job object tells */
+static int Reap_process(Gau_job *jobs, unsigned int ijob)
+{
+    Gau_job *job = & jobs[ijob];
+    DWORD exit_code = 0;
+    JOBOBJECT_BASIC_ACCOUNTING_INFORMATION accounting;
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION limit;
+
+    job->exit_status = GetExitCodeProcess((HANDLE)job->process, & exit_code) ? (int)exit_code : -1;
+    /* in 100 ns, of all the processes of the job */
+    if (job->group && QueryInformationJobObject((HANDLE)job->group, JobObjectBasicAccountingInformation, \
+        & accounting, sizeof(accounting), NULL))
+        job->cpu_time = (double)(accounting.TotalUserTime.QuadPart + accounting.TotalKernelTime.QuadPart) * 1E-7;
+    if (job->group && QueryInformationJobObject((HANDLE)job->group, JobObjectExtendedLimitInformation, \
+        & limit, sizeof(limit), NULL))
+        job->max_rss_kb = (long)(limit.PeakProcessMemoryUsed / 1024u);
+    job->run_time = Get_monotonic_time() - job->time_start;
+    CloseHandle((HANDLE)job->process);
+    /* anything it left running goes with the job object */
+    if (job->group)
+        CloseHandle((HANDLE)job->group);
+    job->process = NULL;
+    job->group = NULL;
+    job->pid = 0l;
+
+    return (int)ijob;
+}
+
+/*
+    Wait up to timeout_ms milliseconds (INFINITE for no limit) until the process of one of the running jobs
+    ends, and reap it. Returns its index, GAU_RUN_TIMEOUT if none ends in time, or -1 if none is running.
+*/
+static int Wait_any_process(Gau_job *jobs, unsigned int num_job, DWORD timeout_ms)
+{
+    HANDLE processes[MAXIMUM_WAIT_OBJECTS];
+    unsigned int ijobs[MAXIMUM_WAIT_OBJECTS];
+    unsigned int ijob = 0u, num_process = 0u;
+    DWORD result = WAIT_TIMEOUT, waited_ms = 0u;
+    bool is_polled = false;
+
+    for (ijob = 0u; ijob < num_job && num_process < MAXIMUM_WAIT_OBJECTS; ++ ijob)
+    {
+        if (jobs[ijob].pid <= 0l)
+            continue;
+        ijobs[num_process] = ijob;
+        processes[num_process ++] = (HANDLE)jobs[ijob].process;
+    }
+    if (! num_process)
+        return -1;
+    /* too many to be waited for at once, each is polled in turn then */
+    is_polled = ijob < num_job;
+    while (is_polled)
+    {
+        for (ijob = 0u; ijob < num_job; ++ ijob)
+        {
+            if (jobs[ijob].pid > 0l && WaitForSingleObject((HANDLE)jobs[ijob].process, 0u) == WAIT_OBJECT_0)
+                return Reap_process(jobs, ijob);
+        }
+        if (timeout_ms != INFINITE && waited_ms >= timeout_ms)
+            return GAU_RUN_TIMEOUT;
+        Sleep(POLL_INTERVAL_MS);
+        waited_ms += POLL_INTERVAL_MS;
+    }
+    result = WaitForMultipleObjects(num_process, processes, FALSE, timeout_ms);
+    if (result - WAIT_OBJECT_0 < num_process)
+        return Reap_process(jobs, ijobs[result - WAIT_OBJECT_0]);
+    if (result == WAIT_TIMEOUT)
+        return GAU_RUN_TIMEOUT;
+    /* should not happen, but do not wait forever */
+    Kill_job(& jobs[ijobs[0]]);
+    Reap_process(jobs, ijobs[0]);
+    jobs[ijobs[0]].exit_status = -1;
+
+    return (int)ijobs[0];
+}
+# endif
+
+/* kill the running jobs which have run longer than their timeouts, returns whether any of them has a timeout. */
+static bool Kill_overdue_jobs(Gau_job *jobs, unsigned int num_job)
+{
+    unsigned int ijob = 0u;
+    bool has_timeout = false;
+    double now = Get_monotonic_time();
+
+    for (ijob = 0u; ijob < num_job; ++ ijob)
+    {
+        if (jobs[ijob].pid <= 0l || ! jobs[ijob].timeout_s)
+            continue;
+        has_timeout = true;
+        if (! jobs[ijob].is_timed_out && now - jobs[ijob].time_start >= (double)jobs[ijob].timeout_s)
+        {
+            fprintf(stderr, "Error! Killing a job which has run longer than %u s.\n", jobs[ijob].timeout_s);
+            jobs[ijob].is_timed_out = true;
+            Kill_job(& jobs[ijob]);
+        }
+    }
+
+    return has_timeout;
+}
+
+/* marks a job which ended without a process as waited for, returns its index, or -1 if there is none. */
+static int Take_ended_job(Gau_job *jobs, unsigned int num_job)
+{
+    unsigned int ijob = 0u;
+
+    for (ijob = 0u; ijob < num_job; ++ ijob)
+    {
+        if (jobs[ijob].pid == PID_ENDED)
+        {
+            jobs[ijob].pid = 0l;
+            return (int)ijob;
+        }
+    }
+
+    return -1;
+}
+
+/* Wait_any_job, without looking at the timeouts */
+static int Wait_any_job_blocking(Gau_job *jobs, unsigned int num_job)
+{
+    unsigned int ijob = 0u;
+    int iended = -1;
+    # ifndef _WIN32
+    pid_t pid = 0;
+    int wait_status = 0;
+    struct rusage usage;
+    # endif
+
+    for (ijob = 0u; ijob < num_job; ++ ijob)
+    {
+        if (jobs[ijob].pid)
+            break;
+    }
+    if (ijob == num_job)
+        return -1;
+    if ((iended = Take_ended_job(jobs, num_job)) >= 0)
+        return iended;
+    # ifndef _WIN32
+    for (;;)
+    {
+        pid = wait4(-1, & wait_status, 0, & usage);
+        if (pid < 0)
+        {
+            /* should not happen, but do not wait forever */
+            for (ijob = 0u; ijob < num_job; ++ ijob)
+            {
+                if (jobs[ijob].pid)
+                {
+                    Remove_group((pid_t)jobs[ijob].pid);
+                    jobs[ijob].pid = 0l;
+                    jobs[ijob].exit_status = -1;
+                    return (int)ijob;
+                }
+            }
+            return -1;
+        }
+        if ((ijob = (unsigned int)Reap_job(jobs, num_job, pid, wait_status, & usage)) < num_job)
+            return (int)ijob;
+        /* some other child of ours, not interested */
+    }
+    # else
+    return Wait_any_process(jobs, num_job, INFINITE);
+    # endif
+}
+
+/*
+    Wait until one of the running jobs ends, its exit status and resource usage are stored and it is marked
+    as not running. A job running longer than its timeout_s meanwhile is killed, and is_timed_out is set.
+    Returns the index of the job, or -1 if none of them is running.
+*/
+int Wait_any_job(Gau_job *jobs, unsigned int num_job)
+{
+    int ijob = -1;
+
+    if (Kill_overdue_jobs(jobs, num_job))
+    {
+        while ((ijob = Wait_any_job_for(jobs, num_job, TIMEOUT_CHECK_MS)) == GAU_RUN_TIMEOUT)
+            ;
+        return ijob;
+    }
+
+    return Wait_any_job_blocking(jobs, num_job);
+}
+
+/* Like Wait_any_job, but gives up after timeout_ms milliseconds and returns GAU_RUN_TIMEOUT then. */
+int Wait_any_job_for(Gau_job *jobs, unsigned int num_job, unsigned int timeout_ms)
+{
+    # ifndef _WIN32
+    unsigned int ijob = 0u;
+    unsigned int waited_ms = 0u, sleep_ms = 0u;
+    int iended = -1;
+    pid_t pid = 0;
+    int wait_status = 0;
+    struct rusage usage;
+    struct timespec sleep_time;
+
+    for (ijob = 0u; ijob < num_job; ++ ijob)
+    {
+        if (jobs[ijob].pid)
+            break;
+    }
+    if (ijob == num_job)
+        return -1;
+    if ((iended = Take_ended_job(jobs, num_job)) >= 0)
+        return iended;
+    for (;;)
+    {
+        pid = wait4(-1, & wait_status, WNOHANG, & usage);
+        if (pid < 0 && errno != EINTR)
+            return Wait_any_job_blocking(jobs, num_job);
+        if (pid > 0)
+        {
+            if ((ijob = (unsigned int)Reap_job(jobs, num_job, pid, wait_status, & usage)) < num_job)
+                return (int)ijob;
+            continue;
+        }
+        Kill_overdue_jobs(jobs, num_job);
+        if (waited_ms >= timeout_ms)
+            return GAU_RUN_TIMEOUT;
+        sleep_ms = timeout_ms - waited_ms < POLL_INTERVAL_MS ? timeout_ms - waited_ms : POLL_INTERVAL_MS;
+        sleep_time.tv_sec = (time_t)(sleep_ms / 1000u);
+        sleep_time.tv_nsec = (long)(sleep_ms % 1000u) * 1000000l;
+        nanosleep(& sleep_time, NULL);
+        waited_ms += sleep_ms;
+    }
+    # else
+    unsigned int waited_ms = 0u, wait_ms = 0u;
+    int ijob = -1;
+
+    if ((ijob = Take_ended_job(jobs, num_job)) >= 0)
+        return ijob;
+    for (;;)
+    {
+        /* the timeouts of the jobs are looked at every TIMEOUT_CHECK_MS at least */
+        Kill_overdue_jobs(jobs, num_job);
+        wait_ms = timeout_ms - waited_ms < TIMEOUT_CHECK_MS ? timeout_ms - waited_ms : TIMEOUT_CHECK_MS;
+        if ((ijob = Wait_any_process(jobs, num_job, (DWORD)wait_ms)) != GAU_RUN_TIMEOUT)
+            return ijob;
+        waited_ms += wait_ms;
+        if (waited_ms >= timeout_ms)
+            return GAU_RUN_TIMEOUT;
+    }
+    # endif
+}
+
+/* ask a running job and everything it launched to terminate, it still needs to be waited for. */
+void Kill_job(Gau_job const *job)
+{
+    # ifndef _WIN32
+    if (job->pid > 0l)
+        kill(- (pid_t)job->pid, SIGTERM);
+    # else
+    if (job->pid > 0l && ! (job->group && TerminateJobObject((HANDLE)job->group, KILLED_EXIT_STATUS)))
+        TerminateProcess((HANDLE)job->process, KILLED_EXIT_STATUS);
+    # endif
+
+    return;
+}
+
+/*
+    Runs num_command commands (see Start_command), each killed if it runs longer than timeout_s (0 for no limit).
+    If is_concurrent is true, all of them are launched at once and then waited for, otherwise they are
+    run one after another. Each command runs to its end even if another one fails, and how commands[i]
+    ended is stored in jobs[i]: its exit_status is 0 for success, 128 + signal number if it was killed
+    (KILLED_EXIT_STATUS on Windows), and -1 if it could not be launched at all.
+    Returns the number of commands which did not succeed.
+*/
+int Run_commands(Gau_command const *commands, unsigned int num_command, bool is_concurrent, unsigned int timeout_s, \
+    Gau_job *jobs)
+{
+    unsigned int icommand = 0u;
+    int num_failed = 0;
+
+    memset(jobs, 0, num_command * sizeof(Gau_job));
+    for (icommand = 0u; icommand < num_command; ++ icommand)
+    {
+        jobs[icommand].timeout_s = timeout_s;
+        Start_command(& jobs[icommand], & commands[icommand]);
+        if (! is_concurrent)
+            Wait_any_job(& jobs[icommand], 1u);
+    }
+    while (Wait_any_job(jobs, num_command) >= 0)
+        ;
+    for (icommand = 0u; icommand < num_command; ++ icommand)
+    {
+        if (jobs[icommand].exit_status)
+            ++ num_failed;
+    }
+
+    return num_failed;
+}
+
+/* returns 0 on success */
+int Init_slots(Gau_slots *slots, unsigned int num_slot)
+{
+    slots->num_slot = num_slot;
+    slots->jobs = (Gau_job *)calloc(num_slot, sizeof(Gau_job));
+    slots->task_ids = (unsigned int *)calloc(num_slot, sizeof(unsigned int));
+    if (! slots->jobs || ! slots->task_ids)
+    {
+        fprintf(stderr, "Error! Cannot allocate memory for %u job slots.\n", num_slot);
+        Free_slots(slots);
+        return 1;
+    }
+
+    return 0;
+}
+
+void Free_slots(Gau_slots *slots)
+{
+    free(slots->jobs);
+    slots->jobs = NULL;
+    free(slots->task_ids);
+    slots->task_ids = NULL;
+    slots->num_slot = 0u;
+
+    return;
+}
+
+/* returns the index of a slot running nothing, or -1 if all of them are busy. */
+int Find_free_slot(Gau_slots const *slots)
+{
+    unsigned int islot = 0u;
+
+    for (islot = 0u; islot < slots->num_slot; ++ islot)
+    {
+        if (! slots->jobs[islot].pid)
+            return (int)islot;
+    }
+
+    return -1;
+}
+
+/* the slot must be free, returns 0 on success. */
+int Start_in_slot(Gau_slots *slots, unsigned int islot, unsigned int task_id, Gau_command const *command)
+{
+    slots->task_ids[islot] = task_id;
+    slots->jobs[islot].timeout_s = slots->timeout_s;
+
+    return Start_command(& slots->jobs[islot], command);
+}
+
+/*
+    Wait until the job in one of the slots ends, and tell which task it was and how it ended.
+    Returns the index of the slot, which is free again, or -1 if no slot is running anything.
+*/
+int Wait_any_slot(Gau_slots *slots, unsigned int *task_id_ptr, int *exit_status_ptr)
+{
+    int islot = Wait_any_job(slots->jobs, slots->num_slot);
+
+    if (islot < 0)
+        return -1;
+    * task_id_ptr = slots->task_ids[islot];
+    * exit_status_ptr = slots->jobs[islot].exit_status;
+
+    return islot;
+}
+
+/* Wait_any_slot, but returns GAU_RUN_TIMEOUT if nothing ends in timeout_ms milliseconds. */
+int Wait_any_slot_for(Gau_slots *slots, unsigned int timeout_ms, unsigned int *task_id_ptr, int *exit_status_ptr)
+{
+    int islot = Wait_any_job_for(slots->jobs, slots->num_slot, timeout_ms);
+
+    if (islot < 0)
+        return islot;
+    * task_id_ptr = slots->task_ids[islot];
+    * exit_status_ptr = slots->jobs[islot].exit_status;
+
+    return islot;
+}
+
+/* kill the jobs in all slots, they still need to be waited for. */
+void Kill_all_slots(Gau_slots const *slots)
+{
+    unsigned int islot = 0u;
+
+    for (islot = 0u; islot < slots->num_slot; ++ islot)
+        Kill_job(& slots->jobs[islot]);
+
+    return;
+}
+
+/*
+    Have cleanup called once on the way out, whether by returning from main(), by exit(), or by being killed
+    with SIGINT, SIGTERM, SIGHUP or SIGPIPE (after the jobs are killed), so that it can remove the files of the jobs.
+    Only the last one set is called.
+*/
+void Set_exit_cleanup(void (*cleanup)())
+{
+    static bool is_registered = false;
+
+    exit_cleanup = cleanup;
+    if (! is_registered)
+    {
+        is_registered = true;
+        atexit(Run_exit_cleanup);
+    }
+    # ifndef _WIN32
+    Set_signal_handlers();
+    # endif
+
+    return;
+}
@@ -0,0 +1,94 @@
+/* run Gaussian jobs (or any other commands) one by one or concurrently */
+# ifndef GAU_RUN_H
+# define GAU_RUN_H
+
+# include <stdio.h>
+# include <stdbool.h>
+
+/* Wait_any_job_for and Wait_any_slot_for return this if nothing ends in time */
+# define GAU_RUN_TIMEOUT -2
+
+/* at most this many words in a Gau_command, the program included */
+# define GAU_MAX_ARG 4u
+
+/*
+    a command run without a shell: the program (found in PATH) and its arguments, each word taken as it is,
+    blanks and all, with a variable set in its environment. A command without words runs nothing.
+*/
+typedef struct
+{
+    char args[GAU_MAX_ARG][BUFSIZ + 1];
+    unsigned int num_arg;
+    char env[BUFSIZ + 1]; /* like "GAUSS_SCRDIR=/dev/shm/job", "" for none */
+} Gau_command;
+
+/* a job launched in background, in a process group of its own */
+typedef struct
+{
+    long pid; /* 0 for not running, -1 for ended at once without a process (see Start_job) until waited for */
+    int exit_status;
+    unsigned int timeout_s; /* killed if it runs longer than this, 0 for no limit */
+    bool is_timed_out; /* killed for that */
+    double time_start; /* by Get_monotonic_time, when it was launched */
+    double spawn_time; /* seconds taken to launch it */
+    double run_time; /* seconds from launched to waited for, after it ends */
+    double cpu_time; /* user and system seconds of the job and everything it has waited for, after it ends */
+    long max_rss_kb; /* peak resident memory of its largest process, after it ends */
+    # ifdef _WIN32
+    void *process; /* the handle of its process */
+    void *group; /* the handle of the job object of it and everything it launches, NULL if there is none */
+    # endif
+} Gau_job;
+
+/*
+    A fixed number of slots, each of which runs at most one job at a time.
+    Every slot owns an even share of the processors and memory, so the jobs never oversubscribe the node.
+*/
+typedef struct
+{
+    unsigned int num_slot;
+    Gau_job *jobs;
+    unsigned int *task_ids; /* what the caller is running in each slot */
+    unsigned int timeout_s; /* of every job started in the slots, 0 for no limit */
+} Gau_slots;
+
+/* see gau_run.c */
+
+double Get_monotonic_time();
+
+void Clear_command(Gau_command *command);
+
+int Add_command_arg(Gau_command *command, char const *arg);
+
+void Print_command(Gau_command const *command);
+
+int Start_job(Gau_job *job, char const *const *args, char const *env);
+
+int Start_command(Gau_job *job, Gau_command const *command);
+
+int Wait_any_job(Gau_job *jobs, unsigned int num_job);
+
+int Wait_any_job_for(Gau_job *jobs, unsigned int num_job, unsigned int timeout_ms);
+
+void Kill_job(Gau_job const *job);
+
+int Run_commands(Gau_command const *commands, unsigned int num_command, bool is_concurrent, unsigned int timeout_s, \
+    Gau_job *jobs);
+
+int Init_slots(Gau_slots *slots, unsigned int num_slot);
+
+void Free_slots(Gau_slots *slots);
+
+int Find_free_slot(Gau_slots const *slots);
+
+int Start_in_slot(Gau_slots *slots, unsigned int islot, unsigned int task_id, Gau_command const *command);
+
+int Wait_any_slot(Gau_slots *slots, unsigned int *task_id_ptr, int *exit_status_ptr);
+
+int Wait_any_slot_for(Gau_slots *slots, unsigned int timeout_ms, unsigned int *task_id_ptr, int *exit_status_ptr);
+
+void Kill_all_slots(Gau_slots const *slots);
+
+void Set_exit_cleanup(void (*cleanup)());
+
+# endif /* GAU_RUN_H */
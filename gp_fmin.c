@@ -0,0 +1,581 @@
+/* 1-d optimization by the expected improvement of a Gaussian process fitted to every point evaluated */
+
+# include "gp_fmin.h"
+# include <math.h>
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+
+# ifndef M_PI
+# define M_PI 3.14159265358979323846
+# endif
+
+/*
+    Brent's method only keeps the last three points, but when f is expensive every point evaluated is worth
+    keeping. A Gaussian process with squared exponential correlation and a constant mean is fitted to all of them,
+    its length chosen by the largest (restricted) marginal likelihood, and f is next evaluated where the expected
+    improvement over the best value is the largest. The correlation assumes f is smooth, as J^2 is.
+    For a batch, the points after the first are chosen as if f at those before were what the model predicts
+    ("kriging believer").
+    It stops when every point where f could still be lower than the best value (by 2 standard deviations
+    of the model) is within tol of the best point.
+*/
+
+/* added to the diagonal of the correlation matrix, f is computed to about this relative precision */
+# define GP_NUGGET 1E-8
+
+/* number of lengths of the correlation tried, from GP_MIN_LENGTH to GP_MAX_LENGTH of the interval */
+# define GP_NUM_LENGTH 24u
+# define GP_MIN_LENGTH 0.02
+# define GP_MAX_LENGTH 5.0
+
+/* at most this many points a + i * h, h is made larger than tol if needed */
+# define GP_MAX_CAND 20001u
+
+/* f could be lower than the best value if the mean minus GP_KAPPA standard deviations is */
+# define GP_KAPPA 2.0
+
+/* points asked for before the model is fitted, the initial guess and two near the ends */
+# define GP_NUM_INIT 3u
+
+static double Correlation(double r, double length)
+{
+    double t = r / length;
+
+    return exp(- 0.5 * t * t);
+}
+
+/* lower Cholesky factor of the n by n matrix m in place, returns 1 if it is not positive definite. */
+static int Cholesky(double *m, unsigned int n)
+{
+    unsigned int i = 0u, j = 0u, k = 0u;
+    double sum = 0.0;
+
+    for (j = 0u; j < n; ++ j)
+    {
+        sum = m[j * n + j];
+        for (k = 0u; k < j; ++ k)
+            sum -= m[j * n + k] * m[j * n + k];
+        if (sum <= 0.0)
+            return 1;
+        m[j * n + j] = sqrt(sum);
+        for (i = j + 1u; i < n; ++ i)
+        {
+            sum = m[i * n + j];
+            for (k = 0u; k < j; ++ k)
+                sum -= m[i * n + k] * m[j * n + k];
+            m[i * n + j] = sum / m[j * n + j];
+        }
+    }
+
+    return 0;
+}
+
+/* solve l * y = x in place, l is lower triangular */
+static void Solve_lower(double const *l, unsigned int n, double *x)
+{
+    unsigned int i = 0u, k = 0u;
+
+    for (i = 0u; i < n; ++ i)
+    {
+        for (k = 0u; k < i; ++ k)
+            x[i] -= l[i * n + k] * x[k];
+        x[i] /= l[i * n + i];
+    }
+
+    return;
+}
+
+/* solve l^T * y = x in place */
+static void Solve_upper(double const *l, unsigned int n, double *x)
+{
+    unsigned int i = n, k = 0u;
+
+    while (i)
+    {
+        -- i;
+        for (k = i + 1u; k < n; ++ k)
+            x[i] -= l[k * n + i] * x[k];
+        x[i] /= l[i * n + i];
+    }
+
+    return;
+}
+
+/*
+    Factorize the correlation matrix of the points fitted for length into s->chol, and solve the mean by
+    generalized least squares and s->alpha, f normalized is in y. Returns the restricted log likelihood
+    with the variance at its best, or -HUGE_VAL if singular.
+*/
+static double Factorize(Gp_state *s, double const *y, double length)
+{
+    unsigned int n = s->num_fit;
+    unsigned int i = 0u, j = 0u;
+    double log_det = 0.0, one_one = 0.0, r_r = 0.0;
+
+    for (i = 0u; i < n; ++ i)
+    {
+        for (j = 0u; j <= i; ++ j)
+            s->chol[i * n + j] = Correlation(s->xs[s->fit_ids[i]] - s->xs[s->fit_ids[j]], length);
+        s->chol[i * n + i] += GP_NUGGET;
+    }
+    if (Cholesky(s->chol, n))
+        return - HUGE_VAL;
+
+    /* whiten f and the constant with chol, then it is ordinary least squares */
+    memcpy(s->alpha, y, n * sizeof(double));
+    Solve_lower(s->chol, n, s->alpha);
+    s->beta = 0.0;
+    for (i = 0u; i < n; ++ i)
+    {
+        s->ones_solved[i] = 1.0;
+        log_det += 2.0 * log(s->chol[i * n + i]);
+    }
+    Solve_lower(s->chol, n, s->ones_solved);
+    for (i = 0u; i < n; ++ i)
+    {
+        one_one += s->ones_solved[i] * s->ones_solved[i];
+        s->beta += s->ones_solved[i] * s->alpha[i];
+    }
+    s->beta /= one_one;
+    s->one_one = one_one;
+    for (i = 0u; i < n; ++ i)
+    {
+        s->alpha[i] -= s->beta * s->ones_solved[i];
+        r_r += s->alpha[i] * s->alpha[i];
+    }
+    Solve_upper(s->chol, n, s->alpha);
+    s->variance = n > 1u ? r_r / (n - 1u) : 1.0;
+    if (s->variance <= 0.0)
+        s->variance = GP_NUGGET;
+
+    return - 0.5 * (n - 1u) * log(s->variance) - 0.5 * log_det - 0.5 * log(one_one);
+}
+
+/* fit the model to the points fitted, with the length of the correlation chosen again if is_new_length */
+static int Fit_model(Gp_state *s, int is_new_length)
+{
+    unsigned int n = s->num_fit;
+    unsigned int i = 0u, ilength = 0u;
+    double *y = s->work;
+    double sum = 0.0, sum_squared = 0.0;
+    double length = 0.0, log_likelihood = 0.0, best_log_likelihood = - HUGE_VAL, best_length = 0.0;
+
+    if (is_new_length)
+    {
+        for (i = 0u; i < n; ++ i)
+        {
+            sum += s->fxs[s->fit_ids[i]];
+            sum_squared += s->fxs[s->fit_ids[i]] * s->fxs[s->fit_ids[i]];
+        }
+        s->mean = sum / n;
+        s->scale = sqrt(fabs(sum_squared / n - s->mean * s->mean));
+        if (s->scale <= 0.0 || ! isfinite(s->scale))
+            s->scale = 1.0;
+    }
+    for (i = 0u; i < n; ++ i)
+        y[i] = (s->fxs[s->fit_ids[i]] - s->mean) / s->scale;
+    if (is_new_length)
+    {
+        for (ilength = 0u; ilength < GP_NUM_LENGTH; ++ ilength)
+        {
+            length = (s->high - s->low) * GP_MIN_LENGTH * \
+                pow(GP_MAX_LENGTH / GP_MIN_LENGTH, (double)ilength / (GP_NUM_LENGTH - 1u));
+            log_likelihood = Factorize(s, y, length);
+            if (log_likelihood > best_log_likelihood)
+            {
+                best_log_likelihood = log_likelihood;
+                best_length = length;
+            }
+        }
+        if (best_log_likelihood == - HUGE_VAL)
+            return 1;
+        s->length = best_length;
+    }
+
+    return Factorize(s, y, s->length) == - HUGE_VAL;
+}
+
+/* mean and standard deviation of f at x by the model, with the uncertainty of the mean */
+static void Predict(Gp_state *s, double x, double *mu_ptr, double *sigma_ptr)
+{
+    unsigned int n = s->num_fit;
+    unsigned int i = 0u;
+    double *k = s->work + s->max_eval;
+    double mu = s->beta, var = 1.0 + GP_NUGGET, u = 1.0;
+
+    for (i = 0u; i < n; ++ i)
+    {
+        k[i] = Correlation(x - s->xs[s->fit_ids[i]], s->length);
+        mu += k[i] * s->alpha[i];
+    }
+    Solve_lower(s->chol, n, k);
+    for (i = 0u; i < n; ++ i)
+    {
+        var -= k[i] * k[i];
+        u -= s->ones_solved[i] * k[i];
+    }
+    var += u * u / s->one_one;
+    * mu_ptr = s->mean + s->scale * mu;
+    * sigma_ptr = var > 0.0 ? s->scale * sqrt(s->variance * var) : 0.0;
+
+    return;
+}
+
+/*
+    Fit the points in [low, high], with the nearest one out of it on each side so that the model knows
+    how f goes on there, and at least GP_NUM_INIT points.
+*/
+static void Select_window(Gp_state *s, double low, double high)
+{
+    unsigned int n = s->num_point;
+    unsigned int i = 0u, j = 0u, id = 0u;
+    unsigned int first = 0u, last = 0u; /* [first, last) of sorted_ids */
+
+    /* insertion sort, the points are few */
+    for (i = 0u; i < n; ++ i)
+    {
+        id = i;
+        for (j = i; j && s->xs[s->sorted_ids[j - 1u]] > s->xs[id]; -- j)
+            s->sorted_ids[j] = s->sorted_ids[j - 1u];
+        s->sorted_ids[j] = id;
+    }
+    while (first < n && s->xs[s->sorted_ids[first]] < low)
+        ++ first;
+    last = first;
+    while (last < n && s->xs[s->sorted_ids[last]] <= high)
+        ++ last;
+    if (first)
+        -- first;
+    if (last < n)
+        ++ last;
+    while (last - first < GP_NUM_INIT && (first || last < n))
+    {
+        if (first)
+            -- first;
+        if (last < n)
+            ++ last;
+    }
+    s->low = low;
+    s->high = high;
+    s->num_fit = last - first;
+    memcpy(s->fit_ids, s->sorted_ids + first, s->num_fit * sizeof(unsigned int));
+
+    return;
+}
+
+static double Expected_improvement(double f_best, double mu, double sigma)
+{
+    double z = 0.0;
+
+    if (sigma <= 0.0)
+        return f_best > mu ? f_best - mu : 0.0;
+    z = (f_best - mu) / sigma;
+
+    return (f_best - mu) * 0.5 * erfc(- z / sqrt(2.0)) + sigma * exp(- 0.5 * z * z) / sqrt(2.0 * M_PI);
+}
+
+/* whether x is closer than h / 2 to a point evaluated */
+static int Is_known(Gp_state const *s, double x)
+{
+    unsigned int i = 0u;
+
+    for (i = 0u; i < s->num_point; ++ i)
+    {
+        if (fabs(x - s->xs[i]) < 0.5 * s->h)
+            return 1;
+    }
+
+    return 0;
+}
+
+/*
+    Look at the points a + i * h in [low, high] with the model, [* x_low_ptr, * x_high_ptr] is where f could be
+    lower than f_best, and the one with the largest expected improvement not known yet is returned, -1 if none.
+*/
+static long Scan_candidates(Gp_state *s, double x_best, double f_best, double *x_low_ptr, double *x_high_ptr)
+{
+    unsigned int icand = 0u, icand_end = 0u;
+    long ibest_cand = -1l;
+    double x = 0.0, mu = 0.0, sigma = 0.0, ei = 0.0, best_ei = 0.0;
+
+    * x_low_ptr = * x_high_ptr = x_best;
+    icand = s->low > s->a ? (unsigned int)ceil((s->low - s->a) / s->h - 1E-9) : 0u;
+    icand_end = (unsigned int)floor((s->high - s->a) / s->h + 1E-9) + 1u;
+    if (icand_end > s->num_cand)
+        icand_end = s->num_cand;
+    for (; icand < icand_end; ++ icand)
+    {
+        x = s->a + icand * s->h;
+        Predict(s, x, & mu, & sigma);
+        if (mu - GP_KAPPA * sigma < f_best)
+        {
+            if (x < * x_low_ptr)
+                * x_low_ptr = x;
+            if (x > * x_high_ptr)
+                * x_high_ptr = x;
+        }
+        if (Is_known(s, x))
+            continue;
+        ei = Expected_improvement(f_best, mu, sigma);
+        if (ei > best_ei)
+        {
+            best_ei = ei;
+            ibest_cand = (long)icand;
+        }
+    }
+
+    return ibest_cand;
+}
+
+/*
+    Start minimizing f on [ax, bx] from guessx, with at most max_eval evaluations.
+    Returns 0 on success, and 1 for illegal arguments or if memory cannot be allocated.
+*/
+int Gp_init(Gp_state *s, double ax, double bx, double guessx, double tol, unsigned int max_eval)
+{
+    memset(s, 0, sizeof(Gp_state));
+    if (bx <= ax || guessx < ax || guessx > bx || tol <= 0.0 || max_eval < GP_NUM_INIT)
+    {
+        fprintf(stderr, "Error! There must be ax <= guessx <= bx (cannot be equal together), tol > 0, " \
+            "and at least %u evaluations.\n", GP_NUM_INIT);
+        return 1;
+    }
+    s->a = ax;
+    s->b = bx;
+    s->tol = tol;
+    s->h = tol;
+    if ((bx - ax) / s->h >= GP_MAX_CAND - 1u)
+        s->h = (bx - ax) / (GP_MAX_CAND - 1u);
+    s->num_cand = (unsigned int)((bx - ax) / s->h + 1E-9) + 1u;
+    s->guessx = guessx;
+    s->max_eval = max_eval;
+    s->xs = (double *)malloc(max_eval * sizeof(double));
+    s->fxs = (double *)malloc(max_eval * sizeof(double));
+    s->fit_ids = (unsigned int *)malloc(max_eval * sizeof(unsigned int));
+    s->sorted_ids = (unsigned int *)malloc(max_eval * sizeof(unsigned int));
+    s->chol = (double *)malloc(max_eval * max_eval * sizeof(double));
+    s->ones_solved = (double *)malloc(max_eval * sizeof(double));
+    s->alpha = (double *)malloc(max_eval * sizeof(double));
+    s->work = (double *)malloc(max_eval * 2u * sizeof(double));
+    if (! s->xs || ! s->fxs || ! s->fit_ids || ! s->sorted_ids || ! s->chol || ! s->ones_solved || ! s->alpha || \
+        ! s->work)
+    {
+        fprintf(stderr, "Error! Cannot allocate memory for the Gaussian process.\n");
+        Gp_free(s);
+        return 1;
+    }
+
+    return 0;
+}
+
+void Gp_free(Gp_state *s)
+{
+    free(s->xs);
+    free(s->fxs);
+    free(s->fit_ids);
+    free(s->sorted_ids);
+    free(s->chol);
+    free(s->ones_solved);
+    free(s->alpha);
+    free(s->work);
+    s->xs = s->fxs = s->chol = s->ones_solved = s->alpha = s->work = NULL;
+    s->fit_ids = s->sorted_ids = NULL;
+
+    return;
+}
+
+/* f at x is fx, returns 1 if there were already max_eval points. */
+int Gp_add(Gp_state *s, double x, double fx)
+{
+    if (s->num_point >= s->max_eval)
+        return 1;
+    s->xs[s->num_point] = x;
+    s->fxs[s->num_point] = fx;
+    ++ s->num_point;
+
+    return 0;
+}
+
+/* the best point evaluated, and f there in * fx_ptr */
+double Gp_best(Gp_state const *s, double *fx_ptr)
+{
+    unsigned int i = 0u, ibest = 0u;
+
+    for (i = 1u; i < s->num_point; ++ i)
+    {
+        if (s->fxs[i] < s->fxs[ibest])
+            ibest = i;
+    }
+    * fx_ptr = s->num_point ? s->fxs[ibest] : HUGE_VAL;
+
+    return s->num_point ? s->xs[ibest] : s->guessx;
+}
+
+/*
+    Up to num_wanted points to evaluate f at next, in xs, and their number in * num_ptr, all of them must be
+    given to Gp_add before it is called again. Returns GP_CONTINUE, or GP_CONVERGED, GP_NOT_CONVERGED or
+    GP_FIT_FAILED and Gp_best gives the result (the best point so far unless converged).
+    The model of the whole interval cannot tell f apart near the minimum, so it is fitted again to the points
+    around where the minimum could be, as long as that shrinks to less than half.
+*/
+int Gp_propose(Gp_state *s, unsigned int num_wanted, double *xs, unsigned int *num_ptr)
+{
+    double const inits[GP_NUM_INIT] = {s->guessx, s->a + (s->b - s->a) / 6.0, s->b - (s->b - s->a) / 6.0};
+    unsigned int num_point = s->num_point;
+    unsigned int i = 0u, num = 0u;
+    long ibest_cand = -1l;
+    double x_best = 0.0, f_best = 0.0, x = 0.0, mu = 0.0, sigma = 0.0;
+    double x_low = 0.0, x_high = 0.0;
+
+    * num_ptr = 0u;
+    if (! num_wanted)
+        num_wanted = 1u;
+    if (num_wanted > s->max_eval - s->num_point)
+        num_wanted = s->max_eval - s->num_point;
+
+    /* the initial points, those too close to the ones before are skipped */
+    while (s->num_init_proposed < GP_NUM_INIT && num < num_wanted)
+    {
+        x = inits[s->num_init_proposed ++];
+        for (i = 0u; i < num; ++ i)
+        {
+            if (fabs(x - xs[i]) < 0.5 * s->h)
+                break;
+        }
+        if (i == num && ! Is_known(s, x))
+            xs[num ++] = x;
+    }
+    if (num)
+    {
+        * num_ptr = num;
+        return GP_CONTINUE;
+    }
+
+    /* where the minimum can still be */
+    x_best = Gp_best(s, & f_best);
+    x_low = s->a;
+    x_high = s->b;
+    do
+    {
+        Select_window(s, x_low, x_high);
+        if (Fit_model(s, 1))
+            return GP_FIT_FAILED;
+        ibest_cand = Scan_candidates(s, x_best, f_best, & x_low, & x_high);
+        if (x_high - x_low <= 2.0 * s->tol)
+            return GP_CONVERGED;
+    } while (x_high - x_low < 0.5 * (s->high - s->low));
+    if (! num_wanted)
+        return GP_NOT_CONVERGED;
+
+    while (ibest_cand >= 0l)
+    {
+        x = s->a + ibest_cand * s->h;
+        xs[num ++] = x;
+        if (num == num_wanted)
+            break;
+        /* believe the model at x for the rest of the batch */
+        Predict(s, x, & mu, & sigma);
+        Gp_add(s, x, mu);
+        s->fit_ids[s->num_fit ++] = s->num_point - 1u;
+        if (Fit_model(s, 0))
+            break;
+        ibest_cand = Scan_candidates(s, x_best, f_best, & x_low, & x_high);
+    }
+    s->num_point = num_point;
+    * num_ptr = num;
+
+    return num ? GP_CONTINUE : GP_CONVERGED;
+}
+
+/*
+    Minimize f on [ax, bx] from guessx, with the number of evaluations in * num_eval_ptr.
+    * info_ptr will be 0 for converged, -1 for not converged, -2 if the model cannot be fitted, 1 for illegal argument.
+*/
+double Gp_fmin(double ax, double bx, double guessx, double (*f)(double, void *), void *fargs, \
+    double tol, unsigned int max_eval, unsigned int *num_eval_ptr, int *info_ptr)
+{
+    Gp_state s;
+    double x = guessx, fx = 0.0;
+    unsigned int num = 0u;
+    int status = GP_CONTINUE;
+
+    * num_eval_ptr = 0u;
+    if (Gp_init(& s, ax, bx, guessx, tol, max_eval))
+    {
+        * info_ptr = 1;
+        return guessx;
+    }
+    while ((status = Gp_propose(& s, 1u, & x, & num)) == GP_CONTINUE)
+        Gp_add(& s, x, (* f)(x, fargs));
+    * info_ptr = status == GP_CONVERGED ? 0 : status;
+    * num_eval_ptr = s.num_point;
+    x = Gp_best(& s, & fx);
+    Gp_free(& s);
+
+    return x;
+}
+
+/*
+    Gp_fmin evaluating a batch of up to evaluator->max_running points at the same time,
+    the number of batches is in * num_round_ptr, and * info_ptr is 2 if f cannot be evaluated.
+*/
+double Gp_fmin_batch(double ax, double bx, double guessx, Brent_evaluator const *evaluator, void *fargs, \
+    double tol, unsigned int max_eval, unsigned int *num_eval_ptr, unsigned int *num_round_ptr, int *info_ptr)
+{
+    Gp_state s;
+    double *xs = NULL;
+    double x = guessx, fx = 0.0;
+    unsigned int num = 0u, i = 0u;
+    int status = GP_CONTINUE;
+
+    * num_eval_ptr = 0u;
+    * num_round_ptr = 0u;
+    if (Gp_init(& s, ax, bx, guessx, tol, max_eval))
+    {
+        * info_ptr = 1;
+        return guessx;
+    }
+    xs = (double *)malloc((evaluator->max_running ? evaluator->max_running : 1u) * sizeof(double));
+    if (! xs)
+    {
+        fprintf(stderr, "Error! Cannot allocate memory for the Gaussian process.\n");
+        Gp_free(& s);
+        * info_ptr = 1;
+        return guessx;
+    }
+    * info_ptr = 0;
+    while ((status = Gp_propose(& s, evaluator->max_running, xs, & num)) == GP_CONTINUE)
+    {
+        ++ * num_round_ptr;
+        for (i = 0u; i < num; ++ i)
+        {
+            if ((* evaluator->start)(xs[i], fargs))
+                break;
+        }
+        if (i < num)
+        {
+            * info_ptr = 2;
+            break;
+        }
+        for (i = 0u; i < num; ++ i)
+        {
+            if ((* evaluator->wait_any)(& x, & fx, fargs))
+                break;
+            Gp_add(& s, x, fx);
+        }
+        if (i < num)
+        {
+            * info_ptr = 2;
+            break;
+        }
+    }
+    if (! * info_ptr && status != GP_CONVERGED)
+        * info_ptr = status;
+    * num_eval_ptr = s.num_point;
+    x = Gp_best(& s, & fx);
+    free(xs);
+    Gp_free(& s);
+
+    return x;
+}
@@ -0,0 +1,60 @@
+/* 1-d optimization by the expected improvement of a Gaussian process fitted to every point evaluated */
+# ifndef GP_FMIN_H
+# define GP_FMIN_H
+
+# include "brent_fmin.h"
+
+/* what Gp_propose returns */
+# define GP_CONTINUE 0 /* evaluate f at the abscissae given */
+# define GP_CONVERGED 1
+# define GP_NOT_CONVERGED -1 /* more than max_eval evaluations */
+# define GP_FIT_FAILED -2 /* the correlation matrix is singular at every length tried */
+
+/*
+    Everything known about f, and the model fitted to it. f is only evaluated at a + i * h,
+    besides the initial points, so that no two evaluations are closer than h / 2.
+*/
+typedef struct
+{
+    double a, b; /* the interval searched */
+    double tol, h;
+    unsigned int num_cand; /* the points a + i * h, i < num_cand, looked at for the next evaluation */
+    double guessx;
+    unsigned int num_init_proposed; /* the initial guess and two points near the ends come first */
+    unsigned int num_point, max_eval;
+    double *xs, *fxs; /* every point evaluated */
+    /* the Gaussian process fitted to the points in [low, high] and the nearest ones out of it */
+    double low, high;
+    unsigned int num_fit;
+    unsigned int *fit_ids; /* ids of the points fitted */
+    unsigned int *sorted_ids; /* ids of all points in increasing x */
+    double mean, scale; /* f is normalized as (f - mean) / scale */
+    double length; /* of the squared exponential correlation */
+    double variance;
+    double beta; /* the constant mean of the normalized f */
+    double *chol; /* lower Cholesky factor of the correlation matrix */
+    double *ones_solved; /* chol^-1 times a vector of 1 */
+    double one_one; /* its squared norm */
+    double *alpha; /* the correlation matrix times alpha is the normalized f less beta */
+    double *work;
+} Gp_state;
+
+/* see gp_fmin.c */
+
+int Gp_init(Gp_state *s, double ax, double bx, double guessx, double tol, unsigned int max_eval);
+
+void Gp_free(Gp_state *s);
+
+int Gp_add(Gp_state *s, double x, double fx);
+
+int Gp_propose(Gp_state *s, unsigned int num_wanted, double *xs, unsigned int *num_ptr);
+
+double Gp_best(Gp_state const *s, double *fx_ptr);
+
+double Gp_fmin(double ax, double bx, double guessx, double (*f)(double, void *), void *fargs, \
+    double tol, unsigned int max_eval, unsigned int *num_eval_ptr, int *info_ptr);
+
+double Gp_fmin_batch(double ax, double bx, double guessx, Brent_evaluator const *evaluator, void *fargs, \
+    double tol, unsigned int max_eval, unsigned int *num_eval_ptr, unsigned int *num_round_ptr, int *info_ptr);
+
+# endif /* GP_FMIN_H */
@@ -0,0 +1,341 @@
+/* the processors and the memory of this node, for giving each of the jobs running at the same time a slice */
+
+# ifdef __linux__
+# define _GNU_SOURCE
+# include <sched.h>
+# endif
+# include "node_topo.h"
+# include <stdlib.h>
+# include <string.h>
+
+# define Close_file(flp) fclose(flp); flp = NULL
+
+/* NUMA nodes and cache levels looked for in /sys */
+# define MAX_NUM_NODE 256u
+# define MAX_CACHE_INDEX 16u
+
+/* parse a list like "0-3,8,10-14/2", returns the number of processors, or 0 if it is illegal. */
+unsigned int Parse_cpu_list(char const *str, unsigned int *cpus, unsigned int max_cpu)
+{
+    unsigned int num_cpu = 0u;
+    unsigned int first = 0u, last = 0u, stride = 1u, icpu = 0u;
+    int num_read = 0;
+
+    for (;;)
+    {
+        if (sscanf(str, "%u%n", & first, & num_read) != 1)
+            return 0u;
+        str += num_read;
+        last = first;
+        stride = 1u;
+        if (* str == '-')
+        {
+            ++ str;
+            if (sscanf(str, "%u%n", & last, & num_read) != 1 || last < first)
+                return 0u;
+            str += num_read;
+            if (* str == '/')
+            {
+                ++ str;
+                if (sscanf(str, "%u%n", & stride, & num_read) != 1 || ! stride)
+                    return 0u;
+                str += num_read;
+            }
+        }
+        for (icpu = first; icpu <= last; icpu += stride)
+        {
+            if (num_cpu == max_cpu)
+                return 0u;
+            cpus[num_cpu ++] = icpu;
+        }
+        if (* str != ',')
+            break;
+        ++ str;
+    }
+
+    return num_cpu;
+}
+
+/* the inverse of Parse_cpu_list, consecutive processors are merged into ranges. */
+void Format_cpu_list(unsigned int const *cpus, unsigned int num_cpu, char *str)
+{
+    unsigned int icpu = 0u, jcpu = 0u;
+
+    * str = '\0';
+    for (icpu = 0u; icpu < num_cpu; icpu = jcpu + 1u)
+    {
+        jcpu = icpu;
+        while (jcpu + 1u < num_cpu && cpus[jcpu + 1u] == cpus[jcpu] + 1u)
+            ++ jcpu;
+        str += sprintf(str, icpu ? ",%u" : "%u", cpus[icpu]);
+        if (jcpu != icpu)
+            str += sprintf(str, "-%u", cpus[jcpu]);
+    }
+
+    return;
+}
+
+# ifdef __linux__
+/* the first line of a file in /sys, returns 0 on success. */
+static int Read_sys_line(char const *path, char *line, int size)
+{
+    FILE *sys_ifl = fopen(path, "rt");
+    char *line_end = NULL;
+
+    if (! sys_ifl)
+        return 1;
+    if (! fgets(line, size, sys_ifl))
+    {
+        Close_file(sys_ifl);
+        return 1;
+    }
+    Close_file(sys_ifl);
+    if ((line_end = strchr(line, '\n')))
+        * line_end = '\0';
+
+    return 0;
+}
+
+/* an unsigned number in a file in /sys, or default_value if it cannot be read */
+static unsigned int Read_sys_uint(char const *path, unsigned int default_value)
+{
+    char line[BUFSIZ + 1] = "";
+    unsigned int value = 0u;
+
+    if (Read_sys_line(path, line, BUFSIZ) || sscanf(line, "%u", & value) != 1)
+        return default_value;
+
+    return value;
+}
+
+/* the least processor sharing the L3 cache with cpu, or cpu itself if there is no L3 cache */
+static unsigned int Read_l3_id(unsigned int cpu, unsigned int *shared_cpus)
+{
+    char path[BUFSIZ + 1] = "";
+    char line[BUFSIZ + 1] = "";
+    unsigned int icache = 0u, num_shared = 0u, ishared = 0u, id = cpu;
+
+    for (icache = 0u; icache < MAX_CACHE_INDEX; ++ icache)
+    {
+        sprintf(path, "/sys/devices/system/cpu/cpu%u/cache/index%u/level", cpu, icache);
+        if (Read_sys_uint(path, 0u) != 3u)
+            continue;
+        sprintf(path, "/sys/devices/system/cpu/cpu%u/cache/index%u/shared_cpu_list", cpu, icache);
+        if (Read_sys_line(path, line, BUFSIZ) || ! (num_shared = Parse_cpu_list(line, shared_cpus, MAX_NUM_CPU)))
+            continue;
+        for (ishared = 0u; ishared < num_shared; ++ ishared)
+        {
+            if (shared_cpus[ishared] < id)
+                id = shared_cpus[ishared];
+        }
+        break;
+    }
+
+    return id;
+}
+
+/* in /proc/meminfo, "MemAvailable", or "MemTotal" for old kernels, 0 if neither can be read */
+static double Read_available_bytes()
+{
+    FILE *meminfo_ifl = fopen("/proc/meminfo", "rt");
+    char line[BUFSIZ + 1] = "";
+    double kb = 0.0, total_kb = 0.0;
+
+    if (! meminfo_ifl)
+        return 0.0;
+    while (fgets(line, BUFSIZ, meminfo_ifl))
+    {
+        if (sscanf(line, "MemAvailable: %lf", & kb) == 1)
+            break;
+        sscanf(line, "MemTotal: %lf", & total_kb);
+        kb = 0.0;
+    }
+    Close_file(meminfo_ifl);
+
+    return (kb > 0.0 ? kb : total_kb) * 1024.0;
+}
+# endif
+
+/* by NUMA node, L3 cache, package, core and processor */
+static int Compare_node_cpus(void const *cpu1, void const *cpu2)
+{
+    Node_cpu const *c1 = (Node_cpu const *)cpu1, *c2 = (Node_cpu const *)cpu2;
+
+    if (c1->node != c2->node)
+        return c1->node < c2->node ? -1 : 1;
+    if (c1->l3 != c2->l3)
+        return c1->l3 < c2->l3 ? -1 : 1;
+    if (c1->package != c2->package)
+        return c1->package < c2->package ? -1 : 1;
+    if (c1->core != c2->core)
+        return c1->core < c2->core ? -1 : 1;
+    if (c1->cpu != c2->cpu)
+        return c1->cpu < c2->cpu ? -1 : 1;
+
+    return 0;
+}
+
+/*
+    Find the processors this process may run on (sched_getaffinity, so taskset and the batch system are obeyed),
+    where they are from /sys/devices/system/cpu and /sys/devices/system/node, and the memory available.
+    Only on Linux, returns 0 on success.
+*/
+int Read_node_topology(Node_topology *topo)
+{
+# ifdef __linux__
+    cpu_set_t cpu_set;
+    char path[BUFSIZ + 1] = "";
+    char line[BUFSIZ + 1] = "";
+    unsigned int *listed_cpus = NULL;
+    unsigned int icpu = 0u, inode = 0u, num_listed = 0u, ilisted = 0u;
+
+    memset(topo, 0, sizeof(Node_topology));
+    if (sched_getaffinity(0, sizeof(cpu_set_t), & cpu_set))
+    {
+        fprintf(stderr, "Error! Cannot get the processors this program may run on.\n");
+        return 1;
+    }
+    topo->cpus = (Node_cpu *)malloc((size_t)CPU_COUNT(& cpu_set) * sizeof(Node_cpu));
+    listed_cpus = (unsigned int *)malloc(MAX_NUM_CPU * sizeof(unsigned int));
+    if (! topo->cpus || ! listed_cpus)
+    {
+        fprintf(stderr, "Error! Cannot allocate memory for the processors of this node.\n");
+        free(listed_cpus);
+        Free_node_topology(topo);
+        return 1;
+    }
+    for (icpu = 0u; icpu < CPU_SETSIZE; ++ icpu)
+    {
+        if (! CPU_ISSET(icpu, & cpu_set))
+            continue;
+        topo->cpus[topo->num_cpu].cpu = icpu;
+        topo->cpus[topo->num_cpu].node = 0u;
+        topo->cpus[topo->num_cpu].l3 = Read_l3_id(icpu, listed_cpus);
+        sprintf(path, "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", icpu);
+        topo->cpus[topo->num_cpu].package = Read_sys_uint(path, 0u);
+        sprintf(path, "/sys/devices/system/cpu/cpu%u/topology/core_id", icpu);
+        topo->cpus[topo->num_cpu].core = Read_sys_uint(path, icpu);
+        ++ topo->num_cpu;
+    }
+    /* without NUMA, there is no /sys/devices/system/node, and every processor is in node 0 */
+    for (inode = 0u; inode < MAX_NUM_NODE; ++ inode)
+    {
+        sprintf(path, "/sys/devices/system/node/node%u/cpulist", inode);
+        if (Read_sys_line(path, line, BUFSIZ) || ! (num_listed = Parse_cpu_list(line, listed_cpus, MAX_NUM_CPU)))
+            continue;
+        for (ilisted = 0u; ilisted < num_listed; ++ ilisted)
+        {
+            for (icpu = 0u; icpu < topo->num_cpu; ++ icpu)
+            {
+                if (topo->cpus[icpu].cpu == listed_cpus[ilisted])
+                    topo->cpus[icpu].node = inode;
+            }
+        }
+    }
+    free(listed_cpus);
+    qsort(topo->cpus, topo->num_cpu, sizeof(Node_cpu), Compare_node_cpus);
+    topo->available_bytes = Read_available_bytes();
+
+    return 0;
+# else
+    memset(topo, 0, sizeof(Node_topology));
+    fprintf(stderr, "Error! Cannot find the processors of this node on this system.\n");
+
+    return 1;
+# endif
+}
+
+void Free_node_topology(Node_topology *topo)
+{
+    free(topo->cpus);
+    topo->cpus = NULL;
+    topo->num_cpu = 0u;
+
+    return;
+}
+
+/* the NUMA nodes and the L3 caches the num_cpu processors of cpus (sorted as in Node_topology) are in */
+void Count_node_domains(Node_cpu const *cpus, unsigned int num_cpu, unsigned int *num_node_ptr, \
+    unsigned int *num_l3_ptr)
+{
+    unsigned int icpu = 0u;
+
+    * num_node_ptr = * num_l3_ptr = 0u;
+    for (icpu = 0u; icpu < num_cpu; ++ icpu)
+    {
+        if (! icpu || cpus[icpu].node != cpus[icpu - 1u].node)
+            ++ * num_node_ptr;
+        if (! icpu || cpus[icpu].node != cpus[icpu - 1u].node || cpus[icpu].l3 != cpus[icpu - 1u].l3)
+            ++ * num_l3_ptr;
+    }
+
+    return;
+}
+
+/* the index in cpus after the processors of the NUMA node cpus[icpu] is in */
+static unsigned int Find_node_end(Node_cpu const *cpus, unsigned int num_cpu, unsigned int icpu)
+{
+    unsigned int node = cpus[icpu].node;
+
+    while (icpu < num_cpu && cpus[icpu].node == node)
+        ++ icpu;
+
+    return icpu;
+}
+
+/*
+    The processors of the i_part-th of num_part jobs running at the same time, out of the num_cpu of cpus
+    (sorted as in Node_topology): returns how many, and where they start in cpus in * first_ptr.
+    No job spans two NUMA nodes unless it has more than one node of its own. With no more jobs than nodes,
+    the nodes are dealt out whole. Otherwise each job goes to the node holding the middle of an even share,
+    and the processors of every node are split evenly among the jobs there, by L3 cache and core as sorted.
+    If there are fewer processors than jobs, the jobs have to share them, one each.
+*/
+unsigned int Split_node_cpus(Node_cpu const *cpus, unsigned int num_cpu, unsigned int num_part, unsigned int i_part, \
+    unsigned int *first_ptr)
+{
+    unsigned int num_node = 0u, num_l3 = 0u, first_node = 0u, last_node = 0u, inode = 0u, icpu = 0u, first = 0u;
+    unsigned int node_start = 0u, node_end = 0u, ipart = 0u, first_part = 0u, num_part_in_node = 0u;
+    unsigned long middle = 0u;
+
+    * first_ptr = 0u;
+    if (! num_cpu)
+        return 0u;
+    if (num_cpu < num_part)
+    {
+        * first_ptr = i_part % num_cpu;
+        return 1u;
+    }
+    Count_node_domains(cpus, num_cpu, & num_node, & num_l3);
+    if (num_part <= num_node)
+    {
+        first_node = i_part * num_node / num_part;
+        last_node = (i_part + 1u) * num_node / num_part;
+        for (inode = 0u, icpu = 0u; inode < last_node; ++ inode)
+        {
+            if (inode == first_node)
+                first = icpu;
+            icpu = Find_node_end(cpus, num_cpu, icpu);
+        }
+        * first_ptr = first;
+        return icpu - first;
+    }
+
+    /* the node holding the middle of the even share of this job, and the other jobs whose middles are there */
+    middle = ((unsigned long)i_part * 2u + 1u) * num_cpu / (num_part * 2u);
+    for (node_start = 0u; (node_end = Find_node_end(cpus, num_cpu, node_start)) <= middle; node_start = node_end)
+        ;
+    num_part_in_node = 0u;
+    for (ipart = 0u; ipart < num_part; ++ ipart)
+    {
+        middle = ((unsigned long)ipart * 2u + 1u) * num_cpu / (num_part * 2u);
+        if (middle < node_start || middle >= node_end)
+            continue;
+        if (! num_part_in_node)
+            first_part = ipart;
+        ++ num_part_in_node;
+    }
+    * first_ptr = node_start + (i_part - first_part) * (node_end - node_start) / num_part_in_node;
+
+    return node_start + (i_part - first_part + 1u) * (node_end - node_start) / num_part_in_node - * first_ptr;
+}
@@ -0,0 +1,42 @@
+/* the processors and the memory of this node, for giving each of the jobs running at the same time a slice */
+# ifndef NODE_TOPO_H
+# define NODE_TOPO_H
+
+# include <stdio.h>
+
+/* at most this many processors in a list, like "%CPU=0-3,8" */
+# define MAX_NUM_CPU 4096u
+
+/* where a processor is */
+typedef struct
+{
+    unsigned int cpu; /* as in "%CPU" */
+    unsigned int node; /* NUMA node */
+    unsigned int l3; /* the least processor sharing its L3 cache, as the id of the cache */
+    unsigned int package, core;
+} Node_cpu;
+
+typedef struct
+{
+    Node_cpu *cpus; /* the processors this process may run on, sorted by NUMA node, L3 cache, package and core */
+    unsigned int num_cpu;
+    double available_bytes; /* "MemAvailable" in /proc/meminfo */
+} Node_topology;
+
+/* see node_topo.c */
+
+unsigned int Parse_cpu_list(char const *str, unsigned int *cpus, unsigned int max_cpu);
+
+void Format_cpu_list(unsigned int const *cpus, unsigned int num_cpu, char *str);
+
+int Read_node_topology(Node_topology *topo);
+
+void Free_node_topology(Node_topology *topo);
+
+void Count_node_domains(Node_cpu const *cpus, unsigned int num_cpu, unsigned int *num_node_ptr, \
+    unsigned int *num_l3_ptr);
+
+unsigned int Split_node_cpus(Node_cpu const *cpus, unsigned int num_cpu, unsigned int num_part, unsigned int i_part, \
+    unsigned int *first_ptr);
+
+# endif /* NODE_TOPO_H */
@@ -14,20 +14,68 @@
 # endif
 # include <math.h>
 # include <time.h>
+# include <sys/stat.h>
+# ifndef _WIN32
+# include <dirent.h>
+# endif
 
 # include "brent_fmin.h"
+# include "gp_fmin.h"
+# include "dft_w_calc.h"
 
 int glob_argc = 1;
-long glob_replace_iop_pos = 0l;
-char glob_gau_exe[BUFSIZ + 1] = "";
+char const *glob_method = "brent"; /* the method choosing the w being evaluated, for the trace */
 
 # define Close_file(flp) fclose(flp); flp = NULL
 
+/* the least and the largest w the IOps can take, up to which [w_LOW, w_HIGH] is expanded */
+# define W_LOWEST 0.0001
+# define W_HIGHEST 9.9999
+
+/* half the width of the interval at the level of the template, around the minimum at a lower fidelity */
+# define LOW_FIDELITY_HALF_WIDTH 0.02
+
+/* status of a template in a batch besides those of Brent_tell, which its Brent's method returned last */
+# define BATCH_FAILED 3
+
+/* a template tuned in a batch, with its own Brent's method, driven by the w of it which end */
+typedef struct
+{
+    char temp_name[BUFSIZ + 1];
+    Dft_w_calc calc;
+    Dft_w_journal journal;
+    bool is_template_read, is_journal_open;
+    Brent_state brent;
+    int status;
+    double w; /* being evaluated, or the best one after it ends */
+    double J_squared; /* of the best w */
+    time_t time_start, time_stop;
+} Dft_w_molecule;
+
 void Print_exit_success();
 void Print_exit_failure();
 void Pause_program(char const *prompt);
-void Get_J_and_J_squared(double *J_ptr, double *J_squared_ptr);
+void Trace_point(Dft_w_calc const *calc, unsigned int iter, Dft_w_point const *point, Brent_state const *brent);
+void Calc_point_from_w(double w, void *args, Brent_state const *brent, Dft_w_point *point);
+double Tune_low_fidelity(Dft_w_calc *calc, Gjf_template const *low_temp, double w_low, double w_high, \
+    double w_lowest, double w_highest, double w_guess, double w_tolerance, unsigned int max_iter, \
+    Brent_observer const *observer);
 double Calc_J_squared_from_w(double w, void *args);
+int Calc_J_components_from_w(double w, double *Js, void *args);
+double Calc_J_squared_from_iop(long iop, void *args);
+int Start_w(double w, void *args);
+int Wait_any_w(double *w_ptr, double *J_squared_ptr, void *args);
+void Cancel_w(double w, void *args);
+int Is_same_w(double w1, double w2, void *args);
+int Scan_coarse(Dft_w_calc *calc, double w_low, double w_high, unsigned int num_w, double *ws, double *J_squareds);
+int Compare_names(void const *name1, void const *name2);
+bool Is_job_file_name(char const *file_name);
+int Append_name(char ***names_ptr, unsigned int *num_name_ptr, char const *name);
+void Free_names(char **names, unsigned int num_name);
+int Read_batch_list(char const *list_name, char ***temp_names_ptr, unsigned int *num_temp_ptr);
+int Run_batch(char const *list_name, Dft_w_calc *options, unsigned int multi_np1, unsigned int multi_nm1, \
+    double w_low, double w_high, double w_lowest, double w_highest, double w_guess, double w_tolerance, \
+    unsigned int max_iter, unsigned int num_job, char const *journal_name, bool is_resume);
 
 int main(int argc, char const *argv[])
 {
@@ -35,37 +83,73 @@ int main(int argc, char const *argv[])
 
     double w_low = 0.05, w_high = 0.6;
     double w_guess = (w_low + w_high) / 2;
+    bool is_expand = true; /* expand [w_low, w_high] if the minimum seems out of it */
+    double w_lowest = W_LOWEST, w_highest = W_HIGHEST;
     double w_tolerance = 1E-4;
 
     double w_when_J_squared_min = 0.0;
 
-    unsigned int multi_n = 0u, multi_np1 = 0u, multi_nm1 = 0u; /* p for +, n for -, 0 for not set */
-    int charge_n = 0, charge_np1 = -1, charge_nm1 = 1;
+    unsigned int multi_np1 = 0u, multi_nm1 = 0u; /* p for +, n for -, 0 for not set */
 
     unsigned int const max_iter = 100u;
 
     char const temp_name[] = "template.gjf";
     FILE *temp_ifl = NULL;
-    FILE *n_ifl = NULL, *np1_ifl = NULL, *nm1_ifl = NULL;
 
-    char env_gauss_exedir_copy[BUFSIZ + 1] = "";
-    char *env_gauss_exedir = NULL;
-    char const *env_gauss_exedir_ptr = getenv("GAUSS_EXEDIR");
+    Dft_w_calc calc;
 
-    char buf[BUFSIZ + 1] = "";
-    char *line_end = NULL;
+    char journal_name[BUFSIZ + 1] = "optimize_DFT_w.journal";
+    Dft_w_journal journal;
+    bool is_resume = false;
 
-    int info = 0;
+    char trace_name[BUFSIZ + 1] = ""; /* "" for no trace */
+    char scratch_root[BUFSIZ + 1] = ""; /* where the jobs run, "" for the working directory */
+    Dft_w_trace trace;
 
-    # ifdef _WIN32
-    char const path_splitter[] = ";";
-    # else
-    char const path_splitter[] = ":";
-    # endif
+    Brent_state brent;
+    Dft_w_point point;
+    int status = BRENT_CONTINUE;
+    bool is_explain = false; /* print every step of Brent's method, and why it was golden-section */
+    Brent_observer observer;
+
+    unsigned int num_speculate = 1u; /* w evaluated at the same time */
+    Dft_w_pool pool;
+    Brent_evaluator evaluator;
+    unsigned int num_round = 0u;
+
+    bool is_lattice = false; /* search the IOp values instead of w */
+    unsigned int num_eval = 0u;
+
+    bool is_surrogate = false; /* minimize a Gaussian process fitted to J^2 instead */
+
+    unsigned int num_coarse = 0u; /* w scanned at the same time before Brent's method, 0 for no scan */
+    double *coarse_ws = NULL, *coarse_J_squareds = NULL;
+    unsigned int icoarse = 0u, ibest = 0u;
+
+    bool is_signed_J = false; /* drive the signed J_N and J_N+1 to zero instead of J^2 alone */
+
+    char low_basis[BUFSIZ + 1] = ""; /* of the tuning at a lower fidelity first, "" for that of the template */
+    unsigned int low_conver = 0u; /* SCF=Conver of the tuning at a lower fidelity first, 0 for as in the template */
+    double low_tolerance = 1E-3;
+    bool is_low_tolerance_given = false;
+    Gjf_template low_temp;
+
+    char batch_name[BUFSIZ + 1] = ""; /* directory or list of the templates tuned together, "" for "template.gjf" */
+    unsigned int num_job = 1u; /* Gaussian jobs running at the same time in a batch */
+
+    bool is_pin = false; /* pin each job to a slice of the processors and the memory of this node */
+    Node_topology topo;
+    double mem_bytes = 0.0; /* with "--pin", the memory shared by the jobs, 0 for as in the template */
+    unsigned int num_node = 0u, num_l3 = 0u;
+
+    int info = 0;
 
     time_t time_start = 0, time_stop = 0;
 
     glob_argc = argc;
+    memset(& calc, 0, sizeof(Dft_w_calc));
+    calc.is_echo = true;
+    calc.objective = OBJECTIVE_J_BOTH;
 
     /* check command arguments, if "-h" or "--help" appears, print help message and exit. */
     for (iarg = 1; iarg != argc; ++ iarg)
@@ -81,6 +165,34 @@ int main(int argc, char const *argv[])
             printf("    [ --multi-np1 MULTIPLICITY_N+1 ]        The multiplicity of N+1 state.\n");
             printf("    [ --multi-nm1 MULTIPLICITY_N-1 ]        The multiplicity of N-1 state.\n");
             printf("    [ --tolerance TOLERANCE ]               The tolerance of convergence of w.\n");
+            printf("    [ --concurrent ]                        Run the jobs of N, N+1 and N-1 states at the same time.\n");
+            printf("    [ --cache CACHE_FILE ]                  Reuse and keep energies in CACHE_FILE.\n");
+            printf("    [ --read-guess ]                        Start SCF from the checkpoint of the nearest w done.\n");
+            printf("    [ --link1 ]                             Run N, N+1 and N-1 states of a w in one job chained by --Link1--.\n");
+            printf("    [ --supervise ]                         Follow the outputs and kill the jobs bound to fail.\n");
+            printf("    [ --journal JOURNAL_FILE ]              Record every w evaluated in JOURNAL_FILE.\n");
+            printf("    [ --resume ]                            Take the w recorded in JOURNAL_FILE instead of running them.\n");
+            printf("    [ --speculate NUM_W ]                   Evaluate up to NUM_W w at the same time, ahead of need.\n");
+            printf("    [ --max-cycles MAX_CYCLE ]              With \"--supervise\", kill a job running more SCF cycles.\n");
+            printf("    [ --lattice ]                           Search the IOp values (w in 0.0001) directly.\n");
+            printf("    [ --coarse NUM_W ]                      Scan NUM_W w at the same time first, then refine the best.\n");
+            printf("    [ --surrogate ]                         Choose each w by a model fitted to all the w evaluated.\n");
+            printf("    [ --signed-J ]                          Step w by the secants of the signed J_N and J_N+1.\n");
+            printf("    [ --objective OBJECTIVE ]               Tune w against J_N (\"IP\"), J_N+1 (\"EA\") or both (\"both\").\n");
+            printf("    [ --batch DIRECTORY | LIST_FILE ]       Tune every template in DIRECTORY or LIST_FILE together.\n");
+            printf("    [ --jobs NUM_JOB ]                      With \"--batch\", run up to NUM_JOB Gaussian jobs at the same time.\n");
+            printf("    [ --record DIRECTORY ]                  Keep the input and output of every job in DIRECTORY.\n");
+            printf("    [ --replay DIRECTORY ]                  Take the outputs kept in DIRECTORY instead of running Gaussian.\n");
+            printf("    [ --timeout SECONDS ]                   Kill a Gaussian job running longer than SECONDS.\n");
+            printf("    [ --scratch DIRECTORY ]                 Run every job in a directory of its own in DIRECTORY.\n");
+            printf("    [ --trace TRACE_FILE ]                  Write a record of every job and every step into TRACE_FILE.\n");
+            printf("    [ --explain ]                           Print every step of Brent's method and why it was taken.\n");
+            printf("    [ --no-expand ]                         Keep w in [w_LOW, w_HIGH] even if J^2 falls toward an end.\n");
+            printf("    [ --low-basis BASIS ]                   Tune w with BASIS first, then at the level of the template.\n");
+            printf("    [ --low-conver CONVER ]                 Tune w with SCF=Conver=CONVER first, then as in the template.\n");
+            printf("    [ --low-tolerance LOW_TOLERANCE ]       The tolerance of w of that first tuning.\n");
+            printf("    [ --pin ]                               Pin each job to its own processors of this node.\n");
+            printf("    [ --mem MEMORY ]                        With \"--pin\", split MEMORY (like \"16GB\") among the jobs.\n");
             printf("\n");
             printf("\"N\" stands for the reference state, \"N+1\" stands for \"N\" plus an extra electron, \n");
             printf("and \"N-1\" stands for \"N\" minus an electron.\n");
@@ -92,20 +204,102 @@ int main(int argc, char const *argv[])
             printf("\n");
             printf("You need to prepare a template file called \"template.gjf\" in the current working directory, \n");
             printf("which is the entire input single point energy task file, except the IOps for tuning w.\n");
+            printf("With \"--concurrent\", the processors (%%CPU or %%NProcShared) and the memory (%%Mem) in the \n");
+            printf("template are split evenly among the three jobs.\n");
+            printf("CACHE_FILE can be shared with scan_DFT_w and other runs at the same time, and the states\n");
+            printf("of w found there for the same template are not run again.\n");
+            printf("With \"--read-guess\", each state keeps its own checkpoint files (like \"Np1_02000.chk\") and \n");
+            printf("later jobs of it read the guess from the one of nearest w, those files are removed at the end.\n");
+            printf("With \"--link1\", the states of a w not found in CACHE_FILE run in a single job (\"N.gjf\" or the file \n");
+            printf("of the first of them), so Gaussian starts once for them, and N+1 and N-1 states read the geometry \n");
+            printf("and the SCF guess from the checkpoint file left by the state before (unless the template says \n");
+            printf("\"Guess\" or \"Geom\" itself). It cannot be used with \"--read-guess\", and \"--concurrent\" does \n");
+            printf("nothing with it.\n");
+            printf("With \"--supervise\", a job is killed as soon as \"Error termination\", \"Convergence failure\" \n");
+            printf("or more than MAX_CYCLE SCF cycles (no limit by default) show up in its output, and if one job fails, \n");
+            printf("the other jobs running are killed at once.\n");
+            printf("JOURNAL_FILE = \"%s\", every w evaluated is appended to it and flushed to the disk at once, \n", journal_name);
+            printf("and it is started again unless \"--resume\" is given, which continues a run killed halfway.\n");
+            printf("With \"--record\", the input and the output of every job which ends are copied into DIRECTORY \n");
+            printf("(created if needed) as \"N_02000.gjf\", \"N_02000.out\" and so on, by state and IOp value. \n");
+            printf("With \"--replay\", the outputs recorded so are copied in place of running Gaussian, \n");
+            printf("so a recorded run is reproduced exactly, and GAUSS_EXEDIR is not needed. \n");
+            printf("With \"--timeout\", a job running longer than SECONDS (wall-clock time, no limit by default) is killed \n");
+            printf("and counted as failed. The commands print the CPU time and the peak memory of every job. \n");
+            printf("With \"--scratch\", every job runs in a directory of its own, which is its GAUSS_SCRDIR as well, \n");
+            printf("in a directory of this run in DIRECTORY (a fast local one, like /dev/shm), where the checkpoint \n");
+            printf("files of \"--read-guess\" are kept too. Only the energies (and with \"--record\", the inputs and \n");
+            printf("the outputs) are taken from there, and the output of a job which fails is copied here. All of it \n");
+            printf("is removed as soon as it is not needed, or when the program exits, even if it fails or is killed.\n");
+            printf("With \"--trace\", TRACE_FILE (replaced if it exists) gets one JSON object on each line for every job, \n");
+            printf("with its times, CPU time, peak memory, SCF cycles and exit status, and for every w evaluated, \n");
+            printf("with the interval of Brent's method and whether the step was golden-section or parabolic. \n");
+            printf("When Brent's method ends, the numbers of its parabolic and golden-section steps are printed, \n");
+            printf("with the reasons why the parabola was not used, and with \"--explain\", every step as it is taken, \n");
+            printf("with the interval, the best w and tol1, the closest two w may be (not with \"--batch\", \n");
+            printf("\"--lattice\", \"--surrogate\" or \"--signed-J\", which do not take such steps).\n");
+            printf("When Brent's method converges onto W_LOW or W_HIGH, or J^2 keeps falling toward it, that end is \n");
+            printf("moved twice as far as the interval is wide, down to %6.4lf or up to %6.4lf, and the search goes on \n", \
+                W_LOWEST, W_HIGHEST);
+            printf("from the w evaluated, so the w found is inside unless it is at one of those, unless \"--no-expand\" \n");
+            printf("is given (not with \"--lattice\", \"--surrogate\" or \"--signed-J\", which keep [W_LOW, W_HIGH]).\n");
+            printf("With \"--pin\", the processors this program may run on (those in %%CPU of the template as well, \n");
+            printf("if any) are dealt out to the jobs running at the same time as %%CPU lists, whole NUMA nodes first, \n");
+            printf("then cores sharing an L3 cache together, and MEMORY (%%Mem of the template, or 3/4 of the memory \n");
+            printf("available, by default) is split evenly among them, so that the jobs do not share caches or \n");
+            printf("move between nodes. It needs Linux.\n");
+            printf("With \"--speculate\", while Brent's method waits for one w, the likely next w are evaluated as well, \n");
+            printf("and those not needed are cancelled. The processors and the memory in the template are split \n");
+            printf("among all the jobs (NUM_W times 3 with \"--concurrent\"). The w found is the same as without it, \n");
+            printf("but it usually takes fewer rounds of waiting.\n");
+            printf("With \"--lattice\", Brent's method works on the integers written to the IOps, so that no IOp value \n");
+            printf("is run twice, and it stops when both neighbours of the best one are known to be worse, \n");
+            printf("TOLERANCE is not used then, and it cannot be used with \"--speculate\".\n");
+            printf("With \"--coarse\", NUM_W (at least 3) w evenly spaced from W_LOW to W_HIGH are run at the same time, \n");
+            printf("with the processors and the memory split among them, then Brent's method starts from the points \n");
+            printf("scanned, between the two neighbours of the best one, and W_GUESS is not used. \n");
+            printf("It cannot be used with \"--lattice\" or \"--speculate\".\n");
+            printf("With \"--surrogate\", a Gaussian process is fitted to J^2 of every w evaluated, and the next w is \n");
+            printf("where the expected improvement is the largest, until the w of minimum J^2 is known within TOLERANCE. \n");
+            printf("With \"--speculate\" as well, NUM_W w are chosen and evaluated at the same time in each round. \n");
+            printf("It usually needs more w than Brent's method, but fewer rounds of waiting when w are evaluated \n");
+            printf("at the same time. It cannot be used with \"--lattice\" or \"--coarse\".\n");
+            printf("With \"--signed-J\", J_N = e_HOMO(N) + IP(N) and J_N+1 = e_HOMO(N+1) + IP(N+1) are kept with \n");
+            printf("their signs, and the next w is where the lines through their last two values give the least J^2, \n");
+            printf("falling back to Brent's method when that w is not trusted. As both are nearly linear in w \n");
+            printf("near the minimum, it usually needs fewer w than Brent's method. \n");
+            printf("It cannot be used with \"--lattice\", \"--coarse\", \"--surrogate\" or \"--speculate\".\n");
+            printf("With \"--objective IP\", w is tuned against J_N = e_HOMO(N) + IP(N) alone, and only N and N-1 \n");
+            printf("states are run, and with \"--objective EA\", against J_N+1 = e_HOMO(N+1) + IP(N+1) alone, and only \n");
+            printf("N and N+1 states are run, which saves a third of the jobs or more (OBJECTIVE = \"both\", where \n");
+            printf("J^2 = J_N^2 + J_N+1^2, by default). J and J^2 printed are then of that one alone, \"--signed-J\" \n");
+            printf("steps w by its secants, and JOURNAL_FILE keeps the w of each objective apart, while the states \n");
+            printf("in CACHE_FILE are shared by all of them.\n");
+            printf("With \"--low-basis\" or \"--low-conver\", w is tuned by Brent's method at a lower fidelity first, \n");
+            printf("with the basis set after \"/\" in the route section (like \"LC-wPBE/6-311+G**\") replaced by BASIS, \n");
+            printf("and \"SCF=Conver=CONVER\" added (the template may not say \"SCF\" itself then), to LOW_TOLERANCE \n");
+            printf("(%6.1lg by default). Then the route section of the template is used, and w is tuned from the minimum \n", \
+                low_tolerance);
+            printf("found, in an interval %4.2lf wide around it (expanded like [W_LOW, W_HIGH] if needed), instead of \n", \
+                2.0 * LOW_FIDELITY_HALF_WIDTH);
+            printf("[W_LOW, W_HIGH] and W_GUESS, so that most w are evaluated cheaply and only a few at the level of \n");
+            printf("the template. The w at the lower fidelity are not recorded in JOURNAL_FILE (but in CACHE_FILE, \n");
+            printf("apart from the others), and are evaluated one by one. It cannot be used with \"--batch\".\n");
+            printf("With \"--batch\", every \"*.gjf\" in DIRECTORY, or every file named in LIST_FILE (one on each line, \n");
+            printf("blank lines and lines starting with \"#\" are skipped), is a template tuned by Brent's method of its own, \n");
+            printf("instead of \"template.gjf\", except the inputs of jobs left in DIRECTORY by an earlier run, like \n");
+            printf("\"benzene_Np1_02000.gjf\". The jobs of all the templates wait in one queue, and whenever one of \n");
+            printf("NUM_JOB (1 by default) jobs ends, the earliest job waiting, of whichever template, takes its place, \n");
+            printf("with the processors and the memory in its template split among NUM_JOB jobs. The files of a \n");
+            printf("template like \"mols/benzene.gjf\" start with \"mols/benzene_\", including its JOURNAL_FILE. \n");
+            printf("The result of each template is shown as soon as it ends, and all of them in a table at the end. \n");
+            printf("It cannot be used with \"--concurrent\", \"--speculate\", \"--lattice\", \"--coarse\", \n");
+            printf("\"--surrogate\" or \"--signed-J\".\n");
             printf("\n");
             Print_exit_success();
         }
     }
 
-    /* check template file */
-    temp_ifl = fopen(temp_name, "rt");
-    if (! temp_ifl)
-    {
-        fprintf(stderr, "Error! Cannot find \"%s\".\n", temp_name);
-        Print_exit_failure();
-    }
-    Close_file(temp_ifl);
-
     /* parse command arguments */
     iarg = 0;
     for (;;)
@@ -126,7 +320,7 @@ int main(int argc, char const *argv[])
                 fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
                 Print_exit_failure();
             }
-            if (w_low <= 0 || (unsigned int)(w_low * 1E4) < 1)
+            if (w_low <= 0 || W_to_iop(w_low) < 1)
             {
                 fprintf(stderr, "Error! Minimal acceptable w is 0.0001, but got %6.1lg.\n", w_low);
                 Print_exit_failure();
@@ -152,7 +346,7 @@ int main(int argc, char const *argv[])
                 fprintf(stderr, "Error! Higher limit of w must be positive, but got %6.1lg.\n", w_high);
                 Print_exit_failure();
             }
-            if ((unsigned int)(w_high * 1E4) >= 1E5)
+            if (W_to_iop(w_high) >= 1E5)
             {
                 fprintf(stderr, "Error! Maximum acceptable w is 10, but got %6.1lg.\n", w_high);
                 Print_exit_failure();
@@ -235,474 +429,1233 @@ int main(int argc, char const *argv[])
             }
             continue;
         }
-        fprintf(stderr, "Error! Cannot recognize argument \"%s\".\n", argv[iarg]);
-        Print_exit_failure();
-    }
-    if (w_high <= w_low)
-    {
-        fprintf(stderr, "Error! higher limit of w (%6.1lg) must be greater than lower limit of w (%6.1lg).\n", w_high, w_low);
-        Print_exit_failure();
-    }
-    if (w_guess < w_low || w_guess > w_high)
-    {
-        fprintf(stderr, "Error! Initial guess of w (%6.1lg) must be in interval [lower limit (%6.1lg), higher limit (%6.1lg)].\n", \
-            w_guess, w_low, w_high);
-        Print_exit_failure();
-    }
-
-
-    if (! env_gauss_exedir_ptr || ! strcmp(env_gauss_exedir_ptr, ""))
-    {
-        fprintf(stderr, "Error! Environment variable \"GAUSS_EXEDIR\" is not set properly!\n");
-        Print_exit_failure();
-    }
-    strcpy(env_gauss_exedir_copy, env_gauss_exedir_ptr);
-    env_gauss_exedir = strtok(env_gauss_exedir_copy, path_splitter);
-    while (env_gauss_exedir)
-    {
-        if (strchr(env_gauss_exedir, ' '))
+        if (! strcmp(argv[iarg], "--concurrent"))
         {
-            # ifdef _WIN32
-            sprintf(glob_gau_exe, "\"%s%s\"", env_gauss_exedir, "\\g16.exe"); /* assume it is Gaussian 16 */
-            # else
-            sprintf(glob_gau_exe, "\"%s%s\"", env_gauss_exedir, "/g16");
-            # endif
+            calc.is_concurrent = true;
+            continue;
         }
-        else
+        if (! strcmp(argv[iarg], "--read-guess"))
+        {
+            calc.is_chain_guess = true;
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--link1"))
+        {
+            calc.is_link1 = true;
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--resume"))
         {
-            # ifdef _WIN32
-            sprintf(glob_gau_exe, "%s%s", env_gauss_exedir, "\\g16.exe");
-            # else
-            sprintf(glob_gau_exe, "%s%s", env_gauss_exedir, "/g16");
-            # endif
+            is_resume = true;
+            continue;
         }
-        if (access(glob_gau_exe, X_OK))
+        if (! strcmp(argv[iarg], "--journal"))
         {
-            if (strchr(env_gauss_exedir, ' '))
+            ++ iarg;
+            if (iarg == argc)
             {
-                # ifdef _WIN32
-                sprintf(glob_gau_exe, "\"%s%s\"", env_gauss_exedir, "\\g09.exe"); /* assume it is Gaussian 16 */
-                # else
-                sprintf(glob_gau_exe, "\"%s%s\"", env_gauss_exedir, "/g09");
-                # endif
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
             }
-            else
+            strncpy(journal_name, argv[iarg], BUFSIZ);
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--trace"))
+        {
+            ++ iarg;
+            if (iarg == argc)
             {
-                # ifdef _WIN32
-                sprintf(glob_gau_exe, "%s%s", env_gauss_exedir, "\\g09.exe");
-                # else
-                sprintf(glob_gau_exe, "%s%s", env_gauss_exedir, "/g09");
-                # endif
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
             }
-            if (! access(glob_gau_exe, X_OK))
-                break;
+            strncpy(trace_name, argv[iarg], BUFSIZ);
+            continue;
         }
-        else
-            break;
-        env_gauss_exedir = strtok(NULL, path_splitter);
-    }
-    if (access(glob_gau_exe, X_OK))
-    {
-        fprintf(stderr, "Error! Cannot find either g16 or g09 as executable.\n");
-        Print_exit_failure();
-    }
-
-    /* start preparing input files */
-    temp_ifl = fopen(temp_name, "rt");
-    n_ifl = fopen("N.gjf", "wt");
-    np1_ifl = fopen("Np1.gjf", "wt");
-    nm1_ifl = fopen("Nm1.gjf", "wt");
-    /* link 0 ,route section and a blank line followed */
-    while (fgets(buf, BUFSIZ, temp_ifl))
-    {
-        if ((line_end = strstr(buf, "\r\n")))
-            strcpy(line_end, "\n");
-        if (* buf == '#')
-        {
-            * strchr(buf, '\n') = '\0';
-            fprintf(n_ifl, "%s", buf);
-            fprintf(np1_ifl, "%s", buf);
-            fprintf(nm1_ifl, "%s", buf);
-            glob_replace_iop_pos = ftell(n_ifl);
-            fprintf(n_ifl, "%s", " IOp(3/107=0000000000,3/108=0000000000)\n");
-            fprintf(np1_ifl, "%s", " IOp(3/107=0000000000,3/108=0000000000)\n");
-            fprintf(nm1_ifl, "%s", " IOp(3/107=0000000000,3/108=0000000000)\n");
-            continue;
-        }
-        fprintf(n_ifl, "%s", buf);
-        fprintf(np1_ifl, "%s", buf);
-        fprintf(nm1_ifl, "%s", buf);
-        if (* buf == '\n')
-            break;
-    }
-    /* title and a blank line followed */
-    while (fgets(buf, BUFSIZ, temp_ifl))
-    {
-        if ((line_end = strstr(buf, "\r\n")))
-            strcpy(line_end, "\n");
-        fprintf(n_ifl, "%s", buf);
-        fprintf(np1_ifl, "%s", buf);
-        fprintf(nm1_ifl, "%s", buf);
-        if (* buf == '\n')
-            break;
-    }
-    /* charge and multiplicity */
-    fgets(buf, BUFSIZ, temp_ifl);
-    if ((line_end = strstr(buf, "\r\n")))
-        strcpy(line_end, "\n");
-    if (sscanf(buf, "%d %u", & charge_n, & multi_n) != 2)
-    {
-        fprintf(stderr, "Error! Cannot read the charge and multiplicity from template file.\n");
-        Close_file(temp_ifl);
-        Close_file(n_ifl);
-        Close_file(np1_ifl);
-        Close_file(nm1_ifl);
-        remove("N.gjf");
-        remove("Np1.gjf");
-        remove("Nm1.gjf");
-        Print_exit_failure();
-    }
-    if (! multi_n)
-    {
-        fprintf(stderr, "Error! Multiplicity cannot be zero, but it is zero in template file for N state.\n");
-        Close_file(temp_ifl);
-        Close_file(n_ifl);
-        Close_file(np1_ifl);
-        Close_file(nm1_ifl);
-        remove("N.gjf");
-        remove("Np1.gjf");
-        remove("Nm1.gjf");
-        Print_exit_failure();
-    }
-    charge_np1 = charge_n - 1;
-    charge_nm1 = charge_n + 1;
-    if (! multi_np1)
-        multi_np1 = multi_n + 1;
-    else
-    {
-        if (! ((multi_np1 - multi_n) & 1))
+        if (! strcmp(argv[iarg], "--supervise"))
         {
-            fprintf(stderr, "Error! Multiplicity of N+1 state and N state must have different parity.\n");
-            Close_file(temp_ifl);
-            Close_file(n_ifl);
-            Close_file(np1_ifl);
-            Close_file(nm1_ifl);
-            remove("N.gjf");
-            remove("Np1.gjf");
-            remove("Nm1.gjf");
-            Print_exit_failure();
+            calc.is_supervised = true;
+            continue;
         }
-    }
-    if (! multi_nm1)
-        multi_nm1 = multi_n + 1;
-    else
-    {
-        if (! ((multi_nm1 - multi_n) & 1))
+        if (! strcmp(argv[iarg], "--coarse"))
         {
-            fprintf(stderr, "Error! Multiplicity of N-1 state and N state must have different parity.\n");
-            Close_file(temp_ifl);
-            Close_file(n_ifl);
-            Close_file(np1_ifl);
-            Close_file(nm1_ifl);
-            remove("N.gjf");
-            remove("Np1.gjf");
-            remove("Nm1.gjf");
-            Print_exit_failure();
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (sscanf(argv[iarg], "%u", & num_coarse) != 1)
+            {
+                fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (num_coarse < 3u)
+            {
+                fprintf(stderr, "Error! Value after \"%s\" must be at least 3.\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            continue;
         }
-    }
-    fprintf(n_ifl, "%d %u\n", charge_n, multi_n);
-    fprintf(np1_ifl, "%d %u\n", charge_np1, multi_np1);
-    fprintf(nm1_ifl, "%d %u\n", charge_nm1, multi_nm1);
-    /* atom coordinates and others */
-    while (fgets(buf, BUFSIZ, temp_ifl))
-    {
-        fprintf(n_ifl, "%s", buf);
-        fprintf(np1_ifl, "%s", buf);
-        fprintf(nm1_ifl, "%s", buf);
-    }
-    /* close these files */
-    Close_file(temp_ifl);
-    Close_file(n_ifl);
-    Close_file(np1_ifl);
-    Close_file(nm1_ifl);
-
-    /* show title */
-    printf("Optimize w (literally omega) in long-range correction functional of DFT.\n");
-    printf("Parameters: w_low = %6.4lf, w_high = %6.4lf, w_guess = %6.4lf, w_tolerance = %6.4lf\n", \
-        w_low, w_high, w_guess, w_tolerance);
-    printf("            Charges for N, N+1 and N-1 states: %d %d %d\n", charge_n, charge_np1, charge_nm1);
-    printf("            Multiplicities for N, N+1 and N-1 states: %u %u %u\n", multi_n, multi_np1, multi_nm1);
-    printf("\n");
-    time_start = time(NULL);
-
-    /* Brent's method for minimize J^2 with variable w. */
-    w_when_J_squared_min = Brent_fmin(w_low, w_high, w_guess, Calc_J_squared_from_w, NULL, w_tolerance, max_iter, & info);
-    if (info > 0)
-    {
-        fprintf(stderr, "Error! Arguments of Brent's method are illegal!\n");
-        Print_exit_failure();
-    }
-    else if (info < 0)
-    {
-        fprintf(stderr, "Error! w did not converge, the last value is: %6.4lf\n", w_when_J_squared_min);
-        time_stop = time(NULL);
-        printf("Total time elapsed: %d s.\n", (int)difftime(time_stop, time_start));
-        exit(EXIT_FAILURE);
-    }
-    printf("Minimum value of J^2 encountered when w = %6.4lf.\n", w_when_J_squared_min);
-    printf("You can use \"IOp(3/107=%05u00000,3/108=%05u00000)\" in your further Gaussian input files.\n", \
-        (unsigned int)(w_when_J_squared_min * 1E4), (unsigned int)(w_when_J_squared_min * 1E4));
-    printf("\n");
-
-    /* end of task */
-    time_stop = time(NULL);
-    printf("Total time elapsed: %d s.\n", (int)difftime(time_stop, time_start));
-    printf("\n");
-    remove("N.gjf");
-    remove("N.out");
-    remove("Np1.gjf");
-    remove("Np1.out");
-    remove("Nm1.gjf");
-    remove("Nm1.out");
-
-    /* pause program on Windows is no command arguments are provided. */
-    # ifdef _WIN32
-    if (argc == 1)
-        Pause_program("Press <Enter> to exit ...");
-    # endif
-    Print_exit_success();
-
-    return 0;
-}
-
-void Print_exit_success()
-{
-    fprintf(stdout, "Exiting normally.\n");
-    exit(EXIT_SUCCESS);
-}
-
-void Print_exit_failure()
-{
-    fprintf(stderr, "Exiting abnormally.\n");
-    # ifdef _WIN32
-    if (glob_argc == 1)
-        Pause_program("Press <Enter> to exit ...");
-    # endif
-    exit(EXIT_FAILURE);
-
-    return;
-}
-
-void Pause_program(char const *prompt)
-{
-    char cont = '\0';
-
-    if (prompt)
-        printf("%s\n", prompt);
-    while ((cont = getchar()) != '\n' && cont != EOF)
-        ;
-
-    return;
-}
-
-void Get_J_and_J_squared(double *J_ptr, double *J_squared_ptr)
-{
-    double J_n = 0.0, J_np1 = 0.0;
-    double E_n = 0.0, E_np1 = 0.0, E_nm1 = 0.0;
-    double e_HOMO_n = 0.0, e_HOMO_np1 = 0.0;
-    FILE *n_ofl = NULL, *np1_ofl = NULL, *nm1_ofl = NULL;
-    long last_line_pos = 0l, this_line_pos = 0l;
-    char last_value_str[BUFSIZ + 1] = "";
-    char buf[BUFSIZ + 1] = "";
-    char *tok = NULL;
-
-    /* open files */
-    n_ofl = fopen("N.out", "rt");
-    if (! n_ofl)
-    {
-        fprintf(stderr, "Error! Cannot open \"N.out\" for reading! Check your Gaussian settings.");
-        Print_exit_failure();
-    }
-    np1_ofl = fopen("Np1.out", "rt");
-    if (! np1_ofl)
-    {
-        fprintf(stderr, "Error! Cannot open \"Np1.out\" for reading! Check your Gaussian settings.");
-        Close_file(n_ofl);
-        Print_exit_failure();
-    }
-    nm1_ofl = fopen("Nm1.out", "rt");
-    if (! nm1_ofl)
-    {
-        fprintf(stderr, "Error! Cannot open \"Nm1.out\" for reading! Check your Gaussian settings.");
-        Close_file(n_ofl);
-        Close_file(np1_ofl);
-        Print_exit_failure();
-    }
-
-    /* electron energy */
-    /* electron energy of N */
-    while (fgets(buf, BUFSIZ, n_ofl))
-    {
-        if (strstr(buf, "SCF Done"))
-            break;
-    }
-    if (sscanf(strchr(buf, '=') + 1, "%lg", & E_n) != 1)
-    {
-        fprintf(stderr, "Error! Cannot read electron energy of state N! Check your Gaussian output files.");
-        Close_file(n_ofl);
-        Close_file(np1_ofl);
-        Close_file(nm1_ofl);
-    }
-    /* electron energy of N+1 */
-    while (fgets(buf, BUFSIZ, np1_ofl))
-    {
-        if (strstr(buf, "SCF Done"))
-            break;
-    }
-    if (sscanf(strchr(buf, '=') + 1, "%lg", & E_np1) != 1)
-    {
-        fprintf(stderr, "Error! Cannot read electron energy of state N+1! Check your Gaussian output files.");
-        Close_file(n_ofl);
-        Close_file(np1_ofl);
-        Close_file(nm1_ofl);
-    }
-    /* electron energy of N-1 */
-    while (fgets(buf, BUFSIZ, nm1_ofl))
-    {
-        if (strstr(buf, "SCF Done"))
-            break;
-    }
-    if (sscanf(strchr(buf, '=') + 1, "%lg", & E_nm1) != 1)
-    {
-        fprintf(stderr, "Error! Cannot read electron energy of state N! Check your Gaussian output files.");
-        Close_file(n_ofl);
-        Close_file(np1_ofl);
-        Close_file(nm1_ofl);
-    }
-
-    /* HOMO */
-    /* there should be at least one line between, so we do not care last_line_pos in the first loop. */
-    /* HOMO of N */
-    for (;;)
-    {
-        this_line_pos = ftell(n_ofl);
-        if (! fgets(buf, BUFSIZ, n_ofl) || strstr(buf, "Alpha virt."))
-            break;
-        last_line_pos = this_line_pos;
-    }
-    fseek(n_ofl, last_line_pos, SEEK_SET);
-    fgets(buf, BUFSIZ, n_ofl);
-    /* the first string in buf should always be useless. */
-    tok = strtok(buf, " \n");
-    while ((tok = strtok(NULL, " \n")))
-        strcpy(last_value_str, tok);
-    if (sscanf(last_value_str, "%lg", & e_HOMO_n) != 1)
-    {
-        fprintf(stderr, "Error! Cannot read HOMO energy of state N! Check your Gaussian output files.");
-        Close_file(n_ofl);
-        Close_file(np1_ofl);
-        Close_file(nm1_ofl);
-    }
-    last_line_pos = 0l;
-    /* HOMO of N+1 */
-    for (;;)
-    {
-        this_line_pos = ftell(np1_ofl);
-        if (! fgets(buf, BUFSIZ, np1_ofl) || strstr(buf, "Alpha virt."))
-            break;
-        last_line_pos = this_line_pos;
-    }
-    fseek(np1_ofl, last_line_pos, SEEK_SET);
-    fgets(buf, BUFSIZ, np1_ofl);
-    tok = strtok(buf, " \n");
-    while ((tok = strtok(NULL, " \n")))
-        strcpy(last_value_str, tok);
-    if (sscanf(last_value_str, "%lg", & e_HOMO_np1) != 1)
-    {
-        fprintf(stderr, "Error! Cannot read HOMO energy of state N+1! Check your Gaussian output files.");
-        Close_file(n_ofl);
-        Close_file(np1_ofl);
-        Close_file(nm1_ofl);
-    }
-    
-    /* calculates J and J^2 */
-    J_n = fabs(e_HOMO_n + E_nm1 - E_n);
-    J_np1 = fabs(e_HOMO_np1 + E_n - E_np1);
-    * J_ptr = J_n + J_np1;
-    * J_squared_ptr = J_n * J_n + J_np1 * J_np1;
-
-    /* close files */
-    Close_file(n_ofl);
-    Close_file(np1_ofl);
-    Close_file(nm1_ofl);
-
-    return;
-}
-
-double Calc_J_squared_from_w(double w, void *args)
-{
-    char sys_command[BUFSIZ + 1] = "";
-    FILE *n_ifl = NULL, *np1_ifl = NULL, *nm1_ifl = NULL;
-    time_t time_iter_start = 0, time_iter_stop = 0;
-    double J = 0.0, J_squared = 0.0;
-    char iop_str[] = " IOp(3/107=0000000000,3/108=0000000000)\n"; /* just occupy the position here */
-    static unsigned int count_iter = 0u;
-
-    /* prepare files */
-    ++ count_iter;
-    n_ifl = fopen("N.gjf", "r+t");
-    np1_ifl = fopen("Np1.gjf", "r+t");
-    nm1_ifl = fopen("Nm1.gjf", "r+t");
-    fseek(n_ifl, glob_replace_iop_pos, SEEK_SET);
-    fseek(np1_ifl, glob_replace_iop_pos, SEEK_SET);
-    fseek(nm1_ifl, glob_replace_iop_pos, SEEK_SET);
-    sprintf(iop_str, " IOp(3/107=%05u00000,3/108=%05u00000)\n", \
-        (unsigned int)(w * 1E4), (unsigned int)(w * 1E4));
-    fprintf(n_ifl, "%s", iop_str);
-    fprintf(np1_ifl, "%s", iop_str);
-    fprintf(nm1_ifl, "%s", iop_str);
-    Close_file(n_ifl);
-    Close_file(np1_ifl);
-    Close_file(nm1_ifl);
-    time_iter_start = time(NULL);
-
-    /* Invoke Gaussian */
-    printf("Iteration: %u\n", count_iter);
-    printf("w = %6.4lf\n", w);
-    sprintf(sys_command, "%s N.gjf N.out", glob_gau_exe);
-    printf("Running Gaussian for N state:\n");
-    printf("%s\n", sys_command);
-    if (system(sys_command))
-    {
-        fprintf(stderr, "Error! Gaussian job for N state failed.\n");
-        fprintf(stderr, "Check your template file and temporary Gaussian output files.\n");
-        Print_exit_failure();
-    }
-    sprintf(sys_command, "%s Np1.gjf Np1.out", glob_gau_exe);
-    printf("Running Gaussian for N+1 state:\n");
-    printf("%s\n", sys_command);
-    if (system(sys_command))
-    {
-        fprintf(stderr, "Error! Gaussian job for N+1 state failed.\n");
-        fprintf(stderr, "Check your template file and temporary Gaussian output files.\n");
-        Print_exit_failure();
-    }
-    sprintf(sys_command, "%s Nm1.gjf Nm1.out", glob_gau_exe);
-    printf("Running Gaussian for N-1 state:\n");
-    printf("%s\n", sys_command);
-    if (system(sys_command))
-    {
-        fprintf(stderr, "Error! Gaussian job for N-1 state failed.\n");
-        fprintf(stderr, "Check your template file and temporary Gaussian output files.\n");
-        Print_exit_failure();
-    }
-
-    /* Calculates J^2 and J */
-    Get_J_and_J_squared(& J, & J_squared);
-    time_iter_stop = time(NULL);
-    printf("J = %10.8lf, J^2 = %10.8lf\n", J, J_squared);
-    printf("Time elapsed for this cycle: %d s.\n", (int)difftime(time_iter_stop, time_iter_start));
+        if (! strcmp(argv[iarg], "--surrogate"))
+        {
+            is_surrogate = true;
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--signed-J"))
+        {
+            is_signed_J = true;
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--objective"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (Parse_objective(argv[iarg], & calc.objective))
+            {
+                fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--explain"))
+        {
+            is_explain = true;
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--no-expand"))
+        {
+            is_expand = false;
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--low-basis"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            strncpy(low_basis, argv[iarg], BUFSIZ);
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--low-conver"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (sscanf(argv[iarg], "%u", & low_conver) != 1)
+            {
+                fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (! low_conver)
+            {
+                fprintf(stderr, "Error! Value after \"%s\" must be positive.\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--low-tolerance"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (sscanf(argv[iarg], "%lg", & low_tolerance) != 1)
+            {
+                fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (low_tolerance < 1E-4)
+            {
+                fprintf(stderr, "Error! Minimum acceptable tolerance of w is 0.0001, but got %6.1lg.\n", low_tolerance);
+                Print_exit_failure();
+            }
+            is_low_tolerance_given = true;
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--lattice"))
+        {
+            is_lattice = true;
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--speculate"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (sscanf(argv[iarg], "%u", & num_speculate) != 1)
+            {
+                fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (! num_speculate)
+            {
+                fprintf(stderr, "Error! Value after \"%s\" must be positive.\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--max-cycles"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (sscanf(argv[iarg], "%u", & calc.max_scf_cycle) != 1)
+            {
+                fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            calc.is_supervised = true;
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--cache"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            strncpy(calc.cache_name, argv[iarg], BUFSIZ);
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--record") || ! strcmp(argv[iarg], "--replay"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            strncpy(strcmp(argv[iarg - 1], "--record") ? calc.replay_dir : calc.record_dir, argv[iarg], BUFSIZ);
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--scratch"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            strncpy(scratch_root, argv[iarg], BUFSIZ);
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--timeout"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (sscanf(argv[iarg], "%u", & calc.job_timeout) != 1 || ! calc.job_timeout)
+            {
+                fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--pin"))
+        {
+            is_pin = true;
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--mem"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (Parse_mem(argv[iarg], & mem_bytes) || ! (mem_bytes > 0.0))
+            {
+                fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--batch"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            strncpy(batch_name, argv[iarg], BUFSIZ);
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--jobs"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (sscanf(argv[iarg], "%u", & num_job) != 1)
+            {
+                fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (! num_job)
+            {
+                fprintf(stderr, "Error! Value after \"%s\" must be positive.\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            continue;
+        }
+        fprintf(stderr, "Error! Cannot recognize argument \"%s\".\n", argv[iarg]);
+        Print_exit_failure();
+    }
+    if (w_high <= w_low)
+    {
+        fprintf(stderr, "Error! higher limit of w (%6.1lg) must be greater than lower limit of w (%6.1lg).\n", w_high, w_low);
+        Print_exit_failure();
+    }
+    if (w_guess < w_low || w_guess > w_high)
+    {
+        fprintf(stderr, "Error! Initial guess of w (%6.1lg) must be in interval [lower limit (%6.1lg), higher limit (%6.1lg)].\n", \
+            w_guess, w_low, w_high);
+        Print_exit_failure();
+    }
+    if (! is_expand)
+    {
+        w_lowest = w_low;
+        w_highest = w_high;
+    }
+    if (is_lattice && num_speculate > 1u)
+    {
+        fprintf(stderr, "Error! \"--lattice\" cannot be used with \"--speculate\".\n");
+        Print_exit_failure();
+    }
+    if (is_surrogate && (is_lattice || num_coarse))
+    {
+        fprintf(stderr, "Error! \"--surrogate\" cannot be used with \"--lattice\" or \"--coarse\".\n");
+        Print_exit_failure();
+    }
+    if (* batch_name && (calc.is_concurrent || num_speculate > 1u || is_lattice || num_coarse || is_surrogate || \
+        is_signed_J))
+    {
+        fprintf(stderr, "Error! \"--batch\" cannot be used with \"--concurrent\", \"--speculate\", \"--lattice\", " \
+            "\"--coarse\", \"--surrogate\" or \"--signed-J\".\n");
+        Print_exit_failure();
+    }
+    if (is_signed_J && (is_lattice || num_coarse || is_surrogate || num_speculate > 1u))
+    {
+        fprintf(stderr, "Error! \"--signed-J\" cannot be used with \"--lattice\", \"--coarse\", \"--surrogate\" " \
+            "or \"--speculate\".\n");
+        Print_exit_failure();
+    }
+    if (is_low_tolerance_given && ! * low_basis && ! low_conver)
+    {
+        fprintf(stderr, "Error! \"--low-tolerance\" can only be used with \"--low-basis\" or \"--low-conver\".\n");
+        Print_exit_failure();
+    }
+    if (* batch_name && (* low_basis || low_conver))
+    {
+        fprintf(stderr, "Error! \"--batch\" cannot be used with \"--low-basis\" or \"--low-conver\".\n");
+        Print_exit_failure();
+    }
+    if (num_coarse && (is_lattice || num_speculate > 1u))
+    {
+        fprintf(stderr, "Error! \"--coarse\" cannot be used with \"--lattice\" or \"--speculate\".\n");
+        Print_exit_failure();
+    }
+    if (num_coarse && W_to_iop(w_low + (w_high - w_low) / (num_coarse - 1u)) == W_to_iop(w_low))
+    {
+        fprintf(stderr, "Error! %u w from %6.4lf to %6.4lf are closer than 0.0001.\n", num_coarse, w_low, w_high);
+        Print_exit_failure();
+    }
+
+    if (* calc.record_dir && * calc.replay_dir)
+    {
+        fprintf(stderr, "Error! \"--record\" cannot be used with \"--replay\".\n");
+        Print_exit_failure();
+    }
+    if (calc.is_link1 && calc.is_chain_guess)
+    {
+        fprintf(stderr, "Error! \"--link1\" cannot be used with \"--read-guess\".\n");
+        Print_exit_failure();
+    }
+    if (* calc.record_dir && Make_record_dir(calc.record_dir))
+        Print_exit_failure();
+    if (* scratch_root && Make_scratch_dir(calc.scratch_dir, scratch_root))
+        Print_exit_failure();
+
+    if (! * calc.replay_dir && Find_gau_exe(calc.gau_exe))
+        Print_exit_failure();
+
+    if (mem_bytes > 0.0 && ! is_pin)
+    {
+        fprintf(stderr, "Error! \"--mem\" can only be used with \"--pin\".\n");
+        Print_exit_failure();
+    }
+    memset(& topo, 0, sizeof(Node_topology));
+    if (is_pin)
+    {
+        if (Read_node_topology(& topo))
+            Print_exit_failure();
+        calc.temp.topo = & topo;
+        calc.temp.mem_bytes = mem_bytes;
+        Count_node_domains(topo.cpus, topo.num_cpu, & num_node, & num_l3);
+    }
+
+    /* shared by all the templates of a batch */
+    if (* trace_name)
+    {
+        if (Open_trace(& trace, trace_name))
+            Print_exit_failure();
+        calc.trace = & trace;
+    }
+
+    /* every template of the batch is tuned with the options given */
+    if (* batch_name)
+    {
+        if (Run_batch(batch_name, & calc, multi_np1, multi_nm1, w_low, w_high, w_lowest, w_highest, w_guess, \
+            w_tolerance, max_iter, num_job, journal_name, is_resume))
+            Print_exit_failure();
+        if (calc.trace)
+            Close_trace(& trace);
+        Free_node_topology(& topo);
+        Print_exit_success();
+    }
+
+    /* check template file */
+    temp_ifl = fopen(temp_name, "rt");
+    if (! temp_ifl)
+    {
+        fprintf(stderr, "Error! Cannot find \"%s\".\n", temp_name);
+        Print_exit_failure();
+    }
+    Close_file(temp_ifl);
+
+    /* read the template, input files are generated from it for each w */
+    if (Read_template(& calc.temp, temp_name, multi_np1, multi_nm1))
+        Print_exit_failure();
+    if (is_pin)
+    {
+        calc.temp.topo = & topo;
+        calc.temp.mem_bytes = mem_bytes;
+    }
+    memset(& low_temp, 0, sizeof(Gjf_template));
+    if ((* low_basis || low_conver) && \
+        Copy_template_at_fidelity(& low_temp, & calc.temp, * low_basis ? low_basis : NULL, low_conver))
+        Print_exit_failure();
+
+    /* w evaluated before by a run killed halfway */
+    if (Open_journal(& journal, journal_name, Get_template_hash(& calc.temp, calc.objective), is_resume))
+        Print_exit_failure();
+    calc.journal = & journal;
+
+    /* show title */
+    printf("Optimize w (literally omega) in long-range correction functional of DFT.\n");
+    printf("Parameters: w_low = %6.4lf, w_high = %6.4lf, w_guess = %6.4lf, w_tolerance = %6.4lf\n", \
+        w_low, w_high, w_guess, w_tolerance);
+    printf("            Charges for N, N+1 and N-1 states: %d %d %d\n", \
+        calc.temp.charges[STATE_N], calc.temp.charges[STATE_NP1], calc.temp.charges[STATE_NM1]);
+    printf("            Multiplicities for N, N+1 and N-1 states: %u %u %u\n", \
+        calc.temp.multis[STATE_N], calc.temp.multis[STATE_NP1], calc.temp.multis[STATE_NM1]);
+    if (calc.is_concurrent)
+        printf("Will run the jobs of N, N+1 and N-1 states concurrently.\n");
+    if (* calc.cache_name)
+        printf("Will use cache file \"%s\".\n", calc.cache_name);
+    if (* calc.record_dir)
+        printf("Will keep the input and output of every job in \"%s\".\n", calc.record_dir);
+    if (* calc.replay_dir)
+        printf("Will take the outputs in \"%s\" instead of running Gaussian.\n", calc.replay_dir);
+    if (calc.job_timeout)
+        printf("Will kill a Gaussian job running longer than %u s.\n", calc.job_timeout);
+    if (* calc.scratch_dir)
+        printf("Will run every job in a directory of its own in \"%s\".\n", calc.scratch_dir);
+    if (is_pin)
+        printf("Will pin the jobs to %u processors in %u NUMA nodes and %u L3 caches.\n", topo.num_cpu, num_node, \
+            num_l3);
+    if (calc.is_chain_guess)
+        printf("Will read SCF guess from the checkpoint file of the nearest w computed.\n");
+    if (calc.is_link1)
+        printf("Will run the states of a w in one job chained by \"--Link1--\".\n");
+    if (calc.is_supervised)
+        printf("Will follow the outputs and kill the jobs bound to fail.\n");
+    if (is_resume)
+        printf("Will resume from journal \"%s\", %u w found there.\n", journal_name, journal.num_record);
+    else
+        printf("Will record every w evaluated in journal \"%s\".\n", journal_name);
+    if (calc.trace)
+        printf("Will trace every job and every step in \"%s\".\n", trace_name);
+    if (num_speculate > 1u)
+        printf("Will evaluate up to %u w at the same time.\n", num_speculate);
+    if (is_lattice)
+        printf("Will search IOp values from %05u to %05u.\n", W_to_iop(w_low), W_to_iop(w_high));
+    if (num_coarse)
+        printf("Will scan %u w at the same time before Brent's method.\n", num_coarse);
+    if (is_surrogate)
+        printf("Will choose each w by the expected improvement of a Gaussian process.\n");
+    if (calc.objective == OBJECTIVE_J_N)
+        printf("Will tune w against J_N alone, with N and N-1 states only.\n");
+    if (calc.objective == OBJECTIVE_J_NP1)
+        printf("Will tune w against J_N+1 alone, with N and N+1 states only.\n");
+    if (is_signed_J)
+        printf("Will step w by the secants of the signed J_N and J_N+1.\n");
+    if (is_explain)
+        printf("Will print every step of Brent's method.\n");
+    if (is_expand)
+        printf("Will expand [%6.4lf, %6.4lf] up to [%6.4lf, %6.4lf] if J^2 falls toward an end.\n", w_low, w_high, \
+            w_lowest, w_highest);
+    if (* low_basis || low_conver)
+    {
+        printf("Will tune w to %6.4lf at a lower fidelity first, with", low_tolerance);
+        if (* low_basis)
+            printf(" basis set %s%s", low_basis, low_conver ? " and" : "");
+        if (low_conver)
+            printf(" SCF=Conver=%u", low_conver);
+        printf(".\n");
+    }
+    printf("\n");
+    time_start = time(NULL);
+
+    /* Brent's method for minimize J^2 with variable w. */
+    observer.step = is_explain ? Brent_print_step : NULL;
+    observer.end = Brent_print_summary;
+    observer.args = stdout;
+    /* the method chosen below starts from the minimum at a lower fidelity, in a narrow interval */
+    if (* low_basis || low_conver)
+    {
+        w_guess = Tune_low_fidelity(& calc, & low_temp, w_low, w_high, w_lowest, w_highest, w_guess, low_tolerance, \
+            max_iter, & observer);
+        w_low = w_guess - LOW_FIDELITY_HALF_WIDTH > w_lowest ? w_guess - LOW_FIDELITY_HALF_WIDTH : w_lowest;
+        w_high = w_guess + LOW_FIDELITY_HALF_WIDTH < w_highest ? w_guess + LOW_FIDELITY_HALF_WIDTH : w_highest;
+        printf("Minimum at the lower fidelity: w = %6.4lf, refine it as in the template in [%6.4lf, %6.4lf].\n", \
+            w_guess, w_low, w_high);
+        printf("\n");
+    }
+    if (num_coarse)
+    {
+        glob_method = "coarse";
+        coarse_ws = (double *)malloc(num_coarse * 2u * sizeof(double));
+        if (! coarse_ws)
+        {
+            fprintf(stderr, "Error! Cannot allocate memory for the coarse scan.\n");
+            Print_exit_failure();
+        }
+        coarse_J_squareds = coarse_ws + num_coarse;
+        if (Scan_coarse(& calc, w_low, w_high, num_coarse, coarse_ws, coarse_J_squareds))
+        {
+            fprintf(stderr, "Check your template file and temporary Gaussian output files.\n");
+            Print_exit_failure();
+        }
+        for (icoarse = 0u; icoarse < num_coarse; ++ icoarse)
+        {
+            if (coarse_J_squareds[icoarse] < coarse_J_squareds[ibest])
+                ibest = icoarse;
+        }
+        printf("Minimum of the coarse scan: w = %6.4lf, J^2 = %10.8lf, refine it in [%6.4lf, %6.4lf].\n", \
+            coarse_ws[ibest], coarse_J_squareds[ibest], coarse_ws[ibest ? ibest - 1u : 0u], \
+            coarse_ws[ibest < num_coarse - 1u ? ibest + 1u : ibest]);
+        printf("\n");
+        glob_method = "brent";
+        /* only an end of the scan may be expanded, the neighbours of the best are known to be worse */
+        w_when_J_squared_min = Brent_fmin_known(coarse_ws[ibest ? ibest - 1u : 0u], \
+            coarse_ws[ibest < num_coarse - 1u ? ibest + 1u : ibest], ibest ? coarse_ws[ibest - 1u] : w_lowest, \
+            ibest < num_coarse - 1u ? coarse_ws[ibest + 1u] : w_highest, coarse_ws, coarse_J_squareds, num_coarse, \
+            Calc_J_squared_from_w, & calc, w_tolerance, max_iter, & observer, & info);
+        free(coarse_ws);
+        coarse_ws = coarse_J_squareds = NULL;
+    }
+    else if (is_lattice)
+    {
+        glob_method = "lattice";
+        w_when_J_squared_min = Lattice_fmin(W_to_iop(w_low), W_to_iop(w_high), W_to_iop(w_guess), \
+            Calc_J_squared_from_iop, & calc, max_iter, & num_eval, & info) * 1E-4;
+        if (! info)
+            printf("Brent's method on the lattice took %u evaluations.\n", num_eval);
+    }
+    else if (is_surrogate && num_speculate > 1u)
+    {
+        glob_method = "surrogate";
+        if (Init_pool(& pool, & calc, num_speculate))
+            Print_exit_failure();
+        evaluator.max_running = num_speculate;
+        evaluator.start = Start_w;
+        evaluator.wait_any = Wait_any_w;
+        evaluator.cancel = Cancel_w;
+        evaluator.is_same = Is_same_w;
+        w_when_J_squared_min = Gp_fmin_batch(w_low, w_high, w_guess, & evaluator, & pool, w_tolerance, max_iter, \
+            & num_eval, & num_round, & info);
+        Free_pool(& pool);
+        if (info == 2)
+        {
+            fprintf(stderr, "Check your template file and temporary Gaussian output files.\n");
+            Print_exit_failure();
+        }
+        printf("The Gaussian process took %u w in %u rounds of waiting for Gaussian.\n", num_eval, num_round);
+    }
+    else if (is_signed_J)
+    {
+        glob_method = "signed-J";
+        w_when_J_squared_min = Brent_fmin_residuals(w_low, w_high, w_guess, Calc_J_components_from_w, \
+            Count_states(calc.objective) - 1u, & calc, w_tolerance, max_iter, & num_eval, & info);
+        if (! info)
+            printf("The secants of the signed J took %u w.\n", num_eval);
+    }
+    else if (is_surrogate)
+    {
+        glob_method = "surrogate";
+        w_when_J_squared_min = Gp_fmin(w_low, w_high, w_guess, Calc_J_squared_from_w, & calc, w_tolerance, \
+            max_iter, & num_eval, & info);
+        if (! info)
+            printf("The Gaussian process took %u w.\n", num_eval);
+    }
+    else if (num_speculate > 1u)
+    {
+        glob_method = "speculative";
+        if (Init_pool(& pool, & calc, num_speculate))
+            Print_exit_failure();
+        evaluator.max_running = num_speculate;
+        evaluator.start = Start_w;
+        evaluator.wait_any = Wait_any_w;
+        evaluator.cancel = Cancel_w;
+        evaluator.is_same = Is_same_w;
+        w_when_J_squared_min = Brent_fmin_speculative(w_low, w_high, w_lowest, w_highest, w_guess, & evaluator, \
+            & pool, w_tolerance, max_iter, & observer, & num_round, & info);
+        Free_pool(& pool);
+        if (info == 2)
+        {
+            fprintf(stderr, "Check your template file and temporary Gaussian output files.\n");
+            Print_exit_failure();
+        }
+        printf("Brent's method took %u rounds of waiting for Gaussian.\n", num_round);
+    }
+    else
+    {
+        /* Brent_fmin, driven from here so that the interval and the kind of each step are known to the trace */
+        if (Brent_init(& brent, w_low, w_high, w_guess, w_tolerance, max_iter, & observer, & w_when_J_squared_min) || \
+            Brent_set_limits(& brent, w_lowest, w_highest))
+            info = 1;
+        else
+        {
+            do
+                Calc_point_from_w(w_when_J_squared_min, & calc, & brent, & point);
+            while ((status = Brent_tell(& brent, point.J_squared, & w_when_J_squared_min)) == BRENT_CONTINUE);
+            info = status == BRENT_NOT_CONVERGED ? -1 : 0;
+        }
+    }
+    if (info > 0)
+    {
+        fprintf(stderr, "Error! Arguments of Brent's method are illegal!\n");
+        Print_exit_failure();
+    }
+    else if (info < 0)
+    {
+        if (info == GP_FIT_FAILED)
+            fprintf(stderr, "Error! The Gaussian process cannot be fitted to the w evaluated, the best value is: %6.4lf\n", \
+                w_when_J_squared_min);
+        else
+            fprintf(stderr, "Error! w did not converge, the last value is: %6.4lf\n", w_when_J_squared_min);
+        time_stop = time(NULL);
+        printf("Total time elapsed: %d s.\n", (int)difftime(time_stop, time_start));
+        exit(EXIT_FAILURE);
+    }
+    printf("Minimum value of J^2 encountered when w = %6.4lf.\n", w_when_J_squared_min);
+    printf("You can use \"IOp(3/107=%05u00000,3/108=%05u00000)\" in your further Gaussian input files.\n", \
+        W_to_iop(w_when_J_squared_min), W_to_iop(w_when_J_squared_min));
+    printf("\n");
+
+    /* end of task */
+    time_stop = time(NULL);
+    printf("Total time elapsed: %d s.\n", (int)difftime(time_stop, time_start));
+    printf("\n");
+    Remove_state_files(& calc, "");
+    Remove_chk_files(& calc);
+    Close_journal(& journal);
+    if (calc.trace)
+        Close_trace(& trace);
+    Free_template(& calc.temp);
+    Free_template(& low_temp);
+    Free_node_topology(& topo);
+
+    /* pause program on Windows is no command arguments are provided. */
+    # ifdef _WIN32
+    if (argc == 1)
+        Pause_program("Press <Enter> to exit ...");
+    # endif
+    Print_exit_success();
+
+    return 0;
+}
+
+void Print_exit_success()
+{
+    fprintf(stdout, "Exiting normally.\n");
+    exit(EXIT_SUCCESS);
+}
+
+void Print_exit_failure()
+{
+    fprintf(stderr, "Exiting abnormally.\n");
+    # ifdef _WIN32
+    if (glob_argc == 1)
+        Pause_program("Press <Enter> to exit ...");
+    # endif
+    exit(EXIT_FAILURE);
+
+    return;
+}
+
+void Pause_program(char const *prompt)
+{
+    char cont = '\0';
+
+    if (prompt)
+        printf("%s\n", prompt);
+    while ((cont = getchar()) != '\n' && cont != EOF)
+        ;
+
+    return;
+}
+
+/* put the iter-th w evaluated into the trace, brent is the Brent's method which chose it, or NULL if not known */
+void Trace_point(Dft_w_calc const *calc, unsigned int iter, Dft_w_point const *point, Brent_state const *brent)
+{
+    char const *const step_types[] = {"guess", "golden", "parabolic"}; /* by BRENT_STEP_* */
+    double bracket[2] = {0.0, 0.0};
+
+    if (! brent)
+    {
+        Trace_step(calc->trace, calc->file_prefix, iter, point->w, point->J_squared, NULL, glob_method, point->seconds);
+        return;
+    }
+    bracket[0] = brent->a;
+    bracket[1] = brent->b;
+    Trace_step(calc->trace, calc->file_prefix, iter, point->w, point->J_squared, bracket, step_types[brent->step], \
+        point->seconds);
+
+    return;
+}
+
+/* evaluate w and print it as one iteration, brent is the Brent's method asking for it, or NULL if not known */
+void Calc_point_from_w(double w, void *args, Brent_state const *brent, Dft_w_point *point)
+{
+    Dft_w_calc *calc = (Dft_w_calc *)args;
+    time_t time_iter_start = 0, time_iter_stop = 0;
+
+    ++ calc->num_eval;
+    time_iter_start = time(NULL);
+    printf("Iteration: %u\n", calc->num_eval);
+    printf("w = %6.4lf\n", w);
+    if (Calc_J_from_w(calc, w, point))
+        Print_exit_failure();
+    time_iter_stop = time(NULL);
+    printf("J = %10.8lf, J^2 = %10.8lf\n", point->J, point->J_squared);
+    Trace_point(calc, calc->num_eval, point, brent);
+    printf("Time elapsed for this cycle: %d s.\n", (int)difftime(time_iter_stop, time_iter_start));
+    printf("\n");
+
+    return;
+}
+
+/*
+    Tune w by Brent's method like optimize_DFT_w does by default, but with the route section of low_temp
+    (see Copy_template_at_fidelity), and without the journal, returns the w of minimum J^2 found.
+    The iterations are counted on in calc, and the checkpoint files left are removed.
+*/
+double Tune_low_fidelity(Dft_w_calc *calc, Gjf_template const *low_temp, double w_low, double w_high, \
+    double w_lowest, double w_highest, double w_guess, double w_tolerance, unsigned int max_iter, \
+    Brent_observer const *observer)
+{
+    Dft_w_calc low_calc = * calc;
+    Brent_state brent;
+    Dft_w_point point;
+    int status = BRENT_CONTINUE;
+    double w = w_guess;
+
+    low_calc.temp = * low_temp;
+    low_calc.journal = NULL;
+    if (Brent_init(& brent, w_low, w_high, w_guess, w_tolerance, max_iter, observer, & w) || \
+        Brent_set_limits(& brent, w_lowest, w_highest))
+    {
+        fprintf(stderr, "Error! Arguments of Brent's method are illegal!\n");
+        Print_exit_failure();
+    }
+    do
+        Calc_point_from_w(w, & low_calc, & brent, & point);
+    while ((status = Brent_tell(& brent, point.J_squared, & w)) == BRENT_CONTINUE);
+    if (status == BRENT_NOT_CONVERGED)
+        fprintf(stderr, "Warning! w did not converge at the lower fidelity, going on from %6.4lf.\n", w);
+    calc->num_eval = low_calc.num_eval;
+    Remove_chk_files(& low_calc);
+
+    return w;
+}
+
+double Calc_J_squared_from_w(double w, void *args)
+{
+    Dft_w_point point;
+
+    Calc_point_from_w(w, args, NULL, & point);
+
+    return point.J_squared;
+}
+
+/* the signed J_N and J_N+1 of w in Js, those in the objective only, for Brent_fmin_residuals */
+int Calc_J_components_from_w(double w, double *Js, void *args)
+{
+    Dft_w_calc const *calc = (Dft_w_calc const *)args;
+    Dft_w_point point;
+    unsigned int num_J = 0u;
+
+    Calc_point_from_w(w, args, NULL, & point);
+    if (calc->objective & (1u << STATE_NM1))
+        Js[num_J ++] = point.J_n;
+    if (calc->objective & (1u << STATE_NP1))
+        Js[num_J ++] = point.J_np1;
+
+    return 0;
+}
+
+/* the IOp value iop, w in 1E-4, for Brent's method on the lattice */
+double Calc_J_squared_from_iop(long iop, void *args)
+{
+    return Calc_J_squared_from_w(iop * 1E-4, args);
+}
+
+/*
+    Evaluate num_w w evenly spaced in [w_low, w_high] at the same time, and J^2 of ws[i] in J_squareds[i].
+    Returns 0 on success.
+*/
+int Scan_coarse(Dft_w_calc *calc, double w_low, double w_high, unsigned int num_w, double *ws, double *J_squareds)
+{
+    Dft_w_pool pool;
+    Dft_w_point point;
+    unsigned int iw = 0u, num_done = 0u;
+    int error = 0;
+
+    if (Init_pool(& pool, calc, num_w))
+        return 1;
+    for (iw = 0u; iw < num_w; ++ iw)
+    {
+        ws[iw] = w_low + (w_high - w_low) * iw / (num_w - 1u);
+        if (Start_point(& pool, ws[iw]))
+        {
+            Free_pool(& pool);
+            return 1;
+        }
+    }
+    for (num_done = 0u; num_done < num_w; ++ num_done)
+    {
+        error = Wait_any_point(& pool, & point);
+        if (error)
+        {
+            if (error > 0)
+                fprintf(stderr, "Error! Cannot calculate J at w = %6.4lf.\n", point.w);
+            Free_pool(& pool);
+            return 1;
+        }
+        for (iw = 0u; iw < num_w; ++ iw)
+        {
+            if (W_to_iop(ws[iw]) == W_to_iop(point.w))
+                J_squareds[iw] = point.J_squared;
+        }
+        Trace_point(calc, num_done + 1u, & point, NULL);
+        printf("Coarse scan: %u of %u done\n", num_done + 1u, num_w);
+        printf("w = %6.4lf\n", point.w);
+        printf("J = %10.8lf, J^2 = %10.8lf\n", point.J, point.J_squared);
+        printf("\n");
+    }
+    Free_pool(& pool);
+
+    return 0;
+}
+
+/* callbacks of the speculative Brent's method, args is a Dft_w_pool */
+
+int Start_w(double w, void *args)
+{
+    return Start_point((Dft_w_pool *)args, w);
+}
+
+int Wait_any_w(double *w_ptr, double *J_squared_ptr, void *args)
+{
+    Dft_w_pool *pool = (Dft_w_pool *)args;
+    Dft_w_point point;
+    int error = 0;
+
+    error = Wait_any_point(pool, & point);
+    if (error < 0)
+        return 1;
+    * w_ptr = point.w;
+    if (error)
+    {
+        fprintf(stderr, "Error! Cannot calculate J at w = %6.4lf.\n", point.w);
+        return 1;
+    }
+    ++ pool->calc->num_eval;
+    Trace_point(pool->calc, pool->calc->num_eval, & point, NULL);
+    printf("Evaluation: %u\n", pool->calc->num_eval);
+    printf("w = %6.4lf\n", point.w);
+    printf("J = %10.8lf, J^2 = %10.8lf\n", point.J, point.J_squared);
+    printf("\n");
+    * J_squared_ptr = point.J_squared;
+
+    return 0;
+}
+
+void Cancel_w(double w, void *args)
+{
+    printf("Cancel w = %6.4lf, it is not needed.\n", w);
+    Cancel_point((Dft_w_pool *)args, w);
+
+    return;
+}
+
+/* w is written into the input files as an integer, IOp(3/107) */
+int Is_same_w(double w1, double w2, void *args)
+{
+    (void)args;
+
+    return W_to_iop(w1) == W_to_iop(w2);
+}
+
+/* for qsort of file names */
+int Compare_names(void const *name1, void const *name2)
+{
+    return strcmp(* (char const *const *)name1, * (char const *const *)name2);
+}
+
+/* whether file_name ends like the input of a job, such as "Np1.gjf" or "benzene_Nm1_02000.gjf" */
+bool Is_job_file_name(char const *file_name)
+{
+    char const *end = file_name + strlen(file_name);
+    char const *stem_end = NULL;
+    unsigned int istate = 0u;
+    size_t stem_len = 0u;
+
+    if (end - file_name < 4 || strcmp(end - 4, ".gjf"))
+        return false;
+    end -= 4;
+    /* "_02000" of w */
+    if (end - file_name >= 6 && end[- 6] == '_' && strspn(end - 5, "0123456789") >= 5u)
+        end -= 6;
+    for (istate = 0u; istate < NUM_STATE; ++ istate)
+    {
+        stem_len = strlen(state_stems[istate]);
+        if (end - file_name < (long)stem_len || strncmp(end - stem_len, state_stems[istate], stem_len))
+            continue;
+        stem_end = end - stem_len;
+        if (stem_end == file_name || stem_end[- 1] == '_' || stem_end[- 1] == '/' || stem_end[- 1] == '\\')
+            return true;
+    }
+
+    return false;
+}
+
+/* add a copy of name to the end of * names_ptr, returns 0 on success. */
+int Append_name(char ***names_ptr, unsigned int *num_name_ptr, char const *name)
+{
+    char **new_names = (char **)realloc(* names_ptr, (* num_name_ptr + 1u) * sizeof(char *));
+
+    if (! new_names)
+        return 1;
+    * names_ptr = new_names;
+    new_names[* num_name_ptr] = (char *)malloc(strlen(name) + 1u);
+    if (! new_names[* num_name_ptr])
+        return 1;
+    strcpy(new_names[* num_name_ptr], name);
+    ++ * num_name_ptr;
+
+    return 0;
+}
+
+void Free_names(char **names, unsigned int num_name)
+{
+    unsigned int iname = 0u;
+
+    for (iname = 0u; iname < num_name; ++ iname)
+        free(names[iname]);
+    free(names);
+
+    return;
+}
+
+/*
+    The templates of a batch: every "*.gjf" in the directory list_name but the inputs of jobs left by
+    an earlier run, in alphabetical order, or every file named in list_name, one on each line, skipping
+    blank lines and lines starting with "#". Returns 0 on success, * temp_names_ptr is freed by Free_names.
+*/
+int Read_batch_list(char const *list_name, char ***temp_names_ptr, unsigned int *num_temp_ptr)
+{
+    struct stat list_stat;
+    char **temp_names = NULL;
+    unsigned int num_temp = 0u;
+    char temp_name[2 * BUFSIZ + 2] = "";
+    char line[BUFSIZ + 1] = "";
+    char *start = NULL, *end = NULL;
+    FILE *list_ifl = NULL;
+    int error = 0;
+    # ifdef _WIN32
+    struct _finddata_t entry;
+    intptr_t handle = - 1;
+    # else
+    DIR *dir = NULL;
+    struct dirent *entry = NULL;
+    # endif
+
+    if (! stat(list_name, & list_stat) && (list_stat.st_mode & S_IFDIR))
+    {
+        # ifdef _WIN32
+        sprintf(temp_name, "%s\\*.gjf", list_name);
+        handle = _findfirst(temp_name, & entry);
+        if (handle != - 1)
+        {
+            do
+            {
+                sprintf(temp_name, "%s\\%s", list_name, entry.name);
+                if (! Is_job_file_name(temp_name) && Append_name(& temp_names, & num_temp, temp_name))
+                    error = 1;
+            } while (! error && ! _findnext(handle, & entry));
+            _findclose(handle);
+        }
+        # else
+        dir = opendir(list_name);
+        if (! dir)
+        {
+            fprintf(stderr, "Error! Cannot open directory \"%s\".\n", list_name);
+            return 1;
+        }
+        while (! error && (entry = readdir(dir)))
+        {
+            sprintf(temp_name, "%s/%s", list_name, entry->d_name);
+            if (strlen(entry->d_name) > 4u && ! strcmp(entry->d_name + strlen(entry->d_name) - 4u, ".gjf") && \
+                ! Is_job_file_name(temp_name) && Append_name(& temp_names, & num_temp, temp_name))
+                error = 1;
+        }
+        closedir(dir);
+        # endif
+        if (! error && num_temp)
+            qsort(temp_names, num_temp, sizeof(char *), Compare_names);
+    }
+    else
+    {
+        list_ifl = fopen(list_name, "rt");
+        if (! list_ifl)
+        {
+            fprintf(stderr, "Error! Cannot open \"%s\".\n", list_name);
+            return 1;
+        }
+        while (! error && fgets(line, BUFSIZ + 1, list_ifl))
+        {
+            for (start = line; * start == ' ' || * start == '\t'; ++ start)
+                ;
+            for (end = start + strlen(start); end > start && strchr(" \t\r\n", end[- 1]); -- end)
+                ;
+            * end = '\0';
+            if (! * start || * start == '#')
+                continue;
+            if (Append_name(& temp_names, & num_temp, start))
+                error = 1;
+        }
+        Close_file(list_ifl);
+    }
+    if (error)
+    {
+        fprintf(stderr, "Error! Cannot allocate memory for the names of templates.\n");
+        Free_names(temp_names, num_temp);
+        return 1;
+    }
+    if (! num_temp)
+    {
+        fprintf(stderr, "Error! No template found in \"%s\".\n", list_name);
+        return 1;
+    }
+    * temp_names_ptr = temp_names;
+    * num_temp_ptr = num_temp;
+
+    return 0;
+}
+
+/*
+    Tune every template of list_name (see Read_batch_list) by Brent's method of its own, with the options
+    in options but the template, [w_low, w_high] of each expanded up to [w_lowest, w_highest] if needed.
+    The jobs of all the templates share num_job slots, and the earliest job waiting takes the slot freed
+    by any job, so the processors are kept busy until the last template ends.
+    Returns 0 if w of every template converged.
+*/
+int Run_batch(char const *list_name, Dft_w_calc *options, unsigned int multi_np1, unsigned int multi_nm1, \
+    double w_low, double w_high, double w_lowest, double w_highest, double w_guess, double w_tolerance, \
+    unsigned int max_iter, unsigned int num_job, char const *journal_name, bool is_resume)
+{
+    char **temp_names = NULL;
+    unsigned int num_temp = 0u, itemp = 0u, num_running = 0u, num_failed = 0u;
+    Dft_w_molecule *molecules = NULL, *molecule = NULL;
+    Dft_w_pool pool;
+    Dft_w_calc *calc = NULL;
+    Dft_w_point point;
+    char prefixed_name[2 * BUFSIZ + 2] = "";
+    size_t name_len = 0u;
+    int error = 0;
+    time_t time_start = 0, time_stop = 0;
+
+    if (Read_batch_list(list_name, & temp_names, & num_temp))
+        return 1;
+    molecules = (Dft_w_molecule *)calloc(num_temp, sizeof(Dft_w_molecule));
+    if (! molecules || Init_shared_pool(& pool, options, num_temp, num_job))
+    {
+        fprintf(stderr, "Error! Cannot allocate memory for %u templates.\n", num_temp);
+        free(molecules);
+        Free_names(temp_names, num_temp);
+        return 1;
+    }
+
+    /* show title */
+    printf("Optimize w (literally omega) in long-range correction functional of DFT for %u templates in \"%s\".\n", \
+        num_temp, list_name);
+    printf("Parameters: w_low = %6.4lf, w_high = %6.4lf, w_guess = %6.4lf, w_tolerance = %6.4lf\n", \
+        w_low, w_high, w_guess, w_tolerance);
+    printf("Will run up to %u Gaussian jobs at the same time.\n", num_job);
+    if (* options->cache_name)
+        printf("Will use cache file \"%s\".\n", options->cache_name);
+    if (* options->record_dir)
+        printf("Will keep the input and output of every job in \"%s\".\n", options->record_dir);
+    if (* options->replay_dir)
+        printf("Will take the outputs in \"%s\" instead of running Gaussian.\n", options->replay_dir);
+    if (options->job_timeout)
+        printf("Will kill a Gaussian job running longer than %u s.\n", options->job_timeout);
+    if (* options->scratch_dir)
+        printf("Will run every job in a directory of its own in \"%s\".\n", options->scratch_dir);
+    if (options->temp.topo)
+        printf("Will pin the jobs to %u processors.\n", options->temp.topo->num_cpu);
+    if (options->is_chain_guess)
+        printf("Will read SCF guess from the checkpoint file of the nearest w computed.\n");
+    if (options->is_link1)
+        printf("Will run the states of a w in one job chained by \"--Link1--\".\n");
+    if (options->is_supervised)
+        printf("Will follow the outputs and kill the jobs bound to fail.\n");
+    printf("\n");
+    time_start = time(NULL);
+
+    /* each template with its own files, journal and Brent's method, "mols/benzene.gjf" as "mols/benzene_" */
+    for (itemp = 0u; itemp < num_temp; ++ itemp)
+    {
+        molecule = & molecules[itemp];
+        strncpy(molecule->temp_name, temp_names[itemp], BUFSIZ);
+        molecule->calc = * options;
+        molecule->calc.journal = NULL;
+        name_len = strlen(molecule->temp_name);
+        if (name_len > 4u && ! strcmp(molecule->temp_name + name_len - 4u, ".gjf"))
+            name_len -= 4u;
+        if (name_len + 1u > BUFSIZ)
+            name_len = BUFSIZ - 1u;
+        sprintf(molecule->calc.file_prefix, "%.*s_", (int)name_len, molecule->temp_name);
+        molecule->time_start = molecule->time_stop = time(NULL);
+        molecule->status = BATCH_FAILED;
+        if (Read_template(& molecule->calc.temp, molecule->temp_name, multi_np1, multi_nm1))
+            continue;
+        molecule->calc.temp.topo = options->temp.topo;
+        molecule->calc.temp.mem_bytes = options->temp.mem_bytes;
+        molecule->is_template_read = true;
+        sprintf(prefixed_name, "%s%s", molecule->calc.file_prefix, journal_name);
+        if (Open_journal(& molecule->journal, prefixed_name, Get_template_hash(& molecule->calc.temp, \
+            molecule->calc.objective), is_resume))
+            continue;
+        molecule->is_journal_open = true;
+        molecule->calc.journal = & molecule->journal;
+        if (is_resume)
+            printf("%s: %u w found in journal \"%s\".\n", molecule->temp_name, molecule->journal.num_record, \
+                prefixed_name);
+        if (Brent_init(& molecule->brent, w_low, w_high, w_guess, w_tolerance, max_iter, NULL, & molecule->w) || \
+            Brent_set_limits(& molecule->brent, w_lowest, w_highest) || \
+            Start_point_of(& pool, & molecule->calc, molecule->w))
+            continue;
+        molecule->status = BRENT_CONTINUE;
+        ++ num_running;
+    }
+
+    /* whichever w ends, its template takes the next step */
+    while (num_running)
+    {
+        error = Wait_any_point_of(& pool, & calc, & point);
+        if (error < 0)
+            break;
+        for (itemp = 0u; & molecules[itemp].calc != calc; ++ itemp)
+            ;
+        molecule = & molecules[itemp];
+        if (! error)
+        {
+            ++ calc->num_eval;
+            printf("%s: evaluation %u, w = %6.4lf, J = %10.8lf, J^2 = %10.8lf\n", molecule->temp_name, \
+                calc->num_eval, point.w, point.J, point.J_squared);
+            Trace_point(calc, calc->num_eval, & point, & molecule->brent);
+            molecule->status = Brent_tell(& molecule->brent, point.J_squared, & molecule->w);
+            if (molecule->status == BRENT_CONTINUE && ! Start_point_of(& pool, calc, molecule->w))
+                continue;
+        }
+        if (error || molecule->status == BRENT_CONTINUE)
+        {
+            fprintf(stderr, "Error! Cannot calculate J of \"%s\" at w = %6.4lf, stop tuning it.\n", \
+                molecule->temp_name, point.w);
+            molecule->status = BATCH_FAILED;
+        }
+        -- num_running;
+        molecule->time_stop = time(NULL);
+        molecule->J_squared = molecule->brent.fx;
+        if (molecule->status == BRENT_CONVERGED)
+            printf("%s: converged, w = %6.4lf, J^2 = %10.8lf, use \"IOp(3/107=%05u00000,3/108=%05u00000)\".\n", \
+                molecule->temp_name, molecule->w, molecule->J_squared, W_to_iop(molecule->w), W_to_iop(molecule->w));
+        else if (molecule->status == BRENT_NOT_CONVERGED)
+            fprintf(stderr, "Error! w of \"%s\" did not converge, the last value is: %6.4lf\n", molecule->temp_name, \
+                molecule->w);
+    }
+    Free_pool(& pool);
+    time_stop = time(NULL);
+
+    /* summary of all the templates */
+    printf("\n");
+    printf("%-40s %-13s %6s %5s %12s %5s %8s\n", "Template", "Status", "w", "IOp", "J^2", "w run", "Time (s)");
+    for (itemp = 0u; itemp < num_temp; ++ itemp)
+    {
+        molecule = & molecules[itemp];
+        if (molecule->status == BRENT_CONVERGED)
+            printf("%-40s %-13s %6.4lf %05u %12.8lf %5u %8d\n", molecule->temp_name, "converged", molecule->w, \
+                W_to_iop(molecule->w), molecule->J_squared, molecule->calc.num_eval, \
+                (int)difftime(molecule->time_stop, molecule->time_start));
+        else
+        {
+            printf("%-40s %-13s %6s %5s %12s %5u %8d\n", molecule->temp_name, \
+                molecule->status == BRENT_NOT_CONVERGED ? "not converged" : "failed", \
+                "-", "-", "-", molecule->calc.num_eval, (int)difftime(molecule->time_stop, molecule->time_start));
+            ++ num_failed;
+        }
+        if (molecule->is_template_read)
+        {
+            Remove_chk_files(& molecule->calc);
+            Free_template(& molecule->calc.temp);
+        }
+        if (molecule->is_journal_open)
+            Close_journal(& molecule->journal);
+    }
+    printf("%u of %u templates converged.\n", num_temp - num_failed, num_temp);
+    printf("Total time elapsed: %d s.\n", (int)difftime(time_stop, time_start));
     printf("\n");
+    free(molecules);
+    Free_names(temp_names, num_temp);
 
-    return J_squared;
+    return num_failed ? 1 : 0;
 }
@@ -14,18 +14,16 @@
 # include <time.h>
 # include <stdbool.h>
 
+# include "dft_w_calc.h"
+# include "gau_run.h"
+
 int glob_argc = 1;
-long glob_replace_iop_place = 0l;
-char glob_gau_exe[BUFSIZ + 1] = "";
 
 # define Close_file(flp) fclose(flp); flp = NULL
 
 void Print_exit_success();
 void Print_exit_failure();
 void Pause_program(char const *prompt);
-void Get_J_and_J_squared(double *J_ptr, double *J_squared_ptr);
-double Calc_J_squared_from_w(double w, double *info_e_HOMO_n_ptr, double *info_e_HOMO_np1_ptr, \
-    double *info_E_n_ptr, double *info_E_np1_ptr, double *info_E_nm1_ptr);
 
 int main(int argc, char const *argv[])
 {
@@ -34,41 +32,58 @@ int main(int argc, char const *argv[])
     double w_low = 0.05, w_high = 1.0;
     double w_stepsize = 0.05;
     double w_current = w_low;
-    double J_squared_current = 0.0;
+    double *ws = NULL;
 
-    unsigned int multi_n = 0u, multi_np1 = 0u, multi_nm1 = 0u; /* p for +, n for -, 0 for not set */
-    int charge_n = 0, charge_np1 = -1, charge_nm1 = 1;
+    unsigned int multi_np1 = 0u, multi_nm1 = 0u; /* p for +, n for -, 0 for not set */
 
     bool is_verbose = false;
 
     char const temp_name[] = "template.gjf";
     FILE *temp_ifl = NULL;
-    FILE *n_ifl = NULL, *np1_ifl = NULL, *nm1_ifl = NULL;
-
-    char env_gauss_exedir_copy[BUFSIZ + 1] = "";
-    char *env_gauss_exedir = NULL;
-    char const *env_gauss_exedir_ptr = getenv("GAUSS_EXEDIR");
-
-    char buf[BUFSIZ + 1] = "";
-    char *line_end = NULL;
 
-    # ifdef _WIN32
-    char const path_splitter[] = ";";
-    # else
-    char const path_splitter[] = ":";
-    # endif
+    Dft_w_calc calc;
+
+    char journal_name[BUFSIZ + 1] = "scan_DFT_w.journal";
+    Dft_w_journal journal;
+    bool is_resume = false;
+    char trace_name[BUFSIZ + 1] = ""; /* "" for no trace */
+    char scratch_root[BUFSIZ + 1] = ""; /* where the jobs run, "" for the working directory */
+    Dft_w_trace trace;
+    bool *is_replayeds = NULL; /* found in the journal */
+    Dft_w_point *points = NULL;
+
+    unsigned int num_job = 0u, num_core = 0u; /* 0 for not set */
+    bool is_pin = false; /* pin each job to a slice of the processors and the memory of this node */
+    Node_topology topo;
+    double mem_bytes = 0.0; /* with "--pin", the memory shared by the jobs, 0 for as in the template */
+    unsigned int num_node = 0u, num_l3 = 0u;
+    Gau_slots slots;
+    Gau_log_stream *streams = NULL;
+    Gau_command command;
+    char tag[BUFSIZ + 1] = "";
+    char out_name[BUFSIZ + 1] = "";
+    unsigned int itask = 0u, next_task = 0u, next_point_print = 0u, ipoint = 0u, istate = 0u;
+    unsigned int *nums_state_done = NULL;
+    unsigned int *job_state_masks = NULL; /* with "--link1", the states run by the job of each point */
+    unsigned int state_mask = 0u;
+    char label[NUM_STATE * 4u] = "";
+    double *time_point_starts = NULL; /* by Get_monotonic_time */
+    double *cpu_times = NULL; /* of all the jobs of each point */
+    long *max_rss_kbs = NULL; /* of the largest job of each point */
+    int islot = 0, exit_status = 0;
+    bool is_failed = false;
 
     double J_squared_min = INFINITY;
     double w_when_J_squared_min = 0.0;
 
-    double info_E_n = 0.0, info_E_np1 = 0.0, info_E_nm1 = 0.0, info_e_HOMO_n = 0.0, info_e_HOMO_np1 = 0.0;
-
     time_t time_start = 0, time_stop = 0;
-    time_t time_step_start = 0, time_step_stop = 0;
+    double time_step_stop = 0.0;
 
     unsigned int num_point = 0u;
 
     glob_argc = argc;
+    memset(& calc, 0, sizeof(Dft_w_calc));
+    calc.objective = OBJECTIVE_J_BOTH;
 
     /* check command arguments, if "-h" or "--help" appears, print help message and exit. */
     for (iarg = 1; iarg != argc; ++ iarg)
@@ -84,6 +99,24 @@ int main(int argc, char const *argv[])
             printf("    [ --multi-np1 MULTIPLICITY_N+1 ]        The multiplicity of N+1 state.\n");
             printf("    [ --multi-nm1 MULTIPLICITY_N-1 ]        The multiplicity of N-1 state.\n");
             printf("    [ --verbose ]                           Print HOMO energies and electron energies.\n");
+            printf("    [ --objective OBJECTIVE ]               Scan J^2 of J_N (\"IP\"), J_N+1 (\"EA\") or both (\"both\").\n");
+            printf("    [ --concurrent ]                        Run the jobs of N, N+1 and N-1 states at the same time.\n");
+            printf("    [ --jobs NUM_JOB ]                      Run at most NUM_JOB Gaussian jobs at the same time.\n");
+            printf("    [ --cores NUM_CORE ]                    The number of processors shared by all jobs.\n");
+            printf("    [ --cache CACHE_FILE ]                  Reuse and keep energies in CACHE_FILE.\n");
+            printf("    [ --read-guess ]                        Start SCF from the checkpoint of the nearest w done.\n");
+            printf("    [ --link1 ]                             Run N, N+1 and N-1 states of a w in one job chained by --Link1--.\n");
+            printf("    [ --supervise ]                         Follow the outputs and kill the jobs bound to fail.\n");
+            printf("    [ --journal JOURNAL_FILE ]              Record every w evaluated in JOURNAL_FILE.\n");
+            printf("    [ --resume ]                            Take the w recorded in JOURNAL_FILE instead of running them.\n");
+            printf("    [ --max-cycles MAX_CYCLE ]              With \"--supervise\", kill a job running more SCF cycles.\n");
+            printf("    [ --record DIRECTORY ]                  Keep the input and output of every job in DIRECTORY.\n");
+            printf("    [ --replay DIRECTORY ]                  Take the outputs kept in DIRECTORY instead of running Gaussian.\n");
+            printf("    [ --timeout SECONDS ]                   Kill a Gaussian job running longer than SECONDS.\n");
+            printf("    [ --scratch DIRECTORY ]                 Run every job in a directory of its own in DIRECTORY.\n");
+            printf("    [ --trace TRACE_FILE ]                  Write a record of every job and every point into TRACE_FILE.\n");
+            printf("    [ --pin ]                               Pin each job to its own processors of this node.\n");
+            printf("    [ --mem MEMORY ]                        With \"--pin\", split MEMORY (like \"16GB\") among the jobs.\n");
             printf("\n");
             printf("\"N\" stands for the reference state, \"N+1\" stands for \"N\" plus an extra electron, \n");
             printf("and \"N-1\" stands for \"N\" minus an electron.\n");
@@ -91,6 +124,46 @@ int main(int argc, char const *argv[])
             printf("W_GUESS = (W_LOW + W_HIGH) / 2, MULTIPLICITY_N-1 and MULTIPLICITY_N+1 = (both) \n");
             printf("\"multiplicity of reference state\" + 1, where \n");
             printf("\"multiplicity of reference state\" is read from \"template.gjf\", and no verobse printing.\n");;
+            printf("NUM_JOB = 1 (3 with \"--concurrent\"), or NUM_CORE / \"processors in template\" if only NUM_CORE is given, \n");
+            printf("NUM_CORE = \"processors in template\", from %%CPU or %%NProcShared.\n");
+            printf("The processors and the memory (%%Mem) are split evenly among the jobs running at the same time, \n");
+            printf("and all (w, state) pairs are run in the order of w.\n");
+            printf("CACHE_FILE can be shared with optimize_DFT_w and other runs at the same time, and the states\n");
+            printf("of w found there for the same template are not run again.\n");
+            printf("With \"--read-guess\", each state keeps its own checkpoint files (like \"Np1_02000.chk\") and \n");
+            printf("later jobs of it read the guess from the one of nearest w, those files are removed at the end.\n");
+            printf("With \"--link1\", the states of a w not found in CACHE_FILE run in a single job (\"N.gjf\" or the file \n");
+            printf("of the first of them), so Gaussian starts once for them, and N+1 and N-1 states read the geometry \n");
+            printf("and the SCF guess from the checkpoint file left by the state before (unless the template says \n");
+            printf("\"Guess\" or \"Geom\" itself). It cannot be used with \"--read-guess\".\n");
+            printf("With \"--supervise\", a job is killed as soon as \"Error termination\", \"Convergence failure\" \n");
+            printf("or more than MAX_CYCLE SCF cycles (no limit by default) show up in its output, and if one job fails, \n");
+            printf("the other jobs running are killed at once.\n");
+            printf("JOURNAL_FILE = \"%s\", every w evaluated is appended to it and flushed to the disk at once, \n", journal_name);
+            printf("and it is started again unless \"--resume\" is given, which continues a run killed halfway.\n");
+            printf("With \"--record\", the input and the output of every job which ends are copied into DIRECTORY \n");
+            printf("(created if needed) as \"N_02000.gjf\", \"N_02000.out\" and so on, by state and IOp value. \n");
+            printf("With \"--replay\", the outputs recorded so are copied in place of running Gaussian, \n");
+            printf("so a recorded run is reproduced exactly, and GAUSS_EXEDIR is not needed. \n");
+            printf("With \"--timeout\", a job running longer than SECONDS (wall-clock time, no limit by default) is killed \n");
+            printf("and counted as failed. With \"--verbose\", the CPU time and the peak memory of the jobs of each point \n");
+            printf("are printed as well.\n");
+            printf("With \"--scratch\", every job runs in a directory of its own, which is its GAUSS_SCRDIR as well, \n");
+            printf("in a directory of this run in DIRECTORY (a fast local one, like /dev/shm), where the checkpoint \n");
+            printf("files of \"--read-guess\" are kept too. Only the energies (and with \"--record\", the inputs and \n");
+            printf("the outputs) are taken from there, and the output of a job which fails is copied here. All of it \n");
+            printf("is removed as soon as it is not needed, or when the program exits, even if it fails or is killed.\n");
+            printf("With \"--trace\", TRACE_FILE (replaced if it exists) gets one JSON object on each line for every job, \n");
+            printf("with its times, CPU time, peak memory, SCF cycles and exit status, and for every point. \n");
+            printf("With \"--pin\", the processors this program may run on (those in %%CPU of the template as well, \n");
+            printf("if any, and only NUM_CORE of them) are dealt out to the jobs as %%CPU lists, whole NUMA nodes first, \n");
+            printf("then cores sharing an L3 cache together, and MEMORY (%%Mem of the template, or 3/4 of the memory \n");
+            printf("available, by default) is split evenly among them, so that the jobs do not share caches or \n");
+            printf("move between nodes. It needs Linux.\n");
+            printf("With \"--objective IP\", J^2 is of J_N = e_HOMO(N) + IP(N) alone, and only N and N-1 states are run, \n");
+            printf("and with \"--objective EA\", of J_N+1 = e_HOMO(N+1) + IP(N+1) alone, and only N and N+1 states are run \n");
+            printf("(OBJECTIVE = \"both\", where J^2 = J_N^2 + J_N+1^2, by default). JOURNAL_FILE keeps the w of each \n");
+            printf("objective apart, while the states in CACHE_FILE are shared by all of them.\n");
             printf("\n");
             printf("You need to prepare a template file called \"template.gjf\" in the current working directory, \n");
             printf("which is the entire input single point energy task file, except the IOps for tuning w.\n");
@@ -128,7 +201,7 @@ int main(int argc, char const *argv[])
                 fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
                 Print_exit_failure();
             }
-            if (w_low <= 0.0 || (unsigned int)(w_low * 1E4) < 1)
+            if (w_low <= 0.0 || W_to_iop(w_low) < 1)
             {
                 fprintf(stderr, "Error! Minimal acceptable w is 0.0001, but got %6.1lg.\n", w_low);
                 Print_exit_failure();
@@ -153,7 +226,7 @@ int main(int argc, char const *argv[])
                 fprintf(stderr, "Error! Higher limit of w must be positive, but got %6.1lg.\n", w_high);
                 Print_exit_failure();
             }
-            if ((unsigned int)(w_high * 1E4) >= 1E5)
+            if (W_to_iop(w_high) >= 1E5)
             {
                 fprintf(stderr, "Error! Maximum acceptable w is 10, but got %6.1lg.\n", w_high);
                 Print_exit_failure();
@@ -230,239 +303,469 @@ int main(int argc, char const *argv[])
             is_verbose = true;
             continue;
         }
-        fprintf(stderr, "Error! Cannot recognize argument \"%s\".\n", argv[iarg]);
-        Print_exit_failure();
-    }
-    if (w_high <= w_low)
-    {
-        fprintf(stderr, "Error! higher limit of w (%6.1lg) must be greater than lower limit of w (%6.1lg).\n", w_high, w_low);
-        Print_exit_failure();
-    }
-
-    if (! env_gauss_exedir_ptr || ! strcmp(env_gauss_exedir_ptr, ""))
-    {
-        fprintf(stderr, "Error! Environment variable \"GAUSS_EXEDIR\" is not set properly!\n");
-        Print_exit_failure();
-    }
-    strcpy(env_gauss_exedir_copy, env_gauss_exedir_ptr);
-    env_gauss_exedir = strtok(env_gauss_exedir_copy, path_splitter);
-    while (env_gauss_exedir)
-    {
-        if (strchr(env_gauss_exedir, ' '))
+        if (! strcmp(argv[iarg], "--concurrent"))
         {
-            # ifdef _WIN32
-            sprintf(glob_gau_exe, "\"%s%s\"", env_gauss_exedir, "\\g16.exe"); /* assume it is Gaussian 16 */
-            # else
-            sprintf(glob_gau_exe, "\"%s%s\"", env_gauss_exedir, "/g16");
-            # endif
+            if (num_job < NUM_STATE)
+                num_job = NUM_STATE;
+            continue;
         }
-        else
+        if (! strcmp(argv[iarg], "--read-guess"))
         {
-            # ifdef _WIN32
-            sprintf(glob_gau_exe, "%s%s", env_gauss_exedir, "\\g16.exe");
-            # else
-            sprintf(glob_gau_exe, "%s%s", env_gauss_exedir, "/g16");
-            # endif
+            calc.is_chain_guess = true;
+            continue;
         }
-        if (access(glob_gau_exe, X_OK))
+        if (! strcmp(argv[iarg], "--link1"))
         {
-            if (strchr(env_gauss_exedir, ' '))
+            calc.is_link1 = true;
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--resume"))
+        {
+            is_resume = true;
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--journal"))
+        {
+            ++ iarg;
+            if (iarg == argc)
             {
-                # ifdef _WIN32
-                sprintf(glob_gau_exe, "\"%s%s\"", env_gauss_exedir, "\\g09.exe"); /* assume it is Gaussian 16 */
-                # else
-                sprintf(glob_gau_exe, "\"%s%s\"", env_gauss_exedir, "/g09");
-                # endif
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
             }
-            else
+            strncpy(journal_name, argv[iarg], BUFSIZ);
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--trace"))
+        {
+            ++ iarg;
+            if (iarg == argc)
             {
-                # ifdef _WIN32
-                sprintf(glob_gau_exe, "%s%s", env_gauss_exedir, "\\g09.exe");
-                # else
-                sprintf(glob_gau_exe, "%s%s", env_gauss_exedir, "/g09");
-                # endif
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
             }
-            if (! access(glob_gau_exe, X_OK))
-                break;
+            strncpy(trace_name, argv[iarg], BUFSIZ);
+            continue;
         }
-        else
-            break;
-        env_gauss_exedir = strtok(NULL, path_splitter);
+        if (! strcmp(argv[iarg], "--supervise"))
+        {
+            calc.is_supervised = true;
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--max-cycles"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (sscanf(argv[iarg], "%u", & calc.max_scf_cycle) != 1)
+            {
+                fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            calc.is_supervised = true;
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--cache"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            strncpy(calc.cache_name, argv[iarg], BUFSIZ);
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--record") || ! strcmp(argv[iarg], "--replay"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            strncpy(strcmp(argv[iarg - 1], "--record") ? calc.replay_dir : calc.record_dir, argv[iarg], BUFSIZ);
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--scratch"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            strncpy(scratch_root, argv[iarg], BUFSIZ);
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--timeout"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (sscanf(argv[iarg], "%u", & calc.job_timeout) != 1 || ! calc.job_timeout)
+            {
+                fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--pin"))
+        {
+            is_pin = true;
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--objective"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (Parse_objective(argv[iarg], & calc.objective))
+            {
+                fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--mem"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (Parse_mem(argv[iarg], & mem_bytes) || ! (mem_bytes > 0.0))
+            {
+                fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            continue;
+        }
+        if (! strcmp(argv[iarg], "--jobs") || ! strcmp(argv[iarg], "--cores"))
+        {
+            ++ iarg;
+            if (iarg == argc)
+            {
+                fprintf(stderr, "Error! Missing argument after \"%s\".\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (sscanf(argv[iarg], "%u", strcmp(argv[iarg - 1], "--jobs") ? & num_core : & num_job) != 1)
+            {
+                fprintf(stderr, "Error! Cannot recognize value \"%s\" after \"%s\".\n", argv[iarg], argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            if (! (strcmp(argv[iarg - 1], "--jobs") ? num_core : num_job))
+            {
+                fprintf(stderr, "Error! Value after \"%s\" must be positive.\n", argv[iarg - 1]);
+                Print_exit_failure();
+            }
+            continue;
+        }
+        fprintf(stderr, "Error! Cannot recognize argument \"%s\".\n", argv[iarg]);
+        Print_exit_failure();
     }
-    if (access(glob_gau_exe, X_OK))
+    if (w_high <= w_low)
     {
-        fprintf(stderr, "Error! Cannot find either g16 or g09 as executable.\n");
+        fprintf(stderr, "Error! higher limit of w (%6.1lg) must be greater than lower limit of w (%6.1lg).\n", w_high, w_low);
         Print_exit_failure();
     }
-
-    /* start preparing input files */
-    temp_ifl = fopen(temp_name, "rt");
-    n_ifl = fopen("N.gjf", "wt");
-    np1_ifl = fopen("Np1.gjf", "wt");
-    nm1_ifl = fopen("Nm1.gjf", "wt");
-    /* link 0 ,route section and a blank line followed */
-    while (fgets(buf, BUFSIZ, temp_ifl))
+    if (* calc.record_dir && * calc.replay_dir)
     {
-        if ((line_end = strstr(buf, "\r\n")))
-            strcpy(line_end, "\n");
-        if (* buf == '#')
-        {
-            * strchr(buf, '\n') = '\0';
-            fprintf(n_ifl, "%s", buf);
-            fprintf(np1_ifl, "%s", buf);
-            fprintf(nm1_ifl, "%s", buf);
-            glob_replace_iop_place = ftell(n_ifl);
-            fprintf(n_ifl, "%s", " IOp(3/107=0000000000,3/108=0000000000)\n");
-            fprintf(np1_ifl, "%s", " IOp(3/107=0000000000,3/108=0000000000)\n");
-            fprintf(nm1_ifl, "%s", " IOp(3/107=0000000000,3/108=0000000000)\n");
-            continue;
-        }
-        fprintf(n_ifl, "%s", buf);
-        fprintf(np1_ifl, "%s", buf);
-        fprintf(nm1_ifl, "%s", buf);
-        if (* buf == '\n')
-            break;
+        fprintf(stderr, "Error! \"--record\" cannot be used with \"--replay\".\n");
+        Print_exit_failure();
     }
-    /* title and a blank line followed */
-    while (fgets(buf, BUFSIZ, temp_ifl))
+    if (calc.is_link1 && calc.is_chain_guess)
     {
-        if ((line_end = strstr(buf, "\r\n")))
-            strcpy(line_end, "\n");
-        fprintf(n_ifl, "%s", buf);
-        fprintf(np1_ifl, "%s", buf);
-        fprintf(nm1_ifl, "%s", buf);
-        if (* buf == '\n')
-            break;
+        fprintf(stderr, "Error! \"--link1\" cannot be used with \"--read-guess\".\n");
+        Print_exit_failure();
     }
-    /* charge and multiplicity */
-    fgets(buf, BUFSIZ, temp_ifl);
-    if ((line_end = strstr(buf, "\r\n")))
-        strcpy(line_end, "\n");
-    if (sscanf(buf, "%d %u", & charge_n, & multi_n) != 2)
+    if (* calc.record_dir && Make_record_dir(calc.record_dir))
+        Print_exit_failure();
+    if (* scratch_root && Make_scratch_dir(calc.scratch_dir, scratch_root))
+        Print_exit_failure();
+
+    if (! * calc.replay_dir && Find_gau_exe(calc.gau_exe))
+        Print_exit_failure();
+
+    if (mem_bytes > 0.0 && ! is_pin)
     {
-        fprintf(stderr, "Error! Cannot read the charge and multiplicity from template file.\n");
-        Close_file(temp_ifl);
-        Close_file(n_ifl);
-        Close_file(np1_ifl);
-        Close_file(nm1_ifl);
-        remove("N.gjf");
-        remove("Np1.gjf");
-        remove("Nm1.gjf");
+        fprintf(stderr, "Error! \"--mem\" can only be used with \"--pin\".\n");
         Print_exit_failure();
     }
-    if (! multi_n)
+    memset(& topo, 0, sizeof(Node_topology));
+    if (is_pin)
     {
-        fprintf(stderr, "Error! Multiplicity cannot be zero, but it is zero in template file for N state.\n");
-        Close_file(temp_ifl);
-        Close_file(n_ifl);
-        Close_file(np1_ifl);
-        Close_file(nm1_ifl);
-        remove("N.gjf");
-        remove("Np1.gjf");
-        remove("Nm1.gjf");
+        if (Read_node_topology(& topo))
+            Print_exit_failure();
+        Count_node_domains(topo.cpus, topo.num_cpu, & num_node, & num_l3);
+    }
+
+    /* read the template, input files are generated from it for each w */
+    if (Read_template(& calc.temp, temp_name, multi_np1, multi_nm1))
         Print_exit_failure();
+    if (is_pin)
+    {
+        calc.temp.topo = & topo;
+        calc.temp.mem_bytes = mem_bytes;
     }
-    charge_np1 = charge_n - 1;
-    charge_nm1 = charge_n + 1;
-    if (! multi_np1)
-        multi_np1 = multi_n + 1;
-    else
+
+    /* w evaluated before by a run killed halfway */
+    if (Open_journal(& journal, journal_name, Get_template_hash(& calc.temp, calc.objective), is_resume))
+        Print_exit_failure();
+    calc.journal = & journal;
+    if (* trace_name)
     {
-        if (! ((multi_np1 - multi_n) & 1))
-        {
-            fprintf(stderr, "Error! Multiplicity of N+1 state and N state must have different parity.\n");
-            Close_file(temp_ifl);
-            Close_file(n_ifl);
-            Close_file(np1_ifl);
-            Close_file(nm1_ifl);
-            remove("N.gjf");
-            remove("Np1.gjf");
-            remove("Nm1.gjf");
+        if (Open_trace(& trace, trace_name))
             Print_exit_failure();
-        }
+        calc.trace = & trace;
     }
-    if (! multi_nm1)
-        multi_nm1 = multi_n + 1;
-    else
+
+    /* share the processors among the jobs running at the same time */
+    if (num_core)
     {
-        if (! ((multi_nm1 - multi_n) & 1))
-        {
-            fprintf(stderr, "Error! Multiplicity of N-1 state and N state must have different parity.\n");
-            Close_file(temp_ifl);
-            Close_file(n_ifl);
-            Close_file(np1_ifl);
-            Close_file(nm1_ifl);
-            remove("N.gjf");
-            remove("Np1.gjf");
-            remove("Nm1.gjf");
-            Print_exit_failure();
-        }
+        calc.temp.num_core = num_core;
+        if (! num_job)
+            num_job = num_core / Count_template_cores(& calc.temp);
     }
-    fprintf(n_ifl, "%d %u\n", charge_n, multi_n);
-    fprintf(np1_ifl, "%d %u\n", charge_np1, multi_np1);
-    fprintf(nm1_ifl, "%d %u\n", charge_nm1, multi_nm1);
-    /* atom coordinates and others */
-    while (fgets(buf, BUFSIZ, temp_ifl))
+    else
+        num_core = Count_template_cores(& calc.temp);
+    if (! num_job)
+        num_job = 1u;
+
+    /* the w grid, each (w, state) pair is a task */
+    for (w_current = w_low; w_current <= w_high + 1E-5; w_current += w_stepsize)
+        ++ num_point;
+    ws = (double *)malloc(num_point * sizeof(double));
+    points = (Dft_w_point *)calloc(num_point, sizeof(Dft_w_point));
+    nums_state_done = (unsigned int *)calloc(num_point, sizeof(unsigned int));
+    job_state_masks = (unsigned int *)calloc(num_point, sizeof(unsigned int));
+    time_point_starts = (double *)calloc(num_point, sizeof(double));
+    is_replayeds = (bool *)calloc(num_point, sizeof(bool));
+    cpu_times = (double *)calloc(num_point, sizeof(double));
+    max_rss_kbs = (long *)calloc(num_point, sizeof(long));
+    streams = (Gau_log_stream *)calloc(num_job, sizeof(Gau_log_stream));
+    if (! ws || ! points || ! nums_state_done || ! job_state_masks || ! time_point_starts || ! is_replayeds || \
+        ! cpu_times || ! max_rss_kbs || ! streams || Init_slots(& slots, num_job))
     {
-        if ((line_end = strstr(buf, "\r\n")))
-            strcpy(line_end, "\n");
-        fprintf(n_ifl, "%s", buf);
-        fprintf(np1_ifl, "%s", buf);
-        fprintf(nm1_ifl, "%s", buf);
+        fprintf(stderr, "Error! Cannot allocate memory for %u points.\n", num_point);
+        Print_exit_failure();
     }
-    /* close these files */
-    Close_file(temp_ifl);
-    Close_file(n_ifl);
-    Close_file(np1_ifl);
-    Close_file(nm1_ifl);
+    slots.timeout_s = calc.job_timeout;
+    ipoint = 0u;
+    for (w_current = w_low; ipoint < num_point; w_current += w_stepsize)
+        ws[ipoint ++] = w_current;
 
     /* show title */
     printf("Scan w (literally omega) in long-range correction functional of DFT.\n");
     printf("Parameters: w_low = %6.4lf, w_high = %6.4lf, w_stepsize = %6.4lf\n", \
         w_low, w_high, w_stepsize);
-    printf("            Charges for N, N+1 and N-1 states: %d %d %d\n", charge_n, charge_np1, charge_nm1);
-    printf("            Multiplicities for N, N+1 and N-1 states: %u %u %u\n", multi_n, multi_np1, multi_nm1);
+    printf("            Charges for N, N+1 and N-1 states: %d %d %d\n", \
+        calc.temp.charges[STATE_N], calc.temp.charges[STATE_NP1], calc.temp.charges[STATE_NM1]);
+    printf("            Multiplicities for N, N+1 and N-1 states: %u %u %u\n", \
+        calc.temp.multis[STATE_N], calc.temp.multis[STATE_NP1], calc.temp.multis[STATE_NM1]);
+    printf("            Number of points: %u, at most %u jobs at the same time on %u processors\n", \
+        num_point, num_job, num_core);
+    if (* calc.cache_name)
+        printf("Will use cache file \"%s\".\n", calc.cache_name);
+    if (* calc.record_dir)
+        printf("Will keep the input and output of every job in \"%s\".\n", calc.record_dir);
+    if (* calc.replay_dir)
+        printf("Will take the outputs in \"%s\" instead of running Gaussian.\n", calc.replay_dir);
+    if (calc.job_timeout)
+        printf("Will kill a Gaussian job running longer than %u s.\n", calc.job_timeout);
+    if (* calc.scratch_dir)
+        printf("Will run every job in a directory of its own in \"%s\".\n", calc.scratch_dir);
+    if (is_pin)
+        printf("Will pin the jobs to %u processors in %u NUMA nodes and %u L3 caches.\n", topo.num_cpu, num_node, \
+            num_l3);
+    if (calc.is_chain_guess)
+        printf("Will read SCF guess from the checkpoint file of the nearest w computed.\n");
+    if (calc.is_link1)
+        printf("Will run the states of a w in one job chained by \"--Link1--\".\n");
+    if (calc.objective == OBJECTIVE_J_N)
+        printf("Will scan J^2 of J_N alone, with N and N-1 states only.\n");
+    if (calc.objective == OBJECTIVE_J_NP1)
+        printf("Will scan J^2 of J_N+1 alone, with N and N+1 states only.\n");
+    if (calc.is_supervised)
+        printf("Will follow the outputs and kill the jobs bound to fail.\n");
+    if (is_resume)
+        printf("Will resume from journal \"%s\", %u w found there.\n", journal_name, journal.num_record);
+    else
+        printf("Will record every w evaluated in journal \"%s\".\n", journal_name);
+    if (calc.trace)
+        printf("Will trace every job and every point in \"%s\".\n", trace_name);
     if (is_verbose)
         printf("Will print verbosely.\n");
     printf("\n");
     time_start = time(NULL);
 
-    for (w_current = w_low; w_current <= w_high + 1E-5; w_current += w_stepsize)
+    for (;;)
     {
-        ++ num_point;
-        printf("Point %3u: w = %6.4lf", num_point, w_current);
-        fflush(stdout);
-        time_step_start = time(NULL);
-        J_squared_current = Calc_J_squared_from_w(w_current, & info_e_HOMO_n, & info_e_HOMO_np1, \
-            & info_E_n, & info_E_np1, & info_E_nm1);
-        time_step_stop = time(NULL);
-        printf(", J^2 = %10.8lf. Time elapsed: %d s.\n", J_squared_current, \
-            (int)difftime(time_step_stop, time_step_start));
-        if (is_verbose)
-            printf("    E_N = %.6lf, E_N+1 = %.6lf, E_N-1 = %.6lf, E_HOMO_N = %.5lf, E_HOMO_N+1 = %.5lf\n", \
-                info_E_n, info_E_np1, info_E_nm1, info_e_HOMO_n, info_e_HOMO_np1);
-        if (J_squared_current < J_squared_min)
+        /* fill the free slots with the next tasks, in the order of w */
+        while (! is_failed && next_task < NUM_STATE * num_point && (islot = Find_free_slot(& slots)) >= 0)
+        {
+            ipoint = next_task / NUM_STATE;
+            istate = next_task % NUM_STATE;
+            if (! istate)
+            {
+                time_point_starts[ipoint] = Get_monotonic_time();
+                points[ipoint].w = ws[ipoint];
+                /* evaluated before the run was killed */
+                if (Look_up_point(& calc, ws[ipoint], & points[ipoint]))
+                {
+                    is_replayeds[ipoint] = true;
+                    nums_state_done[ipoint] = NUM_STATE;
+                    next_task += NUM_STATE;
+                    continue;
+                }
+            }
+            if (calc.is_link1)
+            {
+                /* the states of the point in the objective not computed before, all in the job of the first */
+                next_task += NUM_STATE;
+                for (istate = 0u; istate < NUM_STATE; ++ istate)
+                {
+                    if (! (calc.objective & (1u << istate)) || \
+                        Look_up_state(& calc, istate, ws[ipoint], & points[ipoint]))
+                        ++ nums_state_done[ipoint];
+                    else
+                        job_state_masks[ipoint] |= 1u << istate;
+                }
+                state_mask = job_state_masks[ipoint];
+                if (! state_mask)
+                    continue;
+                for (istate = 0u; ! (state_mask & (1u << istate)); ++ istate)
+                    ;
+            }
+            else
+            {
+                ++ next_task;
+                /* not in the objective, or computed before */
+                if (! (calc.objective & (1u << istate)) || Look_up_state(& calc, istate, ws[ipoint], & points[ipoint]))
+                {
+                    ++ nums_state_done[ipoint];
+                    continue;
+                }
+                state_mask = 1u << istate;
+            }
+            Get_w_tag(tag, ws[ipoint]);
+            Get_job_file_name(out_name, & calc, istate, tag, ".out");
+            Init_gau_log_stream(& streams[islot], out_name, calc.max_scf_cycle);
+            if (Prepare_link1_job(& calc, state_mask, ws[ipoint], tag, num_job, (unsigned int)islot, & command) || \
+                Start_in_slot(& slots, (unsigned int)islot, ipoint * NUM_STATE + istate, & command))
+            {
+                is_failed = true;
+                break;
+            }
+        }
+        /* report the points finished, in the order of w */
+        while (! is_failed && next_point_print < num_point && nums_state_done[next_point_print] == NUM_STATE)
+        {
+            ipoint = next_point_print;
+            Get_w_tag(tag, ws[ipoint]);
+            Remove_state_files(& calc, tag);
+            Calc_J_of_point(& points[ipoint], calc.objective);
+            time_step_stop = Get_monotonic_time();
+            if (! is_replayeds[ipoint])
+            {
+                points[ipoint].seconds = time_step_stop - time_point_starts[ipoint];
+                Record_point(& calc, & points[ipoint], points[ipoint].seconds);
+            }
+            Trace_step(calc.trace, calc.file_prefix, ipoint + 1u, ws[ipoint], points[ipoint].J_squared, NULL, "scan", \
+                points[ipoint].seconds);
+            printf("Point %3u: w = %6.4lf, J^2 = %10.8lf. Time elapsed: %d s.\n", ipoint + 1u, ws[ipoint], \
+                points[ipoint].J_squared, (int)(time_step_stop - time_point_starts[ipoint]));
+            if (is_verbose)
+                printf("    E_N = %.6lf, E_N+1 = %.6lf, E_N-1 = %.6lf, E_HOMO_N = %.5lf, E_HOMO_N+1 = %.5lf\n", \
+                    points[ipoint].E[STATE_N], points[ipoint].E[STATE_NP1], points[ipoint].E[STATE_NM1], \
+                    points[ipoint].e_HOMO[STATE_N], points[ipoint].e_HOMO[STATE_NP1]);
+            if (is_verbose && ! is_replayeds[ipoint])
+                printf("    CPU time of jobs = %.1lf s, peak memory of a job = %.1lf MB\n", cpu_times[ipoint], \
+                    (double)max_rss_kbs[ipoint] / 1024.0);
+            fflush(stdout);
+            if (points[ipoint].J_squared < J_squared_min)
+            {
+                J_squared_min = points[ipoint].J_squared;
+                w_when_J_squared_min = ws[ipoint];
+            }
+            ++ next_point_print;
+        }
+        /* nothing is running any more, either all done or failed */
+        if ((islot = Watch_any_slot(& calc, & slots, streams, & itask, & exit_status)) < 0)
+            break;
+        ipoint = itask / NUM_STATE;
+        istate = itask % NUM_STATE;
+        cpu_times[ipoint] += slots.jobs[islot].cpu_time;
+        if (slots.jobs[islot].max_rss_kb > max_rss_kbs[ipoint])
+            max_rss_kbs[ipoint] = slots.jobs[islot].max_rss_kb;
+        state_mask = calc.is_link1 ? job_state_masks[ipoint] : 1u << istate;
+        Report_link1_job(& calc, state_mask, ws[ipoint], & slots.jobs[islot], \
+            ! exit_status && ! (is_failed && calc.is_supervised));
+        /* the jobs killed after a failure, nothing to say about them */
+        if (is_failed && calc.is_supervised)
+            continue;
+        if (exit_status)
         {
-            J_squared_min = J_squared_current;
-            w_when_J_squared_min = w_current;
+            Get_states_label(label, state_mask);
+            fprintf(stderr, "Error! Gaussian job for %s state%s at w = %6.4lf failed with exit status %d.\n", \
+                label, Count_states(state_mask) > 1u ? "s" : "", ws[ipoint], exit_status);
+            Get_w_tag(tag, ws[ipoint]);
+            Keep_failed_output(& calc, istate, tag);
+            is_failed = true;
         }
+        else
+        {
+            Get_w_tag(tag, ws[ipoint]);
+            if (Finish_link1_job(& calc, state_mask, ws[ipoint], tag, & slots.jobs[islot], \
+                calc.is_supervised ? & streams[islot] : NULL, & points[ipoint]))
+                is_failed = true;
+            else
+                nums_state_done[ipoint] += Count_states(state_mask);
+        }
+        /* the scan stops anyway, do not let the other jobs run to their ends */
+        if (is_failed && calc.is_supervised)
+            Kill_all_slots(& slots);
+    }
+    Free_slots(& slots);
+    free(streams);
+    if (is_failed || next_point_print < num_point)
+    {
+        fprintf(stderr, "Check your template file and temporary Gaussian output files.\n");
+        Print_exit_failure();
     }
     printf("\n");
     printf("Minimum value of J^2 encountered when w is around %6.4lf.\n", w_when_J_squared_min);
     printf("You can use \"IOp(3/107=%05u00000,3/108=%05u00000)\" in your further Gaussian input files.\n", \
-        (unsigned int)(w_when_J_squared_min * 1E4), (unsigned int)(w_when_J_squared_min * 1E4));
+        W_to_iop(w_when_J_squared_min), W_to_iop(w_when_J_squared_min));
     printf("\n");
 
     /* end of task */
     time_stop = time(NULL);
     printf("Total time elapsed: %d s.\n", (int)difftime(time_stop, time_start));
     printf("\n");
-    remove("N.gjf");
-    remove("N.out");
-    remove("Np1.gjf");
-    remove("Np1.out");
-    remove("Nm1.gjf");
-    remove("Nm1.out");
+    Remove_chk_files(& calc);
+    Close_journal(& journal);
+    if (calc.trace)
+        Close_trace(& trace);
+    Free_template(& calc.temp);
+    Free_node_topology(& topo);
+    free(ws);
+    free(points);
+    free(nums_state_done);
+    free(job_state_masks);
+    free(time_point_starts);
+    free(is_replayeds);
+    free(cpu_times);
+    free(max_rss_kbs);
 
     /* pause program on Windows is no command arguments are provided. */
     # ifdef _WIN32
@@ -504,190 +807,3 @@ void Pause_program(char const *prompt)
     return;
 }
 
-void Get_J_and_J_squared(double *J_ptr, double *J_squared_ptr)
-{
-    double J_n = 0.0, J_np1 = 0.0;
-    double E_n = 0.0, E_np1 = 0.0, E_nm1 = 0.0;
-    double e_HOMO_n = 0.0, e_HOMO_np1 = 0.0;
-    FILE *n_ofl = NULL, *np1_ofl = NULL, *nm1_ofl = NULL;
-    long last_line_pos = 0l, this_line_pos = 0l;
-    char last_value_str[BUFSIZ + 1] = "";
-    char buf[BUFSIZ + 1] = "";
-    char *tok = NULL;
-
-    /* open files */
-    n_ofl = fopen("N.out", "rt");
-    if (! n_ofl)
-    {
-        fprintf(stderr, "Error! Cannot open \"N.out\" for reading! Check your Gaussian settings.");
-        Print_exit_failure();
-    }
-    np1_ofl = fopen("Np1.out", "rt");
-    if (! np1_ofl)
-    {
-        fprintf(stderr, "Error! Cannot open \"Np1.out\" for reading! Check your Gaussian settings.");
-        Close_file(n_ofl);
-        Print_exit_failure();
-    }
-    nm1_ofl = fopen("Nm1.out", "rt");
-    if (! nm1_ofl)
-    {
-        fprintf(stderr, "Error! Cannot open \"Nm1.out\" for reading! Check your Gaussian settings.");
-        Close_file(n_ofl);
-        Close_file(np1_ofl);
-        Print_exit_failure();
-    }
-
-    /* electron energy */
-    /* electron energy of N */
-    while (fgets(buf, BUFSIZ, n_ofl))
-    {
-        if (strstr(buf, "SCF Done"))
-            break;
-    }
-    if (sscanf(strchr(buf, '=') + 1, "%lg", & E_n) != 1)
-    {
-        fprintf(stderr, "Error! Cannot read electron energy of state N! Check your Gaussian output files.");
-        Close_file(n_ofl);
-        Close_file(np1_ofl);
-        Close_file(nm1_ofl);
-    }
-    /* electron energy of N+1 */
-    while (fgets(buf, BUFSIZ, np1_ofl))
-    {
-        if (strstr(buf, "SCF Done"))
-            break;
-    }
-    if (sscanf(strchr(buf, '=') + 1, "%lg", & E_np1) != 1)
-    {
-        fprintf(stderr, "Error! Cannot read electron energy of state N+1! Check your Gaussian output files.");
-        Close_file(n_ofl);
-        Close_file(np1_ofl);
-        Close_file(nm1_ofl);
-    }
-    /* electron energy of N-1 */
-    while (fgets(buf, BUFSIZ, nm1_ofl))
-    {
-        if (strstr(buf, "SCF Done"))
-            break;
-    }
-    if (sscanf(strchr(buf, '=') + 1, "%lg", & E_nm1) != 1)
-    {
-        fprintf(stderr, "Error! Cannot read electron energy of state N! Check your Gaussian output files.");
-        Close_file(n_ofl);
-        Close_file(np1_ofl);
-        Close_file(nm1_ofl);
-    }
-
-    /* HOMO */
-    /* there should be at least one line between, so we do not care last_line_pos in the first loop. */
-    /* HOMO of N */
-    for (;;)
-    {
-        this_line_pos = ftell(n_ofl);
-        if (! fgets(buf, BUFSIZ, n_ofl) || strstr(buf, "Alpha virt."))
-            break;
-        last_line_pos = this_line_pos;
-    }
-    fseek(n_ofl, last_line_pos, SEEK_SET);
-    fgets(buf, BUFSIZ, n_ofl);
-    /* the first string in buf should always be useless. */
-    tok = strtok(buf, " \n");
-    while ((tok = strtok(NULL, " \n")))
-        strcpy(last_value_str, tok);
-    if (sscanf(last_value_str, "%lg", & e_HOMO_n) != 1)
-    {
-        fprintf(stderr, "Error! Cannot read HOMO energy of state N! Check your Gaussian output files.");
-        Close_file(n_ofl);
-        Close_file(np1_ofl);
-        Close_file(nm1_ofl);
-    }
-    last_line_pos = 0l;
-    /* HOMO of N+1 */
-    for (;;)
-    {
-        this_line_pos = ftell(np1_ofl);
-        if (! fgets(buf, BUFSIZ, np1_ofl) || strstr(buf, "Alpha virt."))
-            break;
-        last_line_pos = this_line_pos;
-    }
-    fseek(np1_ofl, last_line_pos, SEEK_SET);
-    fgets(buf, BUFSIZ, np1_ofl);
-    tok = strtok(buf, " \n");
-    while ((tok = strtok(NULL, " \n")))
-        strcpy(last_value_str, tok);
-    if (sscanf(last_value_str, "%lg", & e_HOMO_np1) != 1)
-    {
-        fprintf(stderr, "Error! Cannot read HOMO energy of state N+1! Check your Gaussian output files.");
-        Close_file(n_ofl);
-        Close_file(np1_ofl);
-        Close_file(nm1_ofl);
-    }
-    
-    /* calculates J and J^2 */
-    J_n = fabs(e_HOMO_n + E_nm1 - E_n);
-    J_np1 = fabs(e_HOMO_np1 + E_n - E_np1);
-    * J_ptr = J_n + J_np1;
-    * J_squared_ptr = J_n * J_n + J_np1 * J_np1;
-
-    /* close files */
-    Close_file(n_ofl);
-    Close_file(np1_ofl);
-    Close_file(nm1_ofl);
-
-    return;
-}
-
-double Calc_J_squared_from_w(double w, double *info_e_HOMO_n_ptr, double *info_e_HOMO_np1_ptr, \
-    double *info_E_n_ptr, double *info_E_np1_ptr, double *info_E_nm1_ptr)
-{
-    char sys_command[BUFSIZ + 1] = "";
-    FILE *n_ifl = NULL, *np1_ifl = NULL, *nm1_ifl = NULL;
-    double J = 0.0, J_squared = 0.0;
-    char iop_str[] = " IOp(3/107=0000000000,3/108=0000000000)\n"; /* just occupy the position here */
-
-    /* prepare files */
-    n_ifl = fopen("N.gjf", "r+t");
-    np1_ifl = fopen("Np1.gjf", "r+t");
-    nm1_ifl = fopen("Nm1.gjf", "r+t");
-    fseek(n_ifl, glob_replace_iop_place, SEEK_SET);
-    fseek(np1_ifl, glob_replace_iop_place, SEEK_SET);
-    fseek(nm1_ifl, glob_replace_iop_place, SEEK_SET);
-    sprintf(iop_str, " IOp(3/107=%05u00000,3/108=%05u00000)\n", \
-        (unsigned int)(w * 1E4), (unsigned int)(w * 1E4));
-    fprintf(n_ifl, "%s", iop_str);
-    fprintf(np1_ifl, "%s", iop_str);
-    fprintf(nm1_ifl, "%s", iop_str);
-    Close_file(n_ifl);
-    Close_file(np1_ifl);
-    Close_file(nm1_ifl);
-
-    /* Invoke Gaussian */
-    sprintf(sys_command, "%s N.gjf N.out", glob_gau_exe);
-    if (system(sys_command))
-    {
-        fprintf(stderr, "Error! Gaussian job for N state failed.\n");
-        fprintf(stderr, "Check your template file and temporary Gaussian output files.\n");
-        Print_exit_failure();
-    }
-    sprintf(sys_command, "%s Np1.gjf Np1.out", glob_gau_exe);
-    if (system(sys_command))
-    {
-        fprintf(stderr, "Error! Gaussian job for N+1 state failed.\n");
-        fprintf(stderr, "Check your template file and temporary Gaussian output files.\n");
-        Print_exit_failure();
-    }
-    sprintf(sys_command, "%s Nm1.gjf Nm1.out", glob_gau_exe);
-    if (system(sys_command))
-    {
-        fprintf(stderr, "Error! Gaussian job for N-1 state failed.\n");
-        fprintf(stderr, "Check your template file and temporary Gaussian output files.\n");
-        Print_exit_failure();
-    }
-
-    /* Calculates J^2 and J */
-    Get_J_and_J_squared(& J, & J_squared);
-
-    return J_squared;
-}
-